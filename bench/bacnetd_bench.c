@@ -0,0 +1,643 @@
+/*
+ * Request handling benchmark.
+ *
+ * Provisions a gateway with routed devices and analog inputs through the
+ * port call handlers, then feeds pre-encoded ReadProperty, ReadProperty-
+ * Multiple (ALL), WriteProperty and Who-Is NPDUs straight into
+ * routing_npdu_handler. Replies are discarded by the stub datalink.
+ *
+ * Every device and object count pair runs in a forked child, so state and
+ * RSS start fresh. Results are printed as a table and written as JSON.
+ *
+ * usage: bacnetd_bench [-o results.json] [-n operations]
+ *                      [-d device counts] [-p object counts]
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <bacnet/bacapp.h>
+#include <bacnet/basic/services.h>
+#include <bacnet/basic/object/device.h>
+#include <bacnet/datalink/datalink.h>
+#include <bacnet/npdu.h>
+#include <bacnet/rp.h>
+#include <bacnet/rpm.h>
+#include <bacnet/whois.h>
+#include <bacnet/wp.h>
+
+#include "bacnet.h"
+#include "log.h"
+#include "timer.h"
+#include "bench_calls.h"
+#include "stub_datalink.h"
+
+#define BENCH_NETWORK_ID     1000
+#define GATEWAY_INSTANCE     100000
+#define COMMAND_INSTANCE     1
+#define DEFAULT_OPERATIONS   20000
+#define REQUEST_POOL_SIZE    1024
+#define REQUEST_MAX_LEN      64
+#define MAX_SWEEP            16
+#define MAX_RESULT_LEN       4096
+
+typedef enum {
+  WORKLOAD_READ_PROPERTY,
+  WORKLOAD_READ_PROPERTY_MULTIPLE,
+  WORKLOAD_WRITE_PROPERTY,
+  WORKLOAD_WHO_IS,
+  WORKLOAD_COUNT,
+} workload_t;
+
+static const char* WORKLOAD_NAMES[WORKLOAD_COUNT] = {
+  "read_property",
+  "read_property_multiple_all",
+  "write_property",
+  "who_is",
+};
+
+typedef struct {
+  uint8_t  pdu[REQUEST_MAX_LEN];
+  uint16_t pdu_len;
+  uint32_t device_index;
+} request_t;
+
+typedef struct {
+  size_t   operations;
+  double   ops_per_sec;
+  uint64_t p50_ns;
+  uint64_t p99_ns;
+  uint64_t replies;
+} workload_result_t;
+
+static const size_t DEFAULT_DEVICE_COUNTS[] = { 10, 32, 100, 1000, 10000 };
+static const size_t DEFAULT_OBJECT_COUNTS[] = { 10, 1000, 10000, 100000 };
+
+static request_t requests[REQUEST_POOL_SIZE] = { 0 };
+
+static uint64_t now_ns(void)
+{
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static size_t rss_kb(void)
+{
+  long  pages    = 0;
+  long  resident = 0;
+  FILE* statm    = fopen("/proc/self/statm", "r");
+
+  if (statm == NULL)
+    return 0;
+
+  if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+    resident = 0;
+
+  fclose(statm);
+
+  return (size_t)resident * (size_t)(sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static size_t max_rss_kb(void)
+{
+  struct rusage usage = { 0 };
+  getrusage(RUSAGE_SELF, &usage);
+
+  return (size_t)usage.ru_maxrss;
+}
+
+static uint32_t device_instance(size_t device_index)
+{
+  return GATEWAY_INSTANCE + (uint32_t)device_index;
+}
+
+static int complete_command(size_t device_index)
+{
+  return bench_call_type(
+    CALL_SET_ROUTED_COMMAND_STATUS,
+    device_instance(device_index),
+    COMMAND_INSTANCE
+  );
+}
+
+// object k is analog input instance k of device k % device_count
+static int provision(size_t device_count, size_t object_count)
+{
+  for (size_t d = 0; d < device_count; d++) {
+    bacnet_call_type_t type =
+      d == 0 ? CALL_CREATE_GATEWAY : CALL_CREATE_ROUTED_DEVICE;
+
+    bool is_failed =
+         bench_call_type(type, device_instance(d), 0)
+      || bench_call_type(
+           CALL_CREATE_ROUTED_COMMAND,
+           device_instance(d),
+           COMMAND_INSTANCE
+         );
+
+    if (is_failed)
+      return -1;
+  }
+
+  for (size_t k = 0; k < object_count; k++) {
+    bool is_failed =
+      bench_call_type(
+        CALL_CREATE_ROUTED_ANALOG_INPUT,
+        device_instance(k % device_count),
+        (uint32_t)k
+      ) != 0;
+
+    if (is_failed)
+      return -1;
+  }
+
+  return 0;
+}
+
+static int encode_request(
+  request_t* request,
+  size_t device_index,
+  bool is_confirmed,
+  uint8_t* apdu,
+  int apdu_len
+) {
+  BACNET_ADDRESS   dest      = { 0 };
+  BACNET_ADDRESS   src       = { 0 };
+  BACNET_NPDU_DATA npdu_data = { 0 };
+  uint8_t          npdu[MAX_NPDU] = { 0 };
+
+  // the gateway is addressed locally, routed devices by their virtual MAC
+  if (device_index > 0) {
+    dest.net = BENCH_NETWORK_ID;
+    dest.len = 3;
+    encode_unsigned24(&dest.adr[0], device_instance(device_index));
+  }
+
+  npdu_encode_npdu_data(&npdu_data, is_confirmed, MESSAGE_PRIORITY_NORMAL);
+  int npdu_len = npdu_encode_pdu(&npdu[0], &dest, &src, &npdu_data);
+
+  if (apdu_len <= 0 || npdu_len + apdu_len > REQUEST_MAX_LEN)
+    return -1;
+
+  memcpy(&request->pdu[0], &npdu[0], npdu_len);
+  memcpy(&request->pdu[npdu_len], apdu, apdu_len);
+
+  request->pdu_len      = (uint16_t)(npdu_len + apdu_len);
+  request->device_index = (uint32_t)device_index;
+
+  return 0;
+}
+
+static int encode_workload(
+  workload_t workload,
+  size_t device_count,
+  size_t object_count
+) {
+  uint8_t apdu[MAX_APDU] = { 0 };
+
+  for (size_t i = 0; i < REQUEST_POOL_SIZE; i++) {
+    uint8_t  invoke_id = (uint8_t)i;
+    uint32_t object    = (uint32_t)(rand() % object_count);
+    size_t   device    = object % device_count;
+    int      apdu_len  = 0;
+
+    switch (workload) {
+      case WORKLOAD_READ_PROPERTY: {
+        BACNET_READ_PROPERTY_DATA data = {
+          .object_type     = OBJECT_ANALOG_INPUT,
+          .object_instance = object,
+          .object_property = PROP_PRESENT_VALUE,
+          .array_index     = BACNET_ARRAY_ALL,
+        };
+
+        apdu_len = rp_encode_apdu(&apdu[0], invoke_id, &data);
+        break;
+      }
+
+      case WORKLOAD_READ_PROPERTY_MULTIPLE: {
+        BACNET_PROPERTY_REFERENCE property = {
+          .propertyIdentifier = PROP_ALL,
+          .propertyArrayIndex = BACNET_ARRAY_ALL,
+          .next               = NULL,
+        };
+
+        BACNET_READ_ACCESS_DATA access = {
+          .object_type      = OBJECT_ANALOG_INPUT,
+          .object_instance  = object,
+          .listOfProperties = &property,
+          .next             = NULL,
+        };
+
+        apdu_len =
+          rpm_encode_apdu(&apdu[0], sizeof(apdu), invoke_id, &access);
+        break;
+      }
+
+      case WORKLOAD_WRITE_PROPERTY: {
+        BACNET_WRITE_PROPERTY_DATA    data  = { 0 };
+        BACNET_APPLICATION_DATA_VALUE value = { 0 };
+
+        device = (size_t)rand() % device_count;
+
+        value.tag                = BACNET_APPLICATION_TAG_UNSIGNED_INT;
+        value.type.Unsigned_Int  = 1;
+        data.object_type         = OBJECT_COMMAND;
+        data.object_instance     = COMMAND_INSTANCE;
+        data.object_property     = PROP_PRESENT_VALUE;
+        data.array_index         = BACNET_ARRAY_ALL;
+        data.priority            = BACNET_NO_PRIORITY;
+        data.application_data_len =
+          bacapp_encode_application_data(&data.application_data[0], &value);
+
+        apdu_len = wp_encode_apdu(&apdu[0], invoke_id, &data);
+        break;
+      }
+
+      case WORKLOAD_WHO_IS: {
+        uint32_t instance = device_instance((size_t)rand() % device_count);
+
+        // broadcast on the local network, answered for every routed device
+        device   = 0;
+        apdu_len = whois_encode_apdu(&apdu[0], instance, instance);
+        break;
+      }
+
+      default:
+        return -1;
+    }
+
+    bool is_confirmed = workload != WORKLOAD_WHO_IS;
+
+    if (encode_request(&requests[i], device, is_confirmed, apdu, apdu_len))
+      return -1;
+  }
+
+  return 0;
+}
+
+static int compare_u64(const void* a, const void* b)
+{
+  uint64_t left  = *(const uint64_t*)a;
+  uint64_t right = *(const uint64_t*)b;
+
+  return (left > right) - (left < right);
+}
+
+static int run_workload(
+  workload_t workload,
+  size_t device_count,
+  size_t object_count,
+  size_t operations,
+  workload_result_t* result
+) {
+  int            network_ids[2] = { BENCH_NETWORK_ID, -1 };
+  BACNET_ADDRESS src            = { 0 };
+  uint64_t*      latencies      = calloc(operations, sizeof(uint64_t));
+  uint64_t       total_ns       = 0;
+
+  if (latencies == NULL)
+    return -1;
+
+  if (encode_workload(workload, device_count, object_count)) {
+    free(latencies);
+    return -1;
+  }
+
+  // a client at 127.0.0.1:47808 on the local network
+  src.mac_len = 6;
+  src.mac[0]  = 127;
+  src.mac[3]  = 1;
+  src.mac[4]  = 0xBA;
+  src.mac[5]  = 0xC0;
+
+  stub_datalink_reset();
+
+  for (size_t i = 0; i < operations; i++) {
+    request_t* request = &requests[i % REQUEST_POOL_SIZE];
+    uint8_t    pdu[REQUEST_MAX_LEN];
+
+    // the handlers may decode in place, so each request starts from a copy
+    memcpy(&pdu[0], &request->pdu[0], request->pdu_len);
+
+    uint64_t started_at = now_ns();
+    routing_npdu_handler(&src, network_ids, &pdu[0], request->pdu_len);
+    latencies[i] = now_ns() - started_at;
+    total_ns += latencies[i];
+
+    // untimed upkeep so every write finds the command idle again
+    if (workload == WORKLOAD_WRITE_PROPERTY)
+      complete_command(request->device_index);
+
+    timer_run_expired();
+  }
+
+  stub_datalink_stats_t datalink = { 0 };
+  stub_datalink_get_stats(&datalink);
+
+  qsort(latencies, operations, sizeof(uint64_t), compare_u64);
+
+  result->operations  = operations;
+  result->ops_per_sec = total_ns ? operations * 1e9 / total_ns : 0;
+  result->p50_ns      = latencies[operations * 50 / 100];
+  result->p99_ns      = latencies[operations * 99 / 100];
+  result->replies     = datalink.sent;
+
+  free(latencies);
+
+  return 0;
+}
+
+static int run_config(
+  size_t device_count,
+  size_t object_count,
+  size_t operations,
+  char* json,
+  size_t json_size
+) {
+  workload_result_t results[WORKLOAD_COUNT] = { 0 };
+
+  log_set_level(ERROR);
+  address_init();
+  bacnet_init_service_handlers();
+
+  uint64_t started_at = now_ns();
+
+  if (provision(device_count, object_count)) {
+    fprintf(stderr, "failed to provision %zu devices\n", device_count);
+    return -1;
+  }
+
+  double provision_ms = (now_ns() - started_at) / 1e6;
+  size_t provisioned_rss_kb = rss_kb();
+
+  for (int w = 0; w < WORKLOAD_COUNT; w++) {
+    if (run_workload(w, device_count, object_count, operations, &results[w])) {
+      fprintf(stderr, "failed to run %s\n", WORKLOAD_NAMES[w]);
+      return -1;
+    }
+
+    fprintf(
+      stderr,
+      "%8zu %8zu %-28s %12.0f %10lu %10lu\n",
+      device_count,
+      object_count,
+      WORKLOAD_NAMES[w],
+      results[w].ops_per_sec,
+      (unsigned long)results[w].p50_ns,
+      (unsigned long)results[w].p99_ns
+    );
+  }
+
+  int length =
+    snprintf(
+      json,
+      json_size,
+      "{\"devices\": %zu, \"objects\": %zu, \"provision_ms\": %.1f, "
+      "\"rss_kb\": %zu, \"max_rss_kb\": %zu, \"workloads\": {",
+      device_count,
+      object_count,
+      provision_ms,
+      provisioned_rss_kb,
+      max_rss_kb()
+    );
+
+  for (int w = 0; w < WORKLOAD_COUNT && length < json_size; w++) {
+    length +=
+      snprintf(
+        json + length,
+        json_size - length,
+        "%s\"%s\": {\"operations\": %zu, \"ops_per_sec\": %.0f, "
+        "\"p50_ns\": %lu, \"p99_ns\": %lu, \"replies\": %lu}",
+        w ? ", " : "",
+        WORKLOAD_NAMES[w],
+        results[w].operations,
+        results[w].ops_per_sec,
+        (unsigned long)results[w].p50_ns,
+        (unsigned long)results[w].p99_ns,
+        (unsigned long)results[w].replies
+      );
+  }
+
+  if (length < json_size)
+    length += snprintf(json + length, json_size - length, "}}");
+
+  return length < json_size ? 0 : -1;
+}
+
+// runs one configuration in a child process and collects its JSON result
+static int fork_config(
+  size_t device_count,
+  size_t object_count,
+  size_t operations,
+  char* json,
+  size_t json_size
+) {
+  int pipe_fds[2] = { -1, -1 };
+
+  if (pipe(pipe_fds) != 0)
+    return -1;
+
+  pid_t pid = fork();
+
+  if (pid < 0)
+    return -1;
+
+  if (pid == 0) {
+    close(pipe_fds[0]);
+
+    // port traffic, such as command events, goes nowhere
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+
+    char result[MAX_RESULT_LEN] = { 0 };
+    int  status =
+      run_config(
+        device_count,
+        object_count,
+        operations,
+        result,
+        sizeof(result)
+      );
+
+    if (status == 0 && write(pipe_fds[1], result, strlen(result)) < 0)
+      status = -1;
+
+    _exit(status == 0 ? 0 : 1);
+  }
+
+  close(pipe_fds[1]);
+
+  size_t length = 0;
+  ssize_t received = 0;
+
+  while (length + 1 < json_size) {
+    received = read(pipe_fds[0], json + length, json_size - length - 1);
+    if (received > 0)
+      length += received;
+    else if (received == 0 || errno != EINTR)
+      break;
+  }
+
+  json[length] = '\0';
+  close(pipe_fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+
+  bool is_ok =
+       WIFEXITED(status)
+    && WEXITSTATUS(status) == 0
+    && length > 0;
+
+  return is_ok ? 0 : -1;
+}
+
+static size_t parse_counts(char* list, size_t* counts)
+{
+  size_t count = 0;
+
+  for (char* item = strtok(list, ","); item; item = strtok(NULL, ",")) {
+    if (count < MAX_SWEEP)
+      counts[count++] = strtoul(item, NULL, 0);
+  }
+
+  return count;
+}
+
+int main(int argc, char** argv)
+{
+  const char* output_path  = "bacnetd_bench.json";
+  size_t      operations   = DEFAULT_OPERATIONS;
+  size_t      device_counts[MAX_SWEEP] = { 0 };
+  size_t      object_counts[MAX_SWEEP] = { 0 };
+  size_t      device_runs =
+    sizeof(DEFAULT_DEVICE_COUNTS) / sizeof(DEFAULT_DEVICE_COUNTS[0]);
+  size_t      object_runs =
+    sizeof(DEFAULT_OBJECT_COUNTS) / sizeof(DEFAULT_OBJECT_COUNTS[0]);
+
+  memcpy(device_counts, DEFAULT_DEVICE_COUNTS, sizeof(DEFAULT_DEVICE_COUNTS));
+  memcpy(object_counts, DEFAULT_OBJECT_COUNTS, sizeof(DEFAULT_OBJECT_COUNTS));
+
+  int option = 0;
+
+  while ((option = getopt(argc, argv, "o:n:d:p:")) != -1) {
+    switch (option) {
+      case 'o':
+        output_path = optarg;
+        break;
+
+      case 'n':
+        operations = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'd':
+        device_runs = parse_counts(optarg, device_counts);
+        break;
+
+      case 'p':
+        object_runs = parse_counts(optarg, object_counts);
+        break;
+
+      default:
+        fprintf(
+          stderr,
+          "usage: %s [-o results.json] [-n operations] "
+          "[-d device counts] [-p object counts]\n",
+          argv[0]
+        );
+        return 1;
+    }
+  }
+
+  if (operations == 0)
+    operations = DEFAULT_OPERATIONS;
+
+  FILE* output = fopen(output_path, "w");
+  if (output == NULL) {
+    fprintf(stderr, "unable to open %s: %s\n", output_path, strerror(errno));
+    return 1;
+  }
+
+  fprintf(
+    output,
+    "{\"max_devices\": %d, \"operations\": %zu, \"results\": [",
+    MAX_NUM_DEVICES,
+    operations
+  );
+
+  fprintf(
+    stderr,
+    "%8s %8s %-28s %12s %10s %10s\n",
+    "devices",
+    "objects",
+    "workload",
+    "ops/sec",
+    "p50 ns",
+    "p99 ns"
+  );
+
+  bool is_first = true;
+  int  failures = 0;
+
+  for (size_t d = 0; d < device_runs; d++) {
+    for (size_t p = 0; p < object_runs; p++) {
+      char   json[MAX_RESULT_LEN] = { 0 };
+      size_t device_count = device_counts[d];
+      size_t object_count = object_counts[p];
+
+      // the routed device table is sized when the stack is built
+      if (device_count == 0 || device_count > MAX_NUM_DEVICES) {
+        snprintf(
+          json,
+          sizeof(json),
+          "{\"devices\": %zu, \"objects\": %zu, "
+          "\"skipped\": \"exceeds MAX_NUM_DEVICES\"}",
+          device_count,
+          object_count
+        );
+      }
+      else if (object_count == 0) {
+        continue;
+      }
+      else {
+        bool is_failed =
+          fork_config(
+            device_count,
+            object_count,
+            operations,
+            json,
+            sizeof(json)
+          ) != 0;
+
+        if (is_failed) {
+          failures++;
+          snprintf(
+            json,
+            sizeof(json),
+            "{\"devices\": %zu, \"objects\": %zu, \"failed\": true}",
+            device_count,
+            object_count
+          );
+        }
+      }
+
+      fprintf(output, "%s\n  %s", is_first ? "" : ",", json);
+      is_first = false;
+    }
+  }
+
+  fprintf(output, "\n]}\n");
+  fclose(output);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,287 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bacnet.h"
+#include "bench_calls.h"
+
+static void encode_string(ei_x_buff* request, const char* value)
+{
+  ei_x_encode_binary(request, value, strlen(value));
+}
+
+static void encode_name(
+  ei_x_buff* request,
+  const char* prefix,
+  uint32_t id
+) {
+  char name[32] = { 0 };
+  snprintf(name, sizeof(name), "%s-%u", prefix, id);
+
+  encode_string(request, name);
+}
+
+static void encode_object_header(
+  ei_x_buff* request,
+  int arity,
+  const char* atom,
+  uint32_t device_id,
+  uint32_t object_id
+) {
+  ei_x_encode_tuple_header(request, arity);
+  ei_x_encode_atom(request, atom);
+  ei_x_encode_ulong(request, device_id);
+  ei_x_encode_ulong(request, object_id);
+}
+
+static void encode_multistate_states(ei_x_buff* request)
+{
+  ei_x_encode_list_header(request, 3);
+  encode_string(request, "off");
+  encode_string(request, "low");
+  encode_string(request, "high");
+  ei_x_encode_empty_list(request);
+}
+
+// one object of every type, at consecutive IDs from object_id
+static void encode_provision_objects(ei_x_buff* request, uint32_t object_id)
+{
+  ei_x_encode_list_header(request, 5);
+
+  ei_x_encode_tuple_header(request, 5);
+  ei_x_encode_atom(request, "analog_input");
+  ei_x_encode_ulong(request, object_id);
+  encode_name(request, "ai", object_id);
+  encode_string(request, "benchmark point");
+  ei_x_encode_atom(request, "no_units");
+
+  ei_x_encode_tuple_header(request, 5);
+  ei_x_encode_atom(request, "multistate_input");
+  ei_x_encode_ulong(request, object_id + 1);
+  encode_name(request, "msi", object_id + 1);
+  encode_string(request, "benchmark state");
+  encode_multistate_states(request);
+
+  ei_x_encode_tuple_header(request, 5);
+  ei_x_encode_atom(request, "command");
+  ei_x_encode_ulong(request, object_id + 2);
+  encode_name(request, "command", object_id + 2);
+  encode_string(request, "benchmark command");
+  ei_x_encode_atom(request, "nil");
+
+  ei_x_encode_tuple_header(request, 5);
+  ei_x_encode_atom(request, "characterstring_value");
+  ei_x_encode_ulong(request, object_id + 3);
+  encode_name(request, "csv", object_id + 3);
+  encode_string(request, "benchmark string");
+  encode_string(request, "value");
+
+  ei_x_encode_tuple_header(request, 8);
+  ei_x_encode_atom(request, "binary_input");
+  ei_x_encode_ulong(request, object_id + 4);
+  encode_name(request, "bi", object_id + 4);
+  encode_string(request, "benchmark switch");
+  encode_string(request, "on");
+  encode_string(request, "off");
+  ei_x_encode_atom(request, "normal");
+  ei_x_encode_boolean(request, true);
+
+  ei_x_encode_empty_list(request);
+}
+
+/**
+ * @brief Encodes a valid call of the given type.
+ *
+ * Names are derived from the IDs, so calls for distinct IDs never collide.
+ *
+ * @param request   A pointer to the buffer to encode into, which is
+ *                  initialized with a version header.
+ * @param type      The call type.
+ * @param device_id The BACnet ID of the device the call targets.
+ * @param object_id The BACnet ID of the object the call targets, if any.
+ */
+void bench_encode_call(
+  ei_x_buff* request,
+  bacnet_call_type_t type,
+  uint32_t device_id,
+  uint32_t object_id
+) {
+  const char* atom = BACNET_CALL_ATOMS[type].atom;
+
+  ei_x_new_with_version(request);
+
+  switch (type) {
+    case CALL_CREATE_GATEWAY:
+    case CALL_CREATE_ROUTED_DEVICE:
+      ei_x_encode_tuple_header(request, 6);
+      ei_x_encode_atom(request, atom);
+      ei_x_encode_ulong(request, device_id);
+      encode_name(request, "device", device_id);
+      encode_string(request, "benchmark device");
+      encode_string(request, "bench");
+      encode_string(request, "1.0.0");
+      break;
+
+    case CALL_CREATE_ROUTED_ANALOG_INPUT:
+      encode_object_header(request, 6, atom, device_id, object_id);
+      encode_name(request, "ai", object_id);
+      encode_string(request, "benchmark point");
+      ei_x_encode_atom(request, "no_units");
+      break;
+
+    case CALL_SET_ROUTED_ANALOG_INPUT_VALUE:
+      encode_object_header(request, 4, atom, device_id, object_id);
+      ei_x_encode_double(request, 21.5);
+      break;
+
+    case CALL_CREATE_ROUTED_MULTISTATE_INPUT:
+      encode_object_header(request, 6, atom, device_id, object_id);
+      encode_name(request, "msi", object_id);
+      encode_string(request, "benchmark state");
+      encode_multistate_states(request);
+      break;
+
+    case CALL_SET_ROUTED_MULTISTATE_INPUT_VALUE:
+      encode_object_header(request, 4, atom, device_id, object_id);
+      ei_x_encode_ulong(request, 2);
+      break;
+
+    case CALL_CREATE_ROUTED_COMMAND:
+      encode_object_header(request, 6, atom, device_id, object_id);
+      encode_name(request, "command", object_id);
+      encode_string(request, "benchmark command");
+      ei_x_encode_atom(request, "nil");
+      break;
+
+    case CALL_SET_ROUTED_COMMAND_STATUS:
+      encode_object_header(request, 4, atom, device_id, object_id);
+      ei_x_encode_atom(request, "succeeded");
+      break;
+
+    case CALL_CREATE_CHARACTERSTRING_VALUE:
+      encode_object_header(request, 6, atom, device_id, object_id);
+      encode_name(request, "csv", object_id);
+      encode_string(request, "benchmark string");
+      encode_string(request, "value");
+      break;
+
+    case CALL_CREATE_BINARY_INPUT:
+      encode_object_header(request, 9, atom, device_id, object_id);
+      encode_name(request, "bi", object_id);
+      encode_string(request, "benchmark switch");
+      encode_string(request, "on");
+      encode_string(request, "off");
+      ei_x_encode_atom(request, "normal");
+      ei_x_encode_boolean(request, true);
+      break;
+
+    case CALL_SET_BINARY_INPUT_VALUE:
+      encode_object_header(request, 4, atom, device_id, object_id);
+      ei_x_encode_boolean(request, false);
+      break;
+
+    case CALL_SET_LOG_LEVEL:
+      ei_x_encode_tuple_header(request, 2);
+      ei_x_encode_atom(request, atom);
+      ei_x_encode_atom(request, "error");
+      break;
+
+    case CALL_GET_HOT_POINTS:
+      ei_x_encode_tuple_header(request, 2);
+      ei_x_encode_atom(request, atom);
+      ei_x_encode_ulong(request, 10);
+      break;
+
+    case CALL_PROVISION_DEVICE:
+      ei_x_encode_tuple_header(request, 7);
+      ei_x_encode_atom(request, atom);
+      ei_x_encode_ulong(request, device_id);
+      encode_name(request, "device", device_id);
+      encode_string(request, "benchmark device");
+      encode_string(request, "bench");
+      encode_string(request, "1.0.0");
+      encode_provision_objects(request, object_id);
+      break;
+
+    case CALL_DELETE_OBJECT:
+      encode_object_header(request, 3, atom, device_id, object_id);
+      break;
+
+    case CALL_DELETE_ROUTED_DEVICE:
+      ei_x_encode_tuple_header(request, 2);
+      ei_x_encode_atom(request, atom);
+      ei_x_encode_ulong(request, device_id);
+      break;
+
+    case CALL_SET_COMMAND_ACTIONS:
+      encode_object_header(request, 4, atom, device_id, object_id);
+      ei_x_encode_list_header(request, 1);
+      ei_x_encode_list_header(request, 1);
+      ei_x_encode_tuple_header(request, 7);
+      ei_x_encode_ulong(request, device_id);
+      ei_x_encode_atom(request, "analog_input");
+      ei_x_encode_ulong(request, object_id);
+      ei_x_encode_atom(request, "present_value");
+      ei_x_encode_double(request, 21.5);
+      ei_x_encode_ulong(request, 0);
+      ei_x_encode_boolean(request, false);
+      ei_x_encode_empty_list(request);
+      ei_x_encode_empty_list(request);
+      break;
+
+    default:
+      ei_x_encode_tuple_header(request, 1);
+      ei_x_encode_atom(request, atom);
+      break;
+  }
+}
+
+/**
+ * @brief Handles an encoded call and frees it.
+ *
+ * @param request A pointer to a call encoded with a version header.
+ *
+ * @return Returns 0 if the call was answered with `ok` or `{ok, _}`, or -1
+ *         otherwise.
+ */
+int bench_call(ei_x_buff* request)
+{
+  ei_x_buff reply;
+  ei_x_new(&reply);
+
+  int  index            = 0;
+  int  version          = 0;
+  int  arity            = 0;
+  char atom[MAXATOMLEN] = { 0 };
+
+  ei_decode_version(request->buff, &index, &version);
+  handle_bacnet_request(request->buff, &index, &reply);
+
+  index = 0;
+  ei_decode_tuple_header(reply.buff, &index, &arity);
+
+  bool is_ok =
+       ei_decode_atom(reply.buff, &index, atom) == 0
+    && strcmp(atom, "ok") == 0;
+
+  ei_x_free(&reply);
+  ei_x_free(request);
+
+  return is_ok ? 0 : -1;
+}
+
+/**
+ * @brief Encodes and handles a call of the given type.
+ *
+ * @return Returns 0 if the call succeeded, or -1 otherwise.
+ */
+int bench_call_type(
+  bacnet_call_type_t type,
+  uint32_t device_id,
+  uint32_t object_id
+) {
+  ei_x_buff request;
+  bench_encode_call(&request, type, device_id, object_id);
+
+  return bench_call(&request);
+}
@@ -0,0 +1,26 @@
+#ifndef BENCH_CALLS_H
+#define BENCH_CALLS_H
+
+#include <ei.h>
+#include <stdint.h>
+
+#include "protocol/decode_call.h"
+
+/*
+ * Port calls for the benchmarks, encoded the way lib/bacnet.ex sends them
+ * and handled by the same code as the port read thread.
+ */
+
+void bench_encode_call(
+  ei_x_buff* request,
+  bacnet_call_type_t type,
+  uint32_t device_id,
+  uint32_t object_id);
+
+int bench_call(ei_x_buff* request);
+int bench_call_type(
+  bacnet_call_type_t type,
+  uint32_t device_id,
+  uint32_t object_id);
+
+#endif /* BENCH_CALLS_H */
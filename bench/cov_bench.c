@@ -0,0 +1,194 @@
+/*
+ * COV deadband scan benchmark.
+ *
+ * Checks every analog point against its COV increment once per round, with
+ * about 1% of the points moved out of their deadband. Compares a walk over
+ * individually allocated stack objects, a scalar loop over the value
+ * table's columns, and the value table's vector kernel.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <bacnet/basic/object/routed_analog_input.h>
+
+#include "object/value_table.h"
+
+#define POINT_COUNT   100000
+#define ROUND_COUNT   200
+#define CHANGED_RATIO 100
+
+static ROUTED_ANALOG_INPUT_OBJECT* objects[POINT_COUNT] = { 0 };
+
+static float    values[POINT_COUNT]     = { 0 };
+static float    reported[POINT_COUNT]   = { 0 };
+static float    increments[POINT_COUNT] = { 0 };
+static uint64_t changed[(POINT_COUNT + 63) / 64] = { 0 };
+static uint32_t moved[POINT_COUNT / CHANGED_RATIO] = { 0 };
+
+static uint64_t now_ns(void)
+{
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static void populate(void)
+{
+  for (size_t i = 0; i < POINT_COUNT; i++) {
+    objects[i] = calloc(1, sizeof(ROUTED_ANALOG_INPUT_OBJECT));
+    if (!objects[i]) {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+
+    float value = (float)(rand() % 1000);
+
+    objects[i]->Present_Value = value;
+    objects[i]->Prior_Value   = value;
+    objects[i]->COV_Increment = 1.0f;
+
+    values[i]     = value;
+    reported[i]   = value;
+    increments[i] = 1.0f;
+  }
+
+  // visit the objects out of allocation order, as a keyed list would
+  for (size_t i = POINT_COUNT - 1; i > 0; i--) {
+    size_t j = (size_t)rand() % (i + 1);
+
+    ROUTED_ANALOG_INPUT_OBJECT* object = objects[i];
+    objects[i] = objects[j];
+    objects[j] = object;
+  }
+}
+
+static void move_points(float delta)
+{
+  for (size_t m = 0; m < POINT_COUNT / CHANGED_RATIO; m++) {
+    uint32_t i = moved[m];
+
+    objects[i]->Present_Value += delta;
+    values[i]                 += delta;
+  }
+}
+
+static size_t scan_objects(void)
+{
+  size_t count = 0;
+
+  for (size_t i = 0; i < POINT_COUNT; i++) {
+    ROUTED_ANALOG_INPUT_OBJECT* object = objects[i];
+
+    float distance = fabsf(object->Present_Value - object->Prior_Value);
+
+    if (distance > 0 && distance >= object->COV_Increment) {
+      object->Changed = true;
+      count++;
+    }
+  }
+
+  return count;
+}
+
+static size_t scan_columns(void)
+{
+  size_t count = 0;
+
+  for (size_t i = 0; i < POINT_COUNT; i++) {
+    float distance = fabsf(values[i] - reported[i]);
+
+    if (distance > 0 && distance >= increments[i]) {
+      changed[i / 64] |= 1ULL << (i % 64);
+      count++;
+    }
+  }
+
+  return count;
+}
+
+static size_t scan_vector(void)
+{
+  return value_table_deadband(
+    values,
+    reported,
+    increments,
+    changed,
+    POINT_COUNT
+  );
+}
+
+int main(int argc, char** argv)
+{
+  srand(1);
+  populate();
+
+  uint64_t object_ns = 0;
+  uint64_t column_ns = 0;
+  uint64_t vector_ns = 0;
+  size_t   found     = 0;
+
+  for (size_t round = 0; round < ROUND_COUNT; round++) {
+    for (size_t m = 0; m < POINT_COUNT / CHANGED_RATIO; m++)
+      moved[m] = (uint32_t)(rand() % POINT_COUNT);
+
+    // a point picked twice still moves past its deadband
+    move_points(2.0f);
+
+    uint64_t start = now_ns();
+    size_t   object_count = scan_objects();
+    object_ns += now_ns() - start;
+
+    memset(changed, 0, sizeof(changed));
+    start = now_ns();
+    size_t column_count = scan_columns();
+    column_ns += now_ns() - start;
+
+    memset(changed, 0, sizeof(changed));
+    start = now_ns();
+    size_t vector_count = scan_vector();
+    vector_ns += now_ns() - start;
+
+    bool is_mismatch =
+         object_count != column_count
+      || column_count != vector_count;
+
+    if (is_mismatch) {
+      fprintf(
+        stderr,
+        "mismatch: %zu, %zu, %zu\n",
+        object_count,
+        column_count,
+        vector_count
+      );
+      return 1;
+    }
+
+    found += vector_count;
+    move_points(-2.0f);
+  }
+
+  printf(
+    "%8s %14s %14s %14s %10s\n",
+    "points",
+    "objects us",
+    "columns us",
+    "vector us",
+    "changed"
+  );
+
+  printf(
+    "%8d %14.1f %14.1f %14.1f %10.1f\n",
+    POINT_COUNT,
+    (double)object_ns / ROUND_COUNT / 1000,
+    (double)column_ns / ROUND_COUNT / 1000,
+    (double)vector_ns / ROUND_COUNT / 1000,
+    (double)found / ROUND_COUNT
+  );
+
+  return 0;
+}
@@ -0,0 +1,808 @@
+/*
+ * Loopback BACnet/IP load generator.
+ *
+ * Simulates many clients, each with its own socket on 127.0.0.x, sending a
+ * weighted mix of Who-Is, ReadProperty, ReadPropertyMultiple, WriteProperty
+ * and SubscribeCOV requests at a target rate to a running bacnetd. Confirmed
+ * requests are matched to their replies by invoke ID to measure latency and
+ * loss, and COV notifications are counted as they arrive. Progress is
+ * printed every second and a JSON summary is written to stdout at the end.
+ *
+ * usage: load_gen [-t target address] [-p target port] [-s client port]
+ *                 [-c clients] [-r requests/s] [-d seconds] [-T timeout ms]
+ *                 [-g gateway instance] [-n network] [-R first:count]
+ *                 [-a first:count] [-w command instance]
+ *                 [-m who_is=1,rp=6,rpm=1,wp=1,cov=1]
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <bacnet/bacapp.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/cov.h>
+#include <bacnet/datalink/bvlc.h>
+#include <bacnet/npdu.h>
+#include <bacnet/rp.h>
+#include <bacnet/rpm.h>
+#include <bacnet/whois.h>
+#include <bacnet/wp.h>
+
+#define MAX_CLIENTS          1000
+#define MAX_DATAGRAM         1500
+#define MAX_SENDS_PER_TICK   1000
+#define HISTOGRAM_SUB_BITS   3
+#define HISTOGRAM_BUCKETS    320
+#define COV_LIFETIME_S       300
+#define EXPIRY_PERIOD_US     10000
+
+typedef enum {
+  SERVICE_WHO_IS,
+  SERVICE_READ_PROPERTY,
+  SERVICE_READ_PROPERTY_MULTIPLE,
+  SERVICE_WRITE_PROPERTY,
+  SERVICE_SUBSCRIBE_COV,
+  SERVICE_COUNT,
+} service_t;
+
+static const char* SERVICE_NAMES[SERVICE_COUNT] = {
+  "who_is",
+  "rp",
+  "rpm",
+  "wp",
+  "cov",
+};
+
+typedef struct {
+  uint64_t buckets[HISTOGRAM_BUCKETS];
+  uint64_t count;
+  uint64_t max_us;
+} histogram_t;
+
+typedef struct {
+  uint64_t    sent;
+  uint64_t    answered;
+  uint64_t    errors;
+  uint64_t    lost;
+  uint64_t    backlogged;
+  histogram_t latency;
+} service_stats_t;
+
+typedef struct {
+  uint64_t sent_us;
+  uint8_t  service;
+  bool     is_pending;
+} pending_t;
+
+typedef struct {
+  int       fd;
+  uint32_t  process_id;
+  uint8_t   next_invoke_id;
+  pending_t pending[256];
+} client_t;
+
+typedef struct {
+  struct sockaddr_in target;
+  uint16_t           client_port;
+  size_t             client_count;
+  uint32_t           rate;
+  uint32_t           duration_s;
+  uint32_t           timeout_ms;
+  uint32_t           gateway_instance;
+  uint16_t           network;
+  uint32_t           routed_first;
+  uint32_t           routed_count;
+  uint32_t           object_first;
+  uint32_t           object_count;
+  uint32_t           command_instance;
+  uint32_t           weights[SERVICE_COUNT];
+} options_t;
+
+static options_t       options = { 0 };
+static client_t        clients[MAX_CLIENTS] = { 0 };
+static struct pollfd   poll_fds[MAX_CLIENTS] = { 0 };
+static service_stats_t stats[SERVICE_COUNT] = { 0 };
+static uint64_t        i_am_received = 0;
+static uint64_t        cov_notifications = 0;
+
+static uint64_t now_us(void)
+{
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+// log-linear buckets, 2^HISTOGRAM_SUB_BITS per power of two
+static int bucket_of(uint64_t value)
+{
+  uint64_t linear = 1 << HISTOGRAM_SUB_BITS;
+
+  if (value < linear)
+    return (int)value;
+
+  int msb    = 63 - __builtin_clzll(value);
+  int shift  = msb - HISTOGRAM_SUB_BITS;
+  int bucket =
+      (msb - HISTOGRAM_SUB_BITS + 1) * (int)linear
+    + (int)((value >> shift) & (linear - 1));
+
+  return bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+}
+
+static uint64_t bucket_floor(int bucket)
+{
+  uint64_t linear = 1 << HISTOGRAM_SUB_BITS;
+
+  if (bucket < (int)linear)
+    return (uint64_t)bucket;
+
+  int shift = bucket / (int)linear - 1;
+  int sub   = bucket % (int)linear;
+
+  return (linear + sub) << shift;
+}
+
+static void histogram_record(histogram_t* histogram, uint64_t value)
+{
+  histogram->buckets[bucket_of(value)]++;
+  histogram->count++;
+
+  if (value > histogram->max_us)
+    histogram->max_us = value;
+}
+
+static uint64_t histogram_percentile(histogram_t* histogram, double fraction)
+{
+  uint64_t rank = (uint64_t)(histogram->count * fraction);
+  uint64_t seen = 0;
+
+  for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+    seen += histogram->buckets[b];
+
+    if (seen > rank)
+      return bucket_floor(b);
+  }
+
+  return histogram->max_us;
+}
+
+static int open_client(size_t index, client_t* client)
+{
+  struct sockaddr_in address = { 0 };
+  int                enabled = 1;
+
+  // 127.0.0.2 and up, every address in 127/8 is local
+  address.sin_family      = AF_INET;
+  address.sin_port        = htons(options.client_port);
+  address.sin_addr.s_addr =
+    htonl(0x7F000000 | (uint32_t)((index / 250) << 8) | (2 + index % 250));
+
+  client->fd         = socket(AF_INET, SOCK_DGRAM, 0);
+  client->process_id = (uint32_t)index + 1;
+
+  if (client->fd < 0)
+    return -1;
+
+  setsockopt(client->fd, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+
+  bool is_failed =
+       bind(client->fd, (struct sockaddr*)&address, sizeof(address)) != 0
+    || fcntl(client->fd, F_SETFL, O_NONBLOCK) != 0;
+
+  if (is_failed) {
+    close(client->fd);
+    return -1;
+  }
+
+  return 0;
+}
+
+static service_t pick_service(void)
+{
+  uint32_t total = 0;
+
+  for (int s = 0; s < SERVICE_COUNT; s++)
+    total += options.weights[s];
+
+  uint32_t ticket = (uint32_t)rand() % total;
+
+  for (int s = 0; s < SERVICE_COUNT; s++) {
+    if (ticket < options.weights[s])
+      return (service_t)s;
+
+    ticket -= options.weights[s];
+  }
+
+  return SERVICE_READ_PROPERTY;
+}
+
+// routed devices when given, otherwise the gateway
+static uint32_t pick_device(BACNET_ADDRESS* dest)
+{
+  memset(dest, 0, sizeof(*dest));
+
+  if (options.routed_count == 0)
+    return options.gateway_instance;
+
+  uint32_t instance =
+    options.routed_first + (uint32_t)rand() % options.routed_count;
+
+  dest->net = options.network;
+  dest->len = 3;
+  encode_unsigned24(&dest->adr[0], instance);
+
+  return instance;
+}
+
+static int encode_apdu(
+  service_t service,
+  client_t* client,
+  uint8_t invoke_id,
+  uint32_t device,
+  uint8_t* apdu,
+  size_t apdu_size
+) {
+  uint32_t object =
+    options.object_first + (uint32_t)rand() % options.object_count;
+
+  switch (service) {
+    case SERVICE_WHO_IS:
+      return whois_encode_apdu(apdu, device, device);
+
+    case SERVICE_READ_PROPERTY: {
+      BACNET_READ_PROPERTY_DATA data = {
+        .object_type     = OBJECT_ANALOG_INPUT,
+        .object_instance = object,
+        .object_property = PROP_PRESENT_VALUE,
+        .array_index     = BACNET_ARRAY_ALL,
+      };
+
+      return rp_encode_apdu(apdu, invoke_id, &data);
+    }
+
+    case SERVICE_READ_PROPERTY_MULTIPLE: {
+      BACNET_PROPERTY_REFERENCE property = {
+        .propertyIdentifier = PROP_ALL,
+        .propertyArrayIndex = BACNET_ARRAY_ALL,
+        .next               = NULL,
+      };
+
+      BACNET_READ_ACCESS_DATA access = {
+        .object_type      = OBJECT_ANALOG_INPUT,
+        .object_instance  = object,
+        .listOfProperties = &property,
+        .next             = NULL,
+      };
+
+      return rpm_encode_apdu(apdu, apdu_size, invoke_id, &access);
+    }
+
+    case SERVICE_WRITE_PROPERTY: {
+      BACNET_WRITE_PROPERTY_DATA    data  = { 0 };
+      BACNET_APPLICATION_DATA_VALUE value = { 0 };
+
+      value.tag                 = BACNET_APPLICATION_TAG_UNSIGNED_INT;
+      value.type.Unsigned_Int   = 1;
+      data.object_type          = OBJECT_COMMAND;
+      data.object_instance      = options.command_instance;
+      data.object_property      = PROP_PRESENT_VALUE;
+      data.array_index          = BACNET_ARRAY_ALL;
+      data.priority             = BACNET_NO_PRIORITY;
+      data.application_data_len =
+        bacapp_encode_application_data(&data.application_data[0], &value);
+
+      return wp_encode_apdu(apdu, invoke_id, &data);
+    }
+
+    case SERVICE_SUBSCRIBE_COV: {
+      BACNET_SUBSCRIBE_COV_DATA data = { 0 };
+
+      data.subscriberProcessIdentifier = client->process_id;
+      data.monitoredObjectIdentifier.type     = OBJECT_ANALOG_INPUT;
+      data.monitoredObjectIdentifier.instance = object;
+      data.cancellationRequest         = false;
+      data.issueConfirmedNotifications = false;
+      data.lifetime                    = COV_LIFETIME_S;
+
+      return cov_subscribe_encode_apdu(apdu, apdu_size, invoke_id, &data);
+    }
+
+    default:
+      return -1;
+  }
+}
+
+static void send_request(client_t* client)
+{
+  service_t        service   = pick_service();
+  uint8_t          invoke_id = client->next_invoke_id;
+  bool             is_confirmed = service != SERVICE_WHO_IS;
+  BACNET_ADDRESS   dest      = { 0 };
+  BACNET_ADDRESS   src       = { 0 };
+  BACNET_NPDU_DATA npdu_data = { 0 };
+  uint8_t          datagram[MAX_DATAGRAM] = { 0 };
+
+  if (is_confirmed && client->pending[invoke_id].is_pending) {
+    stats[service].backlogged++;
+    return;
+  }
+
+  uint32_t device = pick_device(&dest);
+
+  npdu_encode_npdu_data(&npdu_data, is_confirmed, MESSAGE_PRIORITY_NORMAL);
+
+  // BVLC original unicast header, the length is filled in below
+  int length = 4;
+  length += npdu_encode_pdu(&datagram[length], &dest, &src, &npdu_data);
+
+  int apdu_len =
+    encode_apdu(
+      service,
+      client,
+      invoke_id,
+      device,
+      &datagram[length],
+      sizeof(datagram) - length
+    );
+
+  if (apdu_len <= 0)
+    return;
+
+  length += apdu_len;
+
+  datagram[0] = BVLL_TYPE_BACNET_IP;
+  datagram[1] = BVLC_ORIGINAL_UNICAST_NPDU;
+  encode_unsigned16(&datagram[2], (uint16_t)length);
+
+  ssize_t sent =
+    sendto(
+      client->fd,
+      datagram,
+      length,
+      0,
+      (struct sockaddr*)&options.target,
+      sizeof(options.target)
+    );
+
+  if (sent != length) {
+    stats[service].errors++;
+    return;
+  }
+
+  stats[service].sent++;
+
+  if (is_confirmed) {
+    client->pending[invoke_id] = (pending_t){
+      .sent_us    = now_us(),
+      .service    = (uint8_t)service,
+      .is_pending = true,
+    };
+
+    client->next_invoke_id++;
+  }
+}
+
+static void complete(client_t* client, uint8_t invoke_id, bool is_error)
+{
+  pending_t* pending = &client->pending[invoke_id];
+
+  if (!pending->is_pending)
+    return;
+
+  service_stats_t* service = &stats[pending->service];
+
+  pending->is_pending = false;
+
+  if (is_error)
+    service->errors++;
+
+  service->answered++;
+  histogram_record(&service->latency, now_us() - pending->sent_us);
+}
+
+static void handle_datagram(client_t* client, uint8_t* datagram, int length)
+{
+  if (length < 4 || datagram[0] != BVLL_TYPE_BACNET_IP)
+    return;
+
+  int offset = 4;
+
+  switch (datagram[1]) {
+    case BVLC_ORIGINAL_UNICAST_NPDU:
+    case BVLC_ORIGINAL_BROADCAST_NPDU:
+      break;
+
+    case BVLC_FORWARDED_NPDU:
+      offset += 6;
+      break;
+
+    default:
+      return;
+  }
+
+  BACNET_ADDRESS   dest      = { 0 };
+  BACNET_ADDRESS   src       = { 0 };
+  BACNET_NPDU_DATA npdu_data = { 0 };
+
+  if (offset >= length)
+    return;
+
+  int npdu_len =
+    bacnet_npdu_decode(
+      &datagram[offset],
+      (uint16_t)(length - offset),
+      &dest,
+      &src,
+      &npdu_data
+    );
+
+  bool is_apdu =
+       npdu_len > 0
+    && !npdu_data.network_layer_message
+    && offset + npdu_len + 2 <= length;
+
+  if (!is_apdu)
+    return;
+
+  uint8_t* apdu = &datagram[offset + npdu_len];
+
+  switch (apdu[0] & 0xF0) {
+    case PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST:
+      if (apdu[1] == SERVICE_UNCONFIRMED_I_AM)
+        i_am_received++;
+      else if (apdu[1] == SERVICE_UNCONFIRMED_COV_NOTIFICATION)
+        cov_notifications++;
+      break;
+
+    case PDU_TYPE_SIMPLE_ACK:
+    case PDU_TYPE_COMPLEX_ACK:
+      complete(client, apdu[1], false);
+      break;
+
+    case PDU_TYPE_ERROR:
+    case PDU_TYPE_REJECT:
+    case PDU_TYPE_ABORT:
+      complete(client, apdu[1], true);
+      break;
+  }
+}
+
+static void receive_all(int timeout_ms)
+{
+  uint8_t datagram[MAX_DATAGRAM];
+
+  if (poll(poll_fds, options.client_count, timeout_ms) <= 0)
+    return;
+
+  for (size_t i = 0; i < options.client_count; i++) {
+    if (!(poll_fds[i].revents & POLLIN))
+      continue;
+
+    while (true) {
+      ssize_t received = recv(clients[i].fd, datagram, sizeof(datagram), 0);
+      if (received <= 0)
+        break;
+
+      handle_datagram(&clients[i], datagram, (int)received);
+    }
+  }
+}
+
+static size_t expire_pending(uint64_t now)
+{
+  size_t   outstanding = 0;
+  uint64_t timeout_us  = (uint64_t)options.timeout_ms * 1000;
+
+  for (size_t i = 0; i < options.client_count; i++) {
+    for (int id = 0; id < 256; id++) {
+      pending_t* pending = &clients[i].pending[id];
+
+      if (!pending->is_pending)
+        continue;
+
+      if (now - pending->sent_us < timeout_us) {
+        outstanding++;
+        continue;
+      }
+
+      pending->is_pending = false;
+      stats[pending->service].lost++;
+    }
+  }
+
+  return outstanding;
+}
+
+static void print_progress(uint64_t elapsed_s)
+{
+  uint64_t sent     = 0;
+  uint64_t answered = 0;
+  uint64_t lost     = 0;
+
+  for (int s = 0; s < SERVICE_COUNT; s++) {
+    sent     += stats[s].sent;
+    answered += stats[s].answered;
+    lost     += stats[s].lost;
+  }
+
+  fprintf(
+    stderr,
+    "%5lus sent %lu answered %lu lost %lu i-am %lu cov %lu\n",
+    (unsigned long)elapsed_s,
+    (unsigned long)sent,
+    (unsigned long)answered,
+    (unsigned long)lost,
+    (unsigned long)i_am_received,
+    (unsigned long)cov_notifications
+  );
+}
+
+static void print_summary(double elapsed_s)
+{
+  printf(
+    "{\"duration_s\": %.1f, \"rate\": %u, \"clients\": %zu, \"services\": {",
+    elapsed_s,
+    options.rate,
+    options.client_count
+  );
+
+  for (int s = 0; s < SERVICE_COUNT; s++) {
+    service_stats_t* service = &stats[s];
+
+    printf(
+      "%s\"%s\": {\"sent\": %lu, \"answered\": %lu, \"errors\": %lu, "
+      "\"lost\": %lu, \"backlogged\": %lu, \"p50_us\": %lu, "
+      "\"p99_us\": %lu, \"max_us\": %lu}",
+      s ? ", " : "",
+      SERVICE_NAMES[s],
+      (unsigned long)service->sent,
+      (unsigned long)service->answered,
+      (unsigned long)service->errors,
+      (unsigned long)service->lost,
+      (unsigned long)service->backlogged,
+      (unsigned long)histogram_percentile(&service->latency, 0.50),
+      (unsigned long)histogram_percentile(&service->latency, 0.99),
+      (unsigned long)service->latency.max_us
+    );
+  }
+
+  printf(
+    "}, \"i_am_received\": %lu, \"cov_notifications\": %lu}\n",
+    (unsigned long)i_am_received,
+    (unsigned long)cov_notifications
+  );
+}
+
+static int parse_range(const char* value, uint32_t* first, uint32_t* count)
+{
+  char* end = NULL;
+
+  *first = (uint32_t)strtoul(value, &end, 0);
+  *count = *end == ':' ? (uint32_t)strtoul(end + 1, NULL, 0) : 1;
+
+  return 0;
+}
+
+static int parse_mix(char* mix)
+{
+  memset(options.weights, 0, sizeof(options.weights));
+
+  for (char* item = strtok(mix, ","); item; item = strtok(NULL, ",")) {
+    char* separator = strchr(item, '=');
+    int   service   = -1;
+
+    if (separator == NULL)
+      return -1;
+
+    *separator = '\0';
+
+    for (int s = 0; s < SERVICE_COUNT; s++) {
+      if (strcmp(item, SERVICE_NAMES[s]) == 0)
+        service = s;
+    }
+
+    if (service == -1)
+      return -1;
+
+    options.weights[service] = (uint32_t)strtoul(separator + 1, NULL, 0);
+  }
+
+  return 0;
+}
+
+static void set_defaults(void)
+{
+  options.target.sin_family      = AF_INET;
+  options.target.sin_port        = htons(47808);
+  options.target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  options.client_count     = 10;
+  options.rate             = 1000;
+  options.duration_s       = 10;
+  options.timeout_ms       = 3000;
+  options.gateway_instance = 1;
+  options.network          = 1000;
+  options.object_count     = 1;
+  options.command_instance = 1;
+
+  options.weights[SERVICE_WHO_IS]                 = 1;
+  options.weights[SERVICE_READ_PROPERTY]          = 6;
+  options.weights[SERVICE_READ_PROPERTY_MULTIPLE] = 1;
+  options.weights[SERVICE_WRITE_PROPERTY]         = 1;
+  options.weights[SERVICE_SUBSCRIBE_COV]          = 1;
+}
+
+static int parse_options(int argc, char** argv)
+{
+  int option = 0;
+
+  while ((option = getopt(argc, argv, "t:p:s:c:r:d:T:g:n:R:a:w:m:")) != -1) {
+    switch (option) {
+      case 't':
+        if (inet_pton(AF_INET, optarg, &options.target.sin_addr) != 1)
+          return -1;
+        break;
+
+      case 'p':
+        options.target.sin_port = htons((uint16_t)strtoul(optarg, NULL, 0));
+        break;
+
+      case 's':
+        options.client_port = (uint16_t)strtoul(optarg, NULL, 0);
+        break;
+
+      case 'c':
+        options.client_count = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'r':
+        options.rate = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+
+      case 'd':
+        options.duration_s = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+
+      case 'T':
+        options.timeout_ms = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+
+      case 'g':
+        options.gateway_instance = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+
+      case 'n':
+        options.network = (uint16_t)strtoul(optarg, NULL, 0);
+        break;
+
+      case 'R':
+        parse_range(optarg, &options.routed_first, &options.routed_count);
+        break;
+
+      case 'a':
+        parse_range(optarg, &options.object_first, &options.object_count);
+        break;
+
+      case 'w':
+        options.command_instance = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+
+      case 'm':
+        if (parse_mix(optarg))
+          return -1;
+        break;
+
+      default:
+        return -1;
+    }
+  }
+
+  uint32_t total_weight = 0;
+
+  for (int s = 0; s < SERVICE_COUNT; s++)
+    total_weight += options.weights[s];
+
+  bool is_valid =
+       options.client_count > 0
+    && options.client_count <= MAX_CLIENTS
+    && options.rate > 0
+    && options.object_count > 0
+    && total_weight > 0;
+
+  return is_valid ? 0 : -1;
+}
+
+int main(int argc, char** argv)
+{
+  set_defaults();
+
+  if (parse_options(argc, argv)) {
+    fprintf(
+      stderr,
+      "usage: %s [-t target address] [-p target port] [-s client port]\n"
+      "       [-c clients] [-r requests/s] [-d seconds] [-T timeout ms]\n"
+      "       [-g gateway instance] [-n network] [-R first:count]\n"
+      "       [-a first:count] [-w command instance]\n"
+      "       [-m who_is=1,rp=6,rpm=1,wp=1,cov=1]\n",
+      argv[0]
+    );
+    return 1;
+  }
+
+  for (size_t i = 0; i < options.client_count; i++) {
+    if (open_client(i, &clients[i])) {
+      fprintf(stderr, "unable to open client %zu: %s\n", i, strerror(errno));
+      return 1;
+    }
+
+    poll_fds[i].fd     = clients[i].fd;
+    poll_fds[i].events = POLLIN;
+  }
+
+  srand(1);
+
+  uint64_t started_at   = now_us();
+  uint64_t duration_us  = (uint64_t)options.duration_s * 1000000;
+  uint64_t timeout_us   = (uint64_t)options.timeout_ms * 1000;
+  uint64_t sent_total   = 0;
+  uint64_t next_report  = 1;
+  size_t   next_client  = 0;
+  size_t   outstanding  = 0;
+  uint64_t next_expiry  = 0;
+
+  while (true) {
+    uint64_t now     = now_us();
+    uint64_t elapsed = now - started_at;
+
+    bool is_done =
+         elapsed >= duration_us
+      && (outstanding == 0 || elapsed >= duration_us + timeout_us);
+
+    if (is_done)
+      break;
+
+    // catch up to the target rate, bounded so a stall does not flood
+    if (elapsed < duration_us) {
+      uint64_t due   = elapsed * options.rate / 1000000;
+      int      sends = 0;
+
+      while (sent_total < due && sends++ < MAX_SENDS_PER_TICK) {
+        send_request(&clients[next_client]);
+        next_client = (next_client + 1) % options.client_count;
+        sent_total++;
+      }
+    }
+
+    receive_all(1);
+
+    if (now >= next_expiry) {
+      outstanding = expire_pending(now_us());
+      next_expiry = now + EXPIRY_PERIOD_US;
+    }
+
+    if (elapsed >= next_report * 1000000) {
+      print_progress(next_report);
+      next_report++;
+    }
+  }
+
+  // anything still unanswered after the grace period is lost
+  expire_pending(UINT64_MAX);
+
+  print_summary((now_us() - started_at) / 1e6);
+
+  for (size_t i = 0; i < options.client_count; i++)
+    close(clients[i].fd);
+
+  return 0;
+}
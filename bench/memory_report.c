@@ -0,0 +1,224 @@
+/*
+ * Object memory report.
+ *
+ * Creates the given number of binary-input, command and character-string
+ * value objects through the port call handlers, and reports their cost per
+ * object. "before" is the layout that embedded every string in a
+ * MAX_STRING_LEN array, plus the name index's own copy of the name, and
+ * "after" is the object's share of its type's slabs and of the string
+ * arena. "before" leaves out allocator overhead. "heap" is the measured
+ * growth of the heap, which also covers the object list and the name index.
+ *
+ * usage: memory_report [-n objects]
+ */
+
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <bacnet/basic/object/device.h>
+
+#include "bacnet.h"
+#include "log.h"
+#include "bench_calls.h"
+#include "object/binary_input.h"
+#include "object/characterstring_value.h"
+#include "object/command.h"
+#include "object/string_arena.h"
+
+#define DEFAULT_OBJECTS 100000
+#define DEVICE_ID       1
+
+// the object layouts before their strings were interned
+typedef struct {
+  BACNET_OBJECT_TYPE type;
+
+  char name[MAX_STRING_LEN];
+  char description[MAX_STRING_LEN];
+  char active_text[MAX_STRING_LEN];
+  char inactive_text[MAX_STRING_LEN];
+  bool present_value;
+
+  BACNET_POLARITY polarity;
+} inline_binary_input_t;
+
+typedef struct {
+  BACNET_OBJECT_TYPE type;
+
+  uint32_t present_value;
+  bool     in_progress;
+  bool     successful;
+  char     name[MAX_STRING_LEN];
+  char     description[MAX_STRING_LEN];
+
+  BACNET_ACTION_LIST actions[MAX_COMMAND_ACTIONS];
+} inline_command_t;
+
+typedef struct {
+  BACNET_OBJECT_TYPE type;
+
+  char name[MAX_STRING_LEN];
+  char description[MAX_STRING_LEN];
+  char present_value[MAX_STRING_LEN];
+} inline_characterstring_value_t;
+
+typedef void (*slab_stats_fn_t)(
+  const DEVICE_OBJECT_DATA* device,
+  slab_stats_t* stats);
+
+typedef struct {
+  const char*        name;
+  const char*        name_prefix;
+  bacnet_call_type_t create_call;
+  size_t             inline_size;
+  slab_stats_fn_t    slab_stats;
+} object_report_t;
+
+// name prefixes match the names bench_encode_call gives each type
+static const object_report_t OBJECT_REPORTS[] = {
+  {
+    "binary_input",
+    "bi",
+    CALL_CREATE_BINARY_INPUT,
+    sizeof(inline_binary_input_t),
+    binary_input_slab_stats,
+  },
+  {
+    "command",
+    "command",
+    CALL_CREATE_ROUTED_COMMAND,
+    sizeof(inline_command_t),
+    command_slab_stats,
+  },
+  {
+    "characterstring_value",
+    "csv",
+    CALL_CREATE_CHARACTERSTRING_VALUE,
+    sizeof(inline_characterstring_value_t),
+    characterstring_value_slab_stats,
+  },
+};
+
+static size_t heap_used(void)
+{
+  return mallinfo2().uordblks;
+}
+
+static int report_object(
+  const object_report_t* object,
+  uint32_t first_id,
+  size_t count
+) {
+  string_arena_stats_t arena_before = { 0 };
+  string_arena_stats_t arena_after  = { 0 };
+  slab_stats_t         slab_before  = { 0 };
+  slab_stats_t         slab_after   = { 0 };
+  size_t               name_bytes   = 0;
+
+  string_arena_get_stats(&arena_before);
+  object->slab_stats(NULL, &slab_before);
+  size_t heap_before = heap_used();
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t object_id = first_id + (uint32_t)i;
+
+    if (bench_call_type(object->create_call, DEVICE_ID, object_id))
+      return -1;
+
+    name_bytes += snprintf(NULL, 0, "%s-%u", object->name_prefix, object_id);
+    name_bytes += 1;
+  }
+
+  size_t heap_after = heap_used();
+  object->slab_stats(NULL, &slab_after);
+  string_arena_get_stats(&arena_after);
+
+  size_t after_bytes =
+      (slab_after.bytes - slab_before.bytes)
+    + (arena_after.bytes - arena_before.bytes);
+
+  printf(
+    "%-24s %10zu %12.1f %12.1f %12.1f %7zu/%zu\n",
+    object->name,
+    count,
+    object->inline_size + (double)name_bytes / count,
+    (double)after_bytes / count,
+    (double)(heap_after - heap_before) / count,
+    slab_after.in_use,
+    slab_after.capacity
+  );
+
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  size_t object_count = DEFAULT_OBJECTS;
+  int    option       = 0;
+
+  while ((option = getopt(argc, argv, "n:")) != -1) {
+    if (option != 'n') {
+      fprintf(stderr, "usage: %s [-n objects]\n", argv[0]);
+      return 1;
+    }
+
+    object_count = strtoul(optarg, NULL, 0);
+  }
+
+  size_t report_count = sizeof(OBJECT_REPORTS) / sizeof(OBJECT_REPORTS[0]);
+
+  bool is_too_many =
+       object_count == 0
+    || object_count * report_count >= BACNET_MAX_INSTANCE;
+
+  if (is_too_many) {
+    fprintf(
+      stderr,
+      "objects must be between 1 and %zu\n",
+      (size_t)(BACNET_MAX_INSTANCE - 1) / report_count
+    );
+    return 1;
+  }
+
+  log_set_level(ERROR);
+  address_init();
+  bacnet_init_service_handlers();
+
+  if (bench_call_type(CALL_CREATE_GATEWAY, DEVICE_ID, 0)) {
+    fprintf(stderr, "failed to create the gateway\n");
+    return 1;
+  }
+
+  printf(
+    "%-24s %10s %12s %12s %12s %s\n",
+    "object",
+    "count",
+    "before B/obj",
+    "after B/obj",
+    "heap B/obj",
+    "slab slots"
+  );
+
+  for (size_t r = 0; r < report_count; r++) {
+    uint32_t first_id = (uint32_t)(r * object_count);
+
+    if (report_object(&OBJECT_REPORTS[r], first_id, object_count)) {
+      fprintf(stderr, "failed to create %s objects\n", OBJECT_REPORTS[r].name);
+      return 1;
+    }
+  }
+
+  string_arena_stats_t arena = { 0 };
+  string_arena_get_stats(&arena);
+
+  printf(
+    "string arena: %zu strings, %zu references, %zu bytes\n",
+    arena.entries,
+    arena.references,
+    arena.bytes
+  );
+
+  return 0;
+}
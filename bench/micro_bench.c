@@ -0,0 +1,285 @@
+/*
+ * Object encoder and port decoder microbenchmarks.
+ *
+ * Reads every listed property of each object type through its read_property
+ * handler, and decodes a sample of every port call type with
+ * decode_bacnet_call. malloc, calloc and realloc are wrapped at link time,
+ * so allocations made inside the stack and ei are counted too.
+ *
+ * usage: micro_bench [-n iterations]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <bacnet/bactext.h>
+#include <bacnet/basic/object/device.h>
+#include <bacnet/basic/object/routed_analog_input.h>
+#include <bacnet/basic/object/routed_multistate_input.h>
+
+#include "bacnet.h"
+#include "log.h"
+#include "bench_calls.h"
+#include "object/binary_input.h"
+#include "object/characterstring_value.h"
+#include "object/command.h"
+
+#define DEFAULT_ITERATIONS 100000
+#define DEVICE_ID          1
+#define OBJECT_ID          1
+
+typedef int (*read_property_t)(BACNET_READ_PROPERTY_DATA* data);
+
+typedef void (*property_lists_t)(
+  const int** required,
+  const int** optional,
+  const int** proprietary);
+
+typedef struct {
+  const char*        name;
+  BACNET_OBJECT_TYPE type;
+  bacnet_call_type_t create_call;
+  read_property_t    read_property;
+  property_lists_t   property_lists;
+} object_bench_t;
+
+static const object_bench_t OBJECT_BENCHES[] = {
+  {
+    "binary_input",
+    OBJECT_BINARY_INPUT,
+    CALL_CREATE_BINARY_INPUT,
+    binary_input_read_property,
+    binary_input_property_lists,
+  },
+  {
+    "command",
+    OBJECT_COMMAND,
+    CALL_CREATE_ROUTED_COMMAND,
+    command_read_property,
+    command_property_lists,
+  },
+  {
+    "characterstring_value",
+    OBJECT_CHARACTERSTRING_VALUE,
+    CALL_CREATE_CHARACTERSTRING_VALUE,
+    characterstring_value_read_property,
+    characterstring_value_property_lists,
+  },
+  {
+    "routed_analog_input",
+    OBJECT_ANALOG_INPUT,
+    CALL_CREATE_ROUTED_ANALOG_INPUT,
+    Routed_Analog_Input_Read_Property,
+    Routed_Analog_Input_Property_Lists,
+  },
+  {
+    "routed_multistate_input",
+    OBJECT_MULTI_STATE_INPUT,
+    CALL_CREATE_ROUTED_MULTISTATE_INPUT,
+    Routed_Multistate_Input_Read_Property,
+    Routed_Multistate_Input_Property_Lists,
+  },
+};
+
+static uint64_t allocations = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+  allocations++;
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size)
+{
+  allocations++;
+  return __real_realloc(pointer, size);
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static void report(
+  const char* group,
+  const char* name,
+  uint64_t elapsed_ns,
+  uint64_t allocation_count,
+  size_t iterations,
+  bool is_failed
+) {
+  printf(
+    "%-24s %-36s %10.1f %10.2f%s\n",
+    group,
+    name,
+    (double)elapsed_ns / iterations,
+    (double)allocation_count / iterations,
+    is_failed ? "  (error)" : ""
+  );
+}
+
+static void bench_read_property(
+  const object_bench_t* bench,
+  int property,
+  size_t iterations
+) {
+  uint8_t apdu[MAX_APDU] = { 0 };
+  int     apdu_len       = 0;
+
+  BACNET_READ_PROPERTY_DATA data = {
+    .object_type     = bench->type,
+    .object_instance = OBJECT_ID,
+    .object_property = property,
+    .array_index     = BACNET_ARRAY_ALL,
+  };
+
+  uint64_t allocated_before = allocations;
+  uint64_t started_at       = now_ns();
+
+  for (size_t i = 0; i < iterations; i++) {
+    data.application_data     = &apdu[0];
+    data.application_data_len = sizeof(apdu);
+
+    apdu_len = bench->read_property(&data);
+  }
+
+  report(
+    bench->name,
+    bactext_property_name(property),
+    now_ns() - started_at,
+    allocations - allocated_before,
+    iterations,
+    apdu_len < 0
+  );
+}
+
+static void bench_property_list(
+  const object_bench_t* bench,
+  const int* properties,
+  size_t iterations
+) {
+  for (size_t p = 0; properties && properties[p] != -1; p++)
+    bench_read_property(bench, properties[p], iterations);
+}
+
+static void bench_decode_call(bacnet_call_type_t type, size_t iterations)
+{
+  ei_x_buff request;
+  bench_encode_call(&request, type, DEVICE_ID, OBJECT_ID);
+
+  bool     is_failed        = false;
+  uint64_t allocated_before = allocations;
+  uint64_t started_at       = now_ns();
+
+  for (size_t i = 0; i < iterations; i++) {
+    bacnet_call_type_t decoded = CALL_UNKNOWN;
+    void*              data    = NULL;
+    int                index   = 0;
+    int                version = 0;
+
+    is_failed =
+         ei_decode_version(request.buff, &index, &version)
+      || decode_bacnet_call_type(request.buff, &index, &decoded)
+      || bacnet_call_malloc(decoded, &data)
+      || decode_bacnet_call(request.buff, &index, decoded, data);
+
+    bacnet_call_free(decoded, data);
+  }
+
+  report(
+    "decode_bacnet_call",
+    BACNET_CALL_ATOMS[type].atom,
+    now_ns() - started_at,
+    allocations - allocated_before,
+    iterations,
+    is_failed
+  );
+
+  ei_x_free(&request);
+}
+
+static int provision(void)
+{
+  size_t bench_count = sizeof(OBJECT_BENCHES) / sizeof(OBJECT_BENCHES[0]);
+
+  if (bench_call_type(CALL_CREATE_GATEWAY, DEVICE_ID, 0))
+    return -1;
+
+  for (size_t b = 0; b < bench_count; b++) {
+    if (bench_call_type(OBJECT_BENCHES[b].create_call, DEVICE_ID, OBJECT_ID))
+      return -1;
+  }
+
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  size_t iterations = DEFAULT_ITERATIONS;
+  int    option     = 0;
+
+  while ((option = getopt(argc, argv, "n:")) != -1) {
+    if (option != 'n') {
+      fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+      return 1;
+    }
+
+    iterations = strtoul(optarg, NULL, 0);
+  }
+
+  if (iterations == 0)
+    iterations = DEFAULT_ITERATIONS;
+
+  log_set_level(ERROR);
+  address_init();
+  bacnet_init_service_handlers();
+
+  if (provision()) {
+    fprintf(stderr, "failed to create benchmark objects\n");
+    return 1;
+  }
+
+  printf(
+    "%-24s %-36s %10s %10s\n",
+    "object",
+    "property",
+    "ns/op",
+    "allocs/op"
+  );
+
+  size_t bench_count = sizeof(OBJECT_BENCHES) / sizeof(OBJECT_BENCHES[0]);
+
+  for (size_t b = 0; b < bench_count; b++) {
+    const int* required    = NULL;
+    const int* optional    = NULL;
+    const int* proprietary = NULL;
+
+    OBJECT_BENCHES[b].property_lists(&required, &optional, &proprietary);
+
+    bench_property_list(&OBJECT_BENCHES[b], required, iterations);
+    bench_property_list(&OBJECT_BENCHES[b], optional, iterations);
+    bench_property_list(&OBJECT_BENCHES[b], proprietary, iterations);
+  }
+
+  for (int type = 0; BACNET_CALL_ATOMS[type].atom != NULL; type++)
+    bench_decode_call((bacnet_call_type_t)type, iterations);
+
+  return 0;
+}
@@ -0,0 +1,398 @@
+/*
+ * Capture replay.
+ *
+ * Feeds a capture recorded with BACNET_CAPTURE back through the request
+ * handlers in a single thread. Port frames go to handle_bacnet_request and
+ * BACnet datagrams to the event loop's dispatch, while timers run on a
+ * virtual clock set from each record's timestamp. Outbound PDUs and port
+ * replies are hashed, so two replays of the same capture can be checked for
+ * identical behaviour; replies that report live counters, such as get_stats,
+ * are expected to differ.
+ *
+ * By default records are replayed as fast as possible. With -r they are
+ * paced to their original timing.
+ *
+ * usage: replay [-r] [-o results.json] capture
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+
+#include <bacnet/basic/services.h>
+
+#include "bacnet.h"
+#include "capture.h"
+#include "log.h"
+#include "timer.h"
+#include "stub_datalink.h"
+
+#define FNV_PRIME 0x100000001b3ULL
+
+typedef struct {
+  size_t    count;
+  size_t    capacity;
+  uint64_t* latencies;
+} latency_set_t;
+
+typedef struct {
+  latency_set_t bacnet;
+  latency_set_t port;
+  size_t        malformed;
+  uint64_t      digest;
+} replay_result_t;
+
+static uint64_t virtual_ms = 0;
+
+static uint64_t virtual_clock(void)
+{
+  return virtual_ms;
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static double cpu_ms(void)
+{
+  struct rusage usage = { 0 };
+  getrusage(RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec * 1e3 + usage.ru_utime.tv_usec / 1e3
+       + usage.ru_stime.tv_sec * 1e3 + usage.ru_stime.tv_usec / 1e3;
+}
+
+static int compare_u64(const void* a, const void* b)
+{
+  uint64_t left  = *(const uint64_t*)a;
+  uint64_t right = *(const uint64_t*)b;
+
+  return (left > right) - (left < right);
+}
+
+static int add_latency(latency_set_t* set, uint64_t latency_ns)
+{
+  if (set->count == set->capacity) {
+    size_t    capacity  = set->capacity ? set->capacity * 2 : 1024;
+    uint64_t* latencies =
+      realloc(set->latencies, capacity * sizeof(uint64_t));
+
+    if (latencies == NULL)
+      return -1;
+
+    set->latencies = latencies;
+    set->capacity  = capacity;
+  }
+
+  set->latencies[set->count++] = latency_ns;
+
+  return 0;
+}
+
+static uint64_t percentile(latency_set_t* set, int percent)
+{
+  return set->count ? set->latencies[set->count * percent / 100] : 0;
+}
+
+static uint8_t* load_capture(const char* path, size_t* size)
+{
+  FILE* file = fopen(path, "rb");
+  if (file == NULL)
+    return NULL;
+
+  uint8_t* data = NULL;
+  long     end  = -1;
+
+  bool is_loaded =
+       fseek(file, 0, SEEK_END) == 0
+    && (end = ftell(file)) >= CAPTURE_MAGIC_LEN
+    && fseek(file, 0, SEEK_SET) == 0
+    && (data = malloc(end)) != NULL
+    && fread(data, 1, end, file) == (size_t)end
+    && memcmp(data, CAPTURE_MAGIC, CAPTURE_MAGIC_LEN) == 0;
+
+  fclose(file);
+
+  if (!is_loaded) {
+    free(data);
+    return NULL;
+  }
+
+  *size = (size_t)end;
+
+  return data;
+}
+
+static void sleep_until(uint64_t started_ns, uint64_t timestamp_us)
+{
+  uint64_t deadline = started_ns + timestamp_us * 1000;
+  uint64_t now      = now_ns();
+
+  if (deadline <= now)
+    return;
+
+  struct timespec delay = {
+    .tv_sec  = (deadline - now) / 1000000000,
+    .tv_nsec = (long)((deadline - now) % 1000000000),
+  };
+
+  nanosleep(&delay, NULL);
+}
+
+static int replay_bacnet(uint8_t* payload, uint32_t length)
+{
+  capture_address_t address = { 0 };
+  BACNET_ADDRESS    src     = { 0 };
+
+  if (length < sizeof(address) || length - sizeof(address) > MAX_MPDU)
+    return -1;
+
+  memcpy(&address, payload, sizeof(address));
+
+  src.mac_len = address.mac_len;
+  src.net     = address.net;
+  src.len     = address.len;
+
+  memcpy(src.mac, address.mac, sizeof(src.mac));
+  memcpy(src.adr, address.adr, sizeof(src.adr));
+
+  bacnet_dispatch_pdu(
+    &src,
+    payload + sizeof(address),
+    (uint16_t)(length - sizeof(address))
+  );
+
+  return 0;
+}
+
+static int replay_port(uint8_t* payload, uint32_t length, uint64_t* digest)
+{
+  char* buffer  = (char*)payload;
+  int   index   = 0;
+  int   version = 0;
+  int   arity   = 0;
+  char  atom[MAXATOMLEN] = { 0 };
+
+  // {:"$gen_call", from, request}, where the sender is not replayed
+  bool is_bad_message =
+       ei_decode_version(buffer, &index, &version)
+    || ei_decode_tuple_header(buffer, &index, &arity)
+    || arity != 3
+    || ei_decode_atom(buffer, &index, atom)
+    || strcmp(atom, "$gen_call")
+    || ei_skip_term(buffer, &index)
+    || (uint32_t)index >= length;
+
+  if (is_bad_message)
+    return -1;
+
+  ei_x_buff reply;
+  ei_x_new(&reply);
+
+  handle_bacnet_request(buffer, &index, &reply);
+
+  for (int i = 0; i < reply.index; i++)
+    *digest = (*digest ^ (uint8_t)reply.buff[i]) * FNV_PRIME;
+
+  ei_x_free(&reply);
+
+  return 0;
+}
+
+static int replay(
+  uint8_t* data,
+  size_t size,
+  bool is_realtime,
+  replay_result_t* result
+) {
+  size_t   offset     = CAPTURE_MAGIC_LEN;
+  uint64_t started_ns = now_ns();
+
+  while (offset + sizeof(capture_record_t) <= size) {
+    capture_record_t record = { 0 };
+    memcpy(&record, data + offset, sizeof(record));
+    offset += sizeof(record);
+
+    // a capture cut short by a crash ends with a partial record
+    if (record.length > size - offset)
+      break;
+
+    uint8_t* payload = data + offset;
+    offset += record.length;
+
+    if (is_realtime)
+      sleep_until(started_ns, record.timestamp_us);
+
+    virtual_ms = record.timestamp_us / 1000;
+    timer_run_expired();
+
+    uint64_t       started_at = now_ns();
+    int            status     = -1;
+    latency_set_t* latencies  = NULL;
+
+    switch (record.kind) {
+      case CAPTURE_BACNET:
+        status    = replay_bacnet(payload, record.length);
+        latencies = &result->bacnet;
+        break;
+
+      case CAPTURE_PORT:
+        status    = replay_port(payload, record.length, &result->digest);
+        latencies = &result->port;
+        break;
+    }
+
+    if (status != 0) {
+      result->malformed++;
+      continue;
+    }
+
+    if (add_latency(latencies, now_ns() - started_at))
+      return -1;
+  }
+
+  timer_run_expired();
+
+  latency_set_t* sets[] = { &result->bacnet, &result->port };
+
+  for (int i = 0; i < 2; i++)
+    qsort(sets[i]->latencies, sets[i]->count, sizeof(uint64_t), compare_u64);
+
+  return 0;
+}
+
+static int usage(const char* name)
+{
+  fprintf(stderr, "usage: %s [-r] [-o results.json] capture\n", name);
+  return 1;
+}
+
+int main(int argc, char** argv)
+{
+  const char* output_path = NULL;
+  bool        is_realtime = false;
+  int         option      = 0;
+
+  while ((option = getopt(argc, argv, "ro:")) != -1) {
+    switch (option) {
+      case 'r':
+        is_realtime = true;
+        break;
+
+      case 'o':
+        output_path = optarg;
+        break;
+
+      default:
+        return usage(argv[0]);
+    }
+  }
+
+  if (optind != argc - 1)
+    return usage(argv[0]);
+
+  size_t   size = 0;
+  uint8_t* data = load_capture(argv[optind], &size);
+
+  if (data == NULL) {
+    fprintf(stderr, "unable to load capture %s\n", argv[optind]);
+    return 1;
+  }
+
+  // events and COV notifications would otherwise be written as port frames
+  int devnull = open("/dev/null", O_WRONLY);
+  dup2(devnull, STDOUT_FILENO);
+
+  log_set_level(ERROR);
+  bacnet_configure();
+  address_init();
+  bacnet_init_service_handlers();
+  timer_set_clock(virtual_clock);
+  srand(1);
+  stub_datalink_reset();
+
+  replay_result_t result = { .digest = STUB_DATALINK_DIGEST_SEED };
+
+  uint64_t started_ns = now_ns();
+  double   started_cpu_ms = cpu_ms();
+
+  if (replay(data, size, is_realtime, &result)) {
+    fprintf(stderr, "out of memory replaying %s\n", argv[optind]);
+    return 1;
+  }
+
+  double wall_ms = (now_ns() - started_ns) / 1e6;
+  double used_ms = cpu_ms() - started_cpu_ms;
+
+  stub_datalink_stats_t datalink = { 0 };
+  stub_datalink_get_stats(&datalink);
+
+  fprintf(
+    stderr,
+    "bacnet records %zu (p50 %lu ns, p99 %lu ns)\n"
+    "port records   %zu (p50 %lu ns, p99 %lu ns)\n"
+    "malformed      %zu\n"
+    "wall %.1f ms, cpu %.1f ms\n"
+    "sent %lu pdus, digest %016lx\n"
+    "reply digest %016lx\n",
+    result.bacnet.count,
+    (unsigned long)percentile(&result.bacnet, 50),
+    (unsigned long)percentile(&result.bacnet, 99),
+    result.port.count,
+    (unsigned long)percentile(&result.port, 50),
+    (unsigned long)percentile(&result.port, 99),
+    result.malformed,
+    wall_ms,
+    used_ms,
+    (unsigned long)datalink.sent,
+    (unsigned long)datalink.digest,
+    (unsigned long)result.digest
+  );
+
+  if (output_path) {
+    FILE* output = fopen(output_path, "w");
+    if (output == NULL) {
+      fprintf(stderr, "unable to open %s: %s\n", output_path, strerror(errno));
+      return 1;
+    }
+
+    fprintf(
+      output,
+      "{\"bacnet\": {\"records\": %zu, \"p50_ns\": %lu, \"p99_ns\": %lu}, "
+      "\"port\": {\"records\": %zu, \"p50_ns\": %lu, \"p99_ns\": %lu}, "
+      "\"malformed\": %zu, \"wall_ms\": %.1f, \"cpu_ms\": %.1f, "
+      "\"sent\": %lu, \"sent_digest\": \"%016lx\", "
+      "\"reply_digest\": \"%016lx\"}\n",
+      result.bacnet.count,
+      (unsigned long)percentile(&result.bacnet, 50),
+      (unsigned long)percentile(&result.bacnet, 99),
+      result.port.count,
+      (unsigned long)percentile(&result.port, 50),
+      (unsigned long)percentile(&result.port, 99),
+      result.malformed,
+      wall_ms,
+      used_ms,
+      (unsigned long)datalink.sent,
+      (unsigned long)datalink.digest,
+      (unsigned long)result.digest
+    );
+
+    fclose(output);
+  }
+
+  free(result.bacnet.latencies);
+  free(result.port.latencies);
+  free(data);
+
+  return 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * Warm restart benchmark.
+ *
+ * Measures the time from an empty bacnetd to the gateway answering a
+ * global Who-Is with an I-Am for every routed device, once by provisioning
+ * the gateway with individual create and set calls as the BEAM does after
+ * a restart (cold), and once by restoring the snapshot that run left
+ * behind (warm). Each run is a forked child, so neither sees the other's
+ * objects. Results are printed as a table.
+ *
+ * usage: snapshot_bench [-d devices] [-p objects] [-f snapshot path]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <bacnet/basic/object/device.h>
+#include <bacnet/basic/services.h>
+#include <bacnet/npdu.h>
+#include <bacnet/whois.h>
+
+#include "bacnet.h"
+#include "log.h"
+#include "snapshot.h"
+#include "timer.h"
+#include "bench_calls.h"
+#include "stub_datalink.h"
+
+#define GATEWAY_INSTANCE 100000
+#define DEFAULT_DEVICES  MAX_NUM_DEVICES
+#define DEFAULT_OBJECTS  30000
+#define DEFAULT_PATH     "snapshot_bench.snapshot"
+
+typedef enum {
+  RUN_COLD,
+  RUN_WARM,
+} run_mode_t;
+
+static uint64_t now_ns(void)
+{
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static uint32_t device_instance(size_t device_index)
+{
+  return GATEWAY_INSTANCE + (uint32_t)device_index;
+}
+
+// object k is analog input instance k of device k % device_count
+static int provision(size_t device_count, size_t object_count)
+{
+  for (size_t d = 0; d < device_count; d++) {
+    bacnet_call_type_t type =
+      d == 0 ? CALL_CREATE_GATEWAY : CALL_CREATE_ROUTED_DEVICE;
+
+    if (bench_call_type(type, device_instance(d), 0))
+      return -1;
+  }
+
+  for (size_t k = 0; k < object_count; k++) {
+    uint32_t device = device_instance(k % device_count);
+
+    bool is_failed =
+         bench_call_type(CALL_CREATE_ROUTED_ANALOG_INPUT, device, k)
+      || bench_call_type(CALL_SET_ROUTED_ANALOG_INPUT_VALUE, device, k);
+
+    if (is_failed)
+      return -1;
+  }
+
+  return 0;
+}
+
+// dispatches a global Who-Is and runs timers until every device answered
+static int await_i_ams(size_t device_count)
+{
+  BACNET_ADDRESS   dest      = { 0 };
+  BACNET_ADDRESS   none      = { 0 };
+  BACNET_ADDRESS   src       = { 0 };
+  BACNET_NPDU_DATA npdu_data = { 0 };
+  uint8_t          pdu[MAX_NPDU + 16] = { 0 };
+
+  // a client at 127.0.0.1:47808 on the local network
+  src.mac_len = 6;
+  src.mac[0]  = 127;
+  src.mac[3]  = 1;
+  src.mac[4]  = 0xBA;
+  src.mac[5]  = 0xC0;
+
+  npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+  int pdu_len = npdu_encode_pdu(&pdu[0], &dest, &none, &npdu_data);
+  pdu_len += whois_encode_apdu(&pdu[pdu_len], -1, -1);
+
+  stub_datalink_reset();
+  bacnet_dispatch_pdu(&src, &pdu[0], (uint16_t)pdu_len);
+
+  stub_datalink_stats_t datalink = { 0 };
+  uint64_t              deadline = now_ns() + 5000000000ULL;
+
+  while (datalink.sent < device_count && now_ns() < deadline) {
+    timer_run_expired();
+    stub_datalink_get_stats(&datalink);
+  }
+
+  return datalink.sent >= device_count ? 0 : -1;
+}
+
+static int run(run_mode_t mode, size_t device_count, size_t object_count)
+{
+  snapshot_restore_result_t restored = { 0 };
+
+  log_set_level(ERROR);
+  address_init();
+  bacnet_init_service_handlers();
+
+  if (snapshot_start()) {
+    fprintf(stderr, "failed to start snapshots\n");
+    return -1;
+  }
+
+  uint64_t started_at = now_ns();
+
+  bool is_loaded =
+    mode == RUN_COLD
+      ? provision(device_count, object_count) == 0
+      : snapshot_restore(handle_bacnet_request, &restored) == 0;
+
+  uint64_t loaded_at   = now_ns();
+  bool     is_failed   = !is_loaded || await_i_ams(device_count);
+  uint64_t answered_at = now_ns();
+
+  if (is_failed) {
+    fprintf(stderr, "%s run failed\n", mode == RUN_COLD ? "cold" : "warm");
+    return -1;
+  }
+
+  uint64_t written_at = answered_at;
+  if (mode == RUN_COLD) {
+    is_failed  = snapshot_write() != 0;
+    written_at = now_ns();
+  }
+
+  fprintf(
+    stderr,
+    "%-6s %8zu %8zu %8u %12.1f %12.1f %12.1f\n",
+    mode == RUN_COLD ? "cold" : "warm",
+    device_count,
+    object_count,
+    restored.records,
+    (loaded_at - started_at) / 1e6,
+    (answered_at - started_at) / 1e6,
+    (written_at - answered_at) / 1e6
+  );
+
+  snapshot_stop();
+
+  return is_failed ? -1 : 0;
+}
+
+static int fork_run(run_mode_t mode, size_t device_count, size_t object_count)
+{
+  pid_t child = fork();
+  if (child == -1)
+    return -1;
+
+  // port events and logs are written to stdout
+  if (child == 0) {
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+
+    _exit(run(mode, device_count, object_count) ? 1 : 0);
+  }
+
+  int status = 0;
+  waitpid(child, &status, 0);
+
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+int main(int argc, char** argv)
+{
+  const char* path         = DEFAULT_PATH;
+  size_t      device_count = DEFAULT_DEVICES;
+  size_t      object_count = DEFAULT_OBJECTS;
+  int         option       = 0;
+
+  while ((option = getopt(argc, argv, "d:p:f:")) != -1) {
+    switch (option) {
+      case 'd':
+        device_count = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'p':
+        object_count = strtoul(optarg, NULL, 0);
+        break;
+
+      case 'f':
+        path = optarg;
+        break;
+
+      default:
+        fprintf(
+          stderr,
+          "usage: %s [-d devices] [-p objects] [-f snapshot path]\n",
+          argv[0]
+        );
+        return 1;
+    }
+  }
+
+  if (device_count == 0 || device_count > MAX_NUM_DEVICES) {
+    fprintf(stderr, "devices must be between 1 and %d\n", MAX_NUM_DEVICES);
+    return 1;
+  }
+
+  // answer Who-Is at once, so only loading is measured
+  char burst[16] = { 0 };
+  snprintf(burst, sizeof(burst), "%d", MAX_NUM_DEVICES);
+
+  setenv("BACNET_SNAPSHOT", path, 1);
+  setenv("BACNET_SNAPSHOT_INTERVAL_MS", "3600000", 1);
+  setenv("BACNET_IAM_WINDOW_MS", "0", 1);
+  setenv("BACNET_IAM_BURST", burst, 1);
+  unlink(path);
+
+  fprintf(
+    stderr,
+    "%-6s %8s %8s %8s %12s %12s %12s\n",
+    "run",
+    "devices",
+    "objects",
+    "records",
+    "load ms",
+    "i-am ms",
+    "write ms"
+  );
+
+  bool is_failed =
+       fork_run(RUN_COLD, device_count, object_count)
+    || fork_run(RUN_WARM, device_count, object_count);
+
+  struct stat info = { 0 };
+  if (!is_failed && stat(path, &info) == 0)
+    fprintf(stderr, "snapshot %s: %ld bytes\n", path, (long)info.st_size);
+
+  return is_failed ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+#ifndef STUB_DATALINK_H
+#define STUB_DATALINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Stands in for src/service/transmit.c in the benchmarks. Outbound PDUs still
+ * pass through the reply cache, but are counted and dropped instead of being
+ * handed to the BACnet/IP datalink. The digest is an FNV-1a hash of every
+ * PDU in order, so two runs can be compared for identical output.
+ */
+
+#define STUB_DATALINK_DIGEST_SEED 0xcbf29ce484222325ULL
+
+typedef struct {
+  uint64_t sent;
+  uint64_t sent_bytes;
+  uint64_t digest;
+} stub_datalink_stats_t;
+
+void stub_datalink_reset(void);
+void stub_datalink_get_stats(stub_datalink_stats_t* stats);
+
+#endif /* STUB_DATALINK_H */
@@ -0,0 +1,118 @@
+/*
+ * Who-Is matching benchmark.
+ *
+ * Compares a linear walk over every routed device, as done by the stack's
+ * Who-Is handler, with a range query over the instance-sorted device index.
+ * Each iteration answers one narrow-range Who-Is.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "device_index.h"
+
+#define QUERY_COUNT   100000
+#define QUERY_WIDTH   16
+#define INSTANCE_SPAN 4000000
+
+static const size_t DEVICE_COUNTS[] = { 10, 1000, 10000 };
+
+static uint32_t instances[DEVICE_INDEX_CAPACITY] = { 0 };
+static uint32_t low_limits[QUERY_COUNT] = { 0 };
+
+static uint64_t now_ns(void)
+{
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static size_t populated = 0;
+
+static void populate(size_t device_count)
+{
+  for (size_t i = 0; i < populated; i++)
+    device_index_remove(instances[i]);
+
+  // instances are unique, so every insert grows the index
+  for (populated = 0; populated < device_count;) {
+    uint32_t instance = 1 + rand() % INSTANCE_SPAN;
+    if (device_index_lookup(instance) >= 0)
+      continue;
+
+    device_index_insert(instance, (uint32_t)populated);
+    instances[populated++] = instance;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  srand(1);
+
+  printf(
+    "%8s %14s %14s %10s\n",
+    "devices",
+    "linear ns/op",
+    "index ns/op",
+    "matches"
+  );
+
+  size_t runs = sizeof(DEVICE_COUNTS) / sizeof(DEVICE_COUNTS[0]);
+
+  for (size_t run = 0; run < runs; run++) {
+    size_t device_count = DEVICE_COUNTS[run];
+    if (device_count > DEVICE_INDEX_CAPACITY)
+      break;
+
+    populate(device_count);
+
+    for (size_t q = 0; q < QUERY_COUNT; q++)
+      low_limits[q] = 1 + rand() % INSTANCE_SPAN;
+
+    size_t   linear_matches = 0;
+    uint64_t start = now_ns();
+
+    for (size_t q = 0; q < QUERY_COUNT; q++) {
+      uint32_t low  = low_limits[q];
+      uint32_t high = low + QUERY_WIDTH;
+
+      for (size_t i = 0; i < device_count; i++) {
+        if (instances[i] >= low && instances[i] <= high)
+          linear_matches++;
+      }
+    }
+
+    uint64_t linear_ns = now_ns() - start;
+
+    device_index_entry_t matches[QUERY_WIDTH + 1] = { 0 };
+    size_t index_matches = 0;
+    start = now_ns();
+
+    for (size_t q = 0; q < QUERY_COUNT; q++) {
+      uint32_t low  = low_limits[q];
+      uint32_t high = low + QUERY_WIDTH;
+
+      index_matches +=
+        device_index_range(low, high, matches, QUERY_WIDTH + 1);
+    }
+
+    uint64_t index_ns = now_ns() - start;
+
+    if (linear_matches != index_matches) {
+      fprintf(stderr, "mismatch: %zu != %zu\n", linear_matches, index_matches);
+      return 1;
+    }
+
+    printf(
+      "%8zu %14.1f %14.1f %10zu\n",
+      device_count,
+      (double)linear_ns / QUERY_COUNT,
+      (double)index_ns / QUERY_COUNT,
+      index_matches
+    );
+  }
+
+  return 0;
+}
@@ -18,6 +18,16 @@ defmodule BACNet do
 
   @doc """
   Start the BACnet client.
+
+  Passing a file path as the `:capture` option records inbound BACnet and
+  port traffic to it, for replay with the `replay` benchmark tool.
+
+  Passing a file path as the `:snapshot` option keeps a snapshot of the
+  devices, objects and present values there, rewritten every
+  `:snapshot_interval` milliseconds when changed. On start, bacnetd
+  restores the snapshot before handling any call and sends the owner
+  `{:snapshot_restored, calls, failed, elapsed_ms}`, after which only
+  changes need to be sent.
   """
   @spec start_link(any, GenServer.options()) :: GenServer.on_start()
   def start_link(args, opts \\ []) do
@@ -26,6 +36,101 @@ defmodule BACNet do
     GenServer.start_link(__MODULE__, args, opts)
   end
 
+  @doc """
+  Sets the least severe level that bacnetd logs. Messages below it are
+  discarded before they are formatted.
+  """
+  @spec set_log_level(pid :: pid, level :: Logger.level()) :: :ok | {:error, term}
+  def set_log_level(pid, level) do
+    GenServer.call(pid, {:set_log_level, level})
+  end
+
+  @doc """
+  Returns bacnetd runtime counters.
+
+  The result is a map of request counts per BACnet service, per port call
+  and per routed device instance. It also holds latency histograms for
+  APDU and port call handling and for commands completed by Elixir, the
+  number of commands that timed out and of COV notifications sent, the
+  current queue depths, the I-Am send rate per second and its peak, the
+  datagrams received and shed on ingress along with the busiest sources,
+  the reply cache counters, and the slab utilization of each object type.
+  """
+  @spec get_stats(pid :: pid) :: {:ok, map} | {:error, term}
+  def get_stats(pid) do
+    GenServer.call(pid, {:get_stats})
+  end
+
+  @doc """
+  Returns the most read and most subscribed object properties.
+
+  The result is a map with `:read` and `:subscribe` lists of
+  `{device_id, object_type, object_id, property, count}` tuples, hottest
+  first, with at most `limit` entries each. Object types and properties
+  are BACnet enumeration values, and counts are approximate upper bounds.
+  """
+  @spec get_hot_points(pid :: pid, limit :: non_neg_integer) :: {:ok, map} | {:error, term}
+  def get_hot_points(pid, limit \\ 10) do
+    GenServer.call(pid, {:get_hot_points, limit})
+  end
+
+  @doc """
+  Returns the most recent event loop timings, oldest first.
+
+  Every dispatched packet and port write is recorded, as well as receive
+  and timer stages that overran. The owner process is also sent
+  `{:stall, stage, elapsed_ms}` when the event loop is stuck in a stage
+  for longer than the `:stall_threshold` option, in milliseconds.
+  """
+  @spec get_flight_recorder(pid :: pid) :: {:ok, [map]} | {:error, term}
+  def get_flight_recorder(pid) do
+    GenServer.call(pid, {:get_flight_recorder})
+  end
+
+  @doc """
+  Returns bacnetd heap usage.
+
+  The result is a map with the live bytes, live allocations and peak bytes
+  of the whole daemon under `:total`, and of each subsystem under
+  `:subsystems`. It also holds the object count and object bytes of each
+  object type under `:object_types`, and of each routed device instance
+  under `:devices`.
+  """
+  @spec get_memory(pid :: pid) :: {:ok, map} | {:error, term}
+  def get_memory(pid) do
+    GenServer.call(pid, {:get_memory})
+  end
+
+  @doc """
+  Creates a routed device and all of its objects in a single call.
+
+  The device is `{bacnet_id, name, description, model, firmware_version}`
+  and is created unless it already exists. Each object is a tuple of its
+  type, `:analog_input`, `:multistate_input`, `:command`,
+  `:characterstring_value` or `:binary_input`, followed by the arguments
+  of the matching `create_*` call without the device ID.
+
+  Objects are created even when some fail. The result lists the failures
+  as `{type, bacnet_id, reason}` tuples, and is empty when every object
+  was created.
+  """
+  @spec provision_device(
+          pid :: pid,
+          device :: tuple,
+          objects :: [tuple],
+          timeout :: timeout
+        ) :: {:ok, [{atom, non_neg_integer, atom}]} | {:error, term}
+  def provision_device(pid, device, objects, timeout \\ :infinity) do
+    {bacnet_id, name, description, model, firmware_version} = device
+
+    GenServer.call(
+      pid,
+      {:provision_device, bacnet_id, name, description, model,
+       firmware_version, objects},
+      timeout
+    )
+  end
+
   @impl GenServer
   def init(args) do
     bacnetd_exe = Path.join(:code.priv_dir(:bacnet), "bacnetd")
@@ -36,6 +141,13 @@ defmodule BACNet do
         {~c"BACNET_NETWORK_ID", args[:network_id]},
         {~c"BACNET_VENDOR_ID", args[:vendor_id]},
         {~c"BACNET_VENDOR_NAME", args[:vendor_name]},
+        {~c"BACNET_IAM_WINDOW_MS", args[:i_am_window]},
+        {~c"BACNET_IAM_BURST", args[:i_am_burst]},
+        {~c"BACNET_LOG_LEVEL", args[:log_level]},
+        {~c"BACNET_STALL_MS", args[:stall_threshold]},
+        {~c"BACNET_CAPTURE", args[:capture]},
+        {~c"BACNET_SNAPSHOT", args[:snapshot]},
+        {~c"BACNET_SNAPSHOT_INTERVAL_MS", args[:snapshot_interval]},
       ]
       |> Enum.reject(fn {_key, value} -> is_nil(value) end)
       |> Enum.map(fn {key, value} -> {key, to_charlist(value)} end)
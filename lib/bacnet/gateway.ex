@@ -56,4 +56,26 @@ defmodule BACNet.Gateway do
       firmware_version,
     })
   end
+
+  @doc """
+  Deletes a routed device and all of its objects.
+
+  The objects' COV subscriptions are cancelled, and the device stops
+  answering as soon as the call starts. Objects are deleted in batches
+  so that BACnet requests to other devices are served in between. The
+  Gateway device cannot be deleted. If an object fails to be deleted, the
+  device is kept with the objects left and an error is returned.
+
+  ## Parameters
+
+  - `pid`: The PID of the GenServer managing the BACnet communication.
+  - `device_id`: The instance number of the routed device.
+  """
+  @spec delete_routed_device(
+    pid :: pid,
+    device_id :: integer
+  ) :: :ok | {:error, term}
+  def delete_routed_device(pid, device_id) do
+    GenServer.call(pid, {:delete_routed_device, device_id})
+  end
 end
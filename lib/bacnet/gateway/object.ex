@@ -149,6 +149,10 @@ defmodule BACNet.Gateway.Object do
   @doc """
   Set the status of an active command.
 
+  The BACnet client that wrote the command is answered with a SimpleACK
+  or an Error only now, if it still waits. A command whose status isn't
+  set in time fails on its own.
+
   ## Parameters
 
     - `pid`: The PID of the GenServer managing BACnet communications.
@@ -266,4 +270,65 @@ defmodule BACNet.Gateway.Object do
       value
     })
   end
+
+  @doc """
+  Set the action lists of a command object.
+
+  Writing `n` to the command's present value executes the `n`th list
+  within bacnetd, in order, instead of sending the command to be completed
+  with `set_command_status/4`. Lists past the ones given are emptied, and a
+  command whose list is empty is still sent. Post delays aren't supported.
+
+  Each action is a tuple of
+  `{device_id, object_type, object_id, property, value, priority, quit_on_failure}`:
+
+    - `object_type`: One of `:analog_input`, `:multistate_input`,
+      `:binary_input`, `:characterstring_value`, `:command` or `:device`.
+    - `property`: `:present_value` or a BACnet property identifier.
+    - `value`: A boolean, integer, float, `{:enumerated, integer}`, or `nil`
+      for BACnet NULL.
+    - `priority`: The write priority, 1 to 16, or 0 for none.
+
+  ## Parameters
+
+    - `pid`: The PID of the GenServer managing BACnet communications.
+    - `device_id`: The ID of the BACnet device the command belongs to.
+    - `object_id`: The ID of the command object.
+    - `actions`: Up to eight lists of actions.
+  """
+  @spec set_command_actions(
+    pid       :: pid,
+    device_id :: integer,
+    object_id :: integer,
+    actions   :: [[tuple]]
+  ) :: :ok | {:error, term}
+  def set_command_actions(pid, device_id, object_id, actions) do
+    GenServer.call(pid, {
+      :set_command_actions,
+      device_id,
+      object_id,
+      actions
+    })
+  end
+
+  @doc """
+  Delete an object of any type.
+
+  The object's COV subscriptions are cancelled and the device's
+  Database_Revision is incremented.
+
+  ## Parameters
+
+    - `pid`: The PID of the GenServer managing BACnet communications.
+    - `device_id`: The ID of the BACnet device the object belongs to.
+    - `object_id`: The ID of the object to delete.
+  """
+  @spec delete(
+    pid       :: pid,
+    device_id :: integer,
+    object_id :: integer
+  ) :: :ok | {:error, term}
+  def delete(pid, device_id, object_id) do
+    GenServer.call(pid, {:delete_object, device_id, object_id})
+  end
 end
@@ -0,0 +1,193 @@
+defmodule BACNet.Gateway.Object.Spec do
+  use ESpec
+
+  alias BACNet.Gateway.Object
+  alias BACNet.Spec.Client
+  alias BACNet.Spec.Daemon
+
+  describe "set_command_actions/4" do
+    before do
+      pid     = Daemon.start()
+      device  = {10, "Device 10", "A device", "Model", "1.0"}
+      objects = [
+        {:analog_input, 1, "AI 1", "Temperature", :degrees_celsius},
+        {:multistate_input, 2, "MSI 1", "Mode", ["Off", "On"]},
+        {:command, 3, "CMD 1", "Start", nil},
+        {:binary_input, 5, "BI 1", "Door", "Open", "Closed", :normal, false},
+      ]
+
+      {:ok, []} = BACNet.provision_device(pid, device, objects)
+
+      {:shared, pid: pid, client: Client.open()}
+    end
+
+    finally do
+      Client.close(shared.client)
+      Daemon.stop(shared.pid)
+    end
+
+    let :action, do: {10, :analog_input, 1, :present_value, 21.5, 8, false}
+
+    it "accepts a property given as an atom or an integer, and every value form" do
+      actions = [
+        [
+          {10, :analog_input, 1, :present_value, 21.5, 8, false},
+          {10, :binary_input, 5, :present_value, true, 0, true},
+        ],
+        [
+          {10, :multistate_input, 2, :present_value, 2, 16, false},
+          {10, :binary_input, 5, 85, {:enumerated, 1}, 0, false},
+          {10, :analog_input, 1, :present_value, nil, 8, false},
+          {10, :analog_input, 1, :present_value, -4, 8, false},
+        ],
+      ]
+
+      expect(Object.set_command_actions(shared.pid, 10, 3, actions))
+      |> to(eq :ok)
+    end
+
+    it "rejects an action that isn't a 7-tuple" do
+      action = Tuple.delete_at(action(), 6)
+
+      expect(Object.set_command_actions(shared.pid, 10, 3, [[action]]))
+      |> to(eq {:error, :bad_request})
+    end
+
+    it "rejects a property atom other than :present_value" do
+      action = put_elem(action(), 3, :object_name)
+
+      expect(Object.set_command_actions(shared.pid, 10, 3, [[action]]))
+      |> to(eq {:error, :bad_request})
+    end
+
+    it "rejects an object type that actions can't name" do
+      action = put_elem(action(), 1, :analog_output)
+
+      expect(Object.set_command_actions(shared.pid, 10, 3, [[action]]))
+      |> to(eq {:error, :bad_request})
+    end
+
+    it "rejects a value of no BACnet type it maps to" do
+      for value <- [{:real, 21.5}, {:enumerated, -1}, "21.5"] do
+        action = put_elem(action(), 4, value)
+
+        expect(Object.set_command_actions(shared.pid, 10, 3, [[action]]))
+        |> to(eq {:error, :bad_request})
+      end
+    end
+
+    it "fails for an object that isn't a command" do
+      expect(Object.set_command_actions(shared.pid, 10, 1, [[action()]]))
+      |> to(eq {:error, :failed_processing})
+    end
+
+    it "runs the action list when the command is written, without Elixir" do
+      actions = [
+        [
+          {10, :analog_input, 1, :present_value, 21.5, 8, false},
+          {10, :multistate_input, 2, :present_value, 2, 8, false},
+          {10, :binary_input, 5, 85, {:enumerated, 1}, 8, false},
+        ],
+      ]
+
+      :ok = Object.set_command_actions(shared.pid, 10, 3, actions)
+
+      expect(Client.write_property(shared.client, 10, {:command, 3}, :present_value, {:unsigned, 1}))
+      |> to(eq :ok)
+
+      expect(Client.read_property(shared.client, 10, {:analog_input, 1}, :present_value))
+      |> to(eq {:ok, 21.5})
+
+      expect(Client.read_property(shared.client, 10, {:multistate_input, 2}, :present_value))
+      |> to(eq {:ok, 2})
+
+      expect(Client.read_property(shared.client, 10, {:binary_input, 5}, :present_value))
+      |> to(eq {:ok, {:enumerated, 1}})
+
+      refute_received {:command, 10, 3, _value}
+    end
+
+    it "stops the action list at a failed action that quits on failure" do
+      actions = [
+        [
+          {10, :analog_input, 99, :present_value, 1.0, 8, true},
+          {10, :analog_input, 1, :present_value, 21.5, 8, false},
+        ],
+      ]
+
+      :ok = Object.set_command_actions(shared.pid, 10, 3, actions)
+      {:ok, value} = Client.read_property(shared.client, 10, {:analog_input, 1}, :present_value)
+
+      expect(Client.write_property(shared.client, 10, {:command, 3}, :present_value, {:unsigned, 1}))
+      |> to(eq :ok)
+
+      expect(Client.read_property(shared.client, 10, {:analog_input, 1}, :present_value))
+      |> to(eq {:ok, value})
+    end
+
+    it "sends Elixir a value that has no action list" do
+      :ok = Object.set_command_actions(shared.pid, 10, 3, [[action()]])
+
+      client = shared.client
+      write  = Task.async(fn ->
+        Client.write_property(client, 10, {:command, 3}, :present_value, {:unsigned, 2})
+      end)
+
+      assert_receive {:command, 10, 3, 2}, 1_000
+      :ok = Object.set_command_status(shared.pid, 10, 3, :succeeded)
+
+      expect(Task.await(write)) |> to(eq :ok)
+    end
+  end
+
+  describe "delete/3" do
+    before do
+      pid     = Daemon.start()
+      device  = {10, "Device 10", "A device", "Model", "1.0"}
+      objects = [{:analog_input, 1, "AI 1", "Temperature", :degrees_celsius}]
+
+      {:ok, []} = BACNet.provision_device(pid, device, objects)
+
+      {:shared, pid: pid, client: Client.open()}
+    end
+
+    finally do
+      Client.close(shared.client)
+      Daemon.stop(shared.pid)
+    end
+
+    it "deletes the object and bumps the device's revision" do
+      {:ok, revision} = Client.database_revision(shared.client, 10)
+
+      expect(Object.delete(shared.pid, 10, 1)) |> to(eq :ok)
+
+      expect(Client.read_property(shared.client, 10, {:analog_input, 1}, :object_name))
+      |> to(eq {:error, :error})
+
+      expect(Client.database_revision(shared.client, 10))
+      |> to(eq {:ok, revision + 1})
+    end
+
+    it "frees the object's name" do
+      :ok = Object.delete(shared.pid, 10, 1)
+
+      expect(Object.create_analog_input(shared.pid, 10, 2, "AI 1", "Temperature", :degrees_celsius))
+      |> to(eq :ok)
+    end
+
+    it "fails for an unknown object, leaving the revision alone" do
+      {:ok, revision} = Client.database_revision(shared.client, 10)
+
+      expect(Object.delete(shared.pid, 10, 99))
+      |> to(eq {:error, :failed_processing})
+
+      expect(Client.database_revision(shared.client, 10))
+      |> to(eq {:ok, revision})
+    end
+
+    it "fails for an unknown device" do
+      expect(Object.delete(shared.pid, 99, 1))
+      |> to(eq {:error, :failed_processing})
+    end
+  end
+end
@@ -0,0 +1,62 @@
+defmodule BACNet.Gateway.Spec do
+  use ESpec
+
+  alias BACNet.Gateway
+  alias BACNet.Gateway.Object
+  alias BACNet.Spec.Client
+  alias BACNet.Spec.Daemon
+
+  describe "delete_routed_device/2" do
+    before do
+      pid     = Daemon.start()
+      device  = {10, "Device 10", "A device", "Model", "1.0"}
+      objects = [
+        {:analog_input, 1, "AI 1", "Temperature", :degrees_celsius},
+        {:binary_input, 5, "BI 1", "Door", "Open", "Closed", :normal, false},
+      ]
+
+      {:ok, []} = BACNet.provision_device(pid, device, objects)
+
+      {:shared, pid: pid, client: Client.open()}
+    end
+
+    finally do
+      Client.close(shared.client)
+      Daemon.stop(shared.pid)
+    end
+
+    it "stops routing to the device and deletes its objects" do
+      expect(Gateway.delete_routed_device(shared.pid, 10)) |> to(eq :ok)
+
+      expect(Client.database_revision(shared.client, 10))
+      |> to(match_pattern {:error, _})
+
+      expect(Object.delete(shared.pid, 10, 1))
+      |> to(eq {:error, :failed_processing})
+    end
+
+    it "creates a device in the deleted one's place without its objects" do
+      :ok = Gateway.delete_routed_device(shared.pid, 10)
+      :ok = Gateway.create_routed_device(shared.pid, 10, "Device 10", "A device", "Model", "1.0")
+
+      expect(Client.read_property(shared.client, 10, {:analog_input, 1}, :object_name))
+      |> to(eq {:error, :error})
+
+      expect(Object.create_analog_input(shared.pid, 10, 1, "AI 1", "Temperature", :degrees_celsius))
+      |> to(eq :ok)
+    end
+
+    it "never deletes the gateway" do
+      expect(Gateway.delete_routed_device(shared.pid, Daemon.gateway_id()))
+      |> to(eq {:error, :failed_processing})
+
+      expect(Client.database_revision(shared.client, Daemon.gateway_id()))
+      |> to(match_pattern {:ok, _})
+    end
+
+    it "fails for an unknown device" do
+      expect(Gateway.delete_routed_device(shared.pid, 99))
+      |> to(eq {:error, :failed_processing})
+    end
+  end
+end
@@ -1,5 +1,98 @@
 defmodule BACNet.Spec do
   use ESpec
 
+  alias BACNet.Gateway
+  alias BACNet.Spec.Client
+  alias BACNet.Spec.Daemon
+
   specify do: expect true |> to(eq true)
+
+  describe "provision_device/4" do
+    before do
+      {:shared, pid: Daemon.start(), client: Client.open()}
+    end
+
+    finally do
+      Client.close(shared.client)
+      Daemon.stop(shared.pid)
+    end
+
+    let :device, do: {10, "Device 10", "A device", "Model", "1.0"}
+
+    let :objects do
+      [
+        {:analog_input, 1, "AI 1", "Temperature", :degrees_celsius},
+        {:multistate_input, 2, "MSI 1", "Mode", ["Off", "On"]},
+        {:command, 3, "CMD 1", "Start", nil},
+        {:characterstring_value, 4, "CSV 1", "Label", "hello"},
+        {:binary_input, 5, "BI 1", "Door", "Open", "Closed", :normal, false},
+      ]
+    end
+
+    it "creates the device and every object" do
+      expect(BACNet.provision_device(shared.pid, device(), objects()))
+      |> to(eq {:ok, []})
+
+      for object <- objects() do
+        type = elem(object, 0)
+        id   = elem(object, 1)
+        name = elem(object, 2)
+
+        expect(Client.read_property(shared.client, 10, {type, id}, :object_name))
+        |> to(eq {:ok, name})
+      end
+    end
+
+    it "lists the objects that fail, and creates the rest" do
+      objects =
+        objects() ++
+          [
+            {:binary_input, 7, "AI 1", "Taken", "On", "Off", :normal, false},
+            {:analog_input, 6, "AI 6", "Distance", :furlongs},
+          ]
+
+      expect(BACNet.provision_device(shared.pid, device(), objects))
+      |> to(eq {:ok, [
+        {:analog_input, 6, :bad_request},
+        {:binary_input, 7, :failed_processing},
+      ]})
+
+      expect(Client.read_property(shared.client, 10, {:analog_input, 1}, :object_name))
+      |> to(eq {:ok, "AI 1"})
+
+      expect(Client.read_property(shared.client, 10, {:analog_input, 6}, :object_name))
+      |> to(eq {:error, :error})
+
+      expect(Client.read_property(shared.client, 10, {:binary_input, 7}, :object_name))
+      |> to(eq {:error, :error})
+    end
+
+    it "bumps the device's revision once for all of its objects" do
+      :ok = Gateway.create_routed_device(shared.pid, 10, "Device 10", "A device", "Model", "1.0")
+      {:ok, revision} = Client.database_revision(shared.client, 10)
+
+      {:ok, []} = BACNet.provision_device(shared.pid, device(), objects())
+
+      expect(Client.database_revision(shared.client, 10))
+      |> to(eq {:ok, revision + 1})
+    end
+
+    it "leaves the revision alone when no object is created" do
+      :ok = Gateway.create_routed_device(shared.pid, 10, "Device 10", "A device", "Model", "1.0")
+      {:ok, revision} = Client.database_revision(shared.client, 10)
+
+      objects = [{:analog_input, 6, "AI 6", "Distance", :furlongs}]
+      {:ok, [_failure]} = BACNet.provision_device(shared.pid, device(), objects)
+
+      expect(Client.database_revision(shared.client, 10))
+      |> to(eq {:ok, revision})
+    end
+
+    it "rejects a device that bacnetd can't decode" do
+      device = {10, :device_10, "A device", "Model", "1.0"}
+
+      expect(BACNet.provision_device(shared.pid, device, objects()))
+      |> to(eq {:error, :bad_request})
+    end
+  end
 end
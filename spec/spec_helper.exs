@@ -1,3 +1,228 @@
+defmodule BACNet.Spec.Daemon do
+  @moduledoc false
+
+  # Runs a real bacnetd, with its gateway, on the loopback interface. Its
+  # routed devices are reached through the gateway's virtual network.
+
+  alias BACNet.Gateway
+
+  @gateway_id 1
+  @network_id 2
+
+  def gateway_id, do: @gateway_id
+  def network_id, do: @network_id
+
+  def start do
+    {:ok, pid} =
+      BACNet.start_link(
+        network_interface: System.get_env("BACNET_SPEC_IFACE", "lo"),
+        network_id: @network_id
+      )
+
+    :ok = Gateway.create(pid, @gateway_id, "Gateway", "Spec", "Spec", "1.0")
+
+    pid
+  end
+
+  # bacnetd exits once its port is closed, and is waited for so that the
+  # next spec can bind the BACnet/IP port.
+  def stop(pid) do
+    {:os_pid, os_pid} = Port.info(:sys.get_state(pid).port, :os_pid)
+
+    GenServer.stop(pid)
+    wait_for_exit(os_pid, 50)
+  end
+
+  defp wait_for_exit(os_pid, tries) do
+    if tries > 0 and File.exists?("/proc/#{os_pid}") do
+      Process.sleep(100)
+      wait_for_exit(os_pid, tries - 1)
+    else
+      :ok
+    end
+  end
+end
+
+defmodule BACNet.Spec.Client do
+  @moduledoc false
+
+  # A minimal BACnet/IP client, enough to read and write the properties of
+  # routed devices as a BACnet client would.
+
+  import Bitwise
+
+  alias BACNet.Spec.Daemon
+
+  @bacnet_port 47808
+  @timeout 1_000
+
+  @read_property 12
+  @write_property 15
+
+  @object_types %{
+    analog_input: 0,
+    binary_input: 3,
+    command: 7,
+    device: 8,
+    multistate_input: 13,
+    characterstring_value: 40,
+  }
+
+  @properties %{
+    object_name: 77,
+    present_value: 85,
+    database_revision: 155,
+  }
+
+  def open do
+    {:ok, socket} = :gen_udp.open(0, [:binary, active: false, ip: {127, 0, 0, 1}])
+
+    socket
+  end
+
+  def close(socket), do: :gen_udp.close(socket)
+
+  def read_property(socket, device_id, object, property) do
+    request(socket, device_id, @read_property, [
+      encode_object(object),
+      encode_property(property),
+    ])
+  end
+
+  def write_property(socket, device_id, object, property, value) do
+    request(socket, device_id, @write_property, [
+      encode_object(object),
+      encode_property(property),
+      <<0x3E>>,
+      encode_value(value),
+      <<0x3F>>,
+    ])
+  end
+
+  def database_revision(socket, device_id) do
+    read_property(socket, device_id, {:device, device_id}, :database_revision)
+  end
+
+  defp request(socket, device_id, service, service_data) do
+    invoke_id = :erlang.unique_integer([:positive]) |> rem(256)
+
+    # routed devices are addressed by their virtual MAC on the gateway's
+    # network, and the gateway itself directly; a reply is expected
+    npdu =
+      if device_id == Daemon.gateway_id() do
+        <<1, 0x04>>
+      else
+        <<1, 0x24, Daemon.network_id()::16, 3, device_id::24, 255>>
+      end
+    apdu = [<<0x00, 0x05, invoke_id, service>> | service_data]
+    data = IO.iodata_to_binary([npdu, apdu])
+
+    datagram = <<0x81, 0x0A, (byte_size(data) + 4)::16, data::binary>>
+    :ok = :gen_udp.send(socket, {127, 0, 0, 1}, @bacnet_port, datagram)
+
+    deadline = System.monotonic_time(:millisecond) + @timeout
+    receive_reply(socket, invoke_id, deadline)
+  end
+
+  defp receive_reply(socket, invoke_id, deadline) do
+    timeout = max(deadline - System.monotonic_time(:millisecond), 0)
+
+    with {:ok, {_address, _port, datagram}} <- :gen_udp.recv(socket, 0, timeout) do
+      case decode_reply(datagram, invoke_id) do
+        :skip -> receive_reply(socket, invoke_id, deadline)
+        reply -> reply
+      end
+    end
+  end
+
+  defp encode_object({type, instance}) do
+    <<0x0C, Map.fetch!(@object_types, type)::10, instance::22>>
+  end
+
+  defp encode_property(property) do
+    <<0x1A, Map.fetch!(@properties, property)::16>>
+  end
+
+  defp encode_value({:unsigned, value}) when value < 256, do: <<0x21, value>>
+
+  defp decode_reply(<<0x81, _function, _length::16, npdu::binary>>, invoke_id) do
+    case skip_npdu(npdu) do
+      {:ok, apdu} -> decode_apdu(apdu, invoke_id)
+      :skip -> :skip
+    end
+  end
+
+  defp decode_reply(_datagram, _invoke_id), do: :skip
+
+  # network layer messages are never a reply
+  defp skip_npdu(<<1, control, rest::binary>>) when (control &&& 0x80) == 0 do
+    has_destination = (control &&& 0x20) != 0
+    has_source      = (control &&& 0x08) != 0
+
+    rest = if has_destination, do: skip_address(rest), else: rest
+    rest = if has_source, do: skip_address(rest), else: rest
+
+    case {has_destination, rest} do
+      {true, <<_hop_count, apdu::binary>>} -> {:ok, apdu}
+      {false, apdu} -> {:ok, apdu}
+    end
+  end
+
+  defp skip_npdu(_npdu), do: :skip
+
+  defp skip_address(<<_network::16, length, _address::binary-size(length), rest::binary>>) do
+    rest
+  end
+
+  defp decode_apdu(<<0x20, invoke_id, _service>>, invoke_id), do: :ok
+
+  defp decode_apdu(<<0x30, invoke_id, @read_property, ack::binary>>, invoke_id) do
+    <<0x0C, _object::32, rest::binary>> = ack
+    <<0x3E, value::binary>> = skip_context_tag(rest)
+
+    decode_value(value)
+  end
+
+  defp decode_apdu(<<0x50, invoke_id, _error::binary>>, invoke_id), do: {:error, :error}
+  defp decode_apdu(<<0x60, invoke_id, _reason>>, invoke_id), do: {:error, :reject}
+
+  defp decode_apdu(<<type, invoke_id, _reason>>, invoke_id) when (type &&& 0xF0) == 0x70 do
+    {:error, :abort}
+  end
+
+  defp decode_apdu(_apdu, _invoke_id), do: :skip
+
+  defp skip_context_tag(<<tag, rest::binary>>) do
+    length = tag &&& 0x07
+    <<_data::binary-size(length), rest::binary>> = rest
+
+    rest
+  end
+
+  defp decode_value(<<tag, rest::binary>>) do
+    tag_number = tag >>> 4
+    length     = tag &&& 0x07
+
+    # a boolean is held in the length of its tag
+    if tag_number == 1 do
+      {:ok, length == 1}
+    else
+      {length, rest} = value_length(length, rest)
+      <<data::binary-size(length), _rest::binary>> = rest
+
+      decode_primitive(tag_number, data)
+    end
+  end
+
+  defp value_length(5, <<length, rest::binary>>) when length < 254, do: {length, rest}
+  defp value_length(length, rest), do: {length, rest}
+
+  defp decode_primitive(2, data), do: {:ok, :binary.decode_unsigned(data)}
+  defp decode_primitive(4, <<real::float-32>>), do: {:ok, real}
+  defp decode_primitive(7, <<0, string::binary>>), do: {:ok, string}
+  defp decode_primitive(9, data), do: {:ok, {:enumerated, :binary.decode_unsigned(data)}}
+end
+
 ESpec.configure fn(config) ->
   config.before fn(tags) ->
     {:shared, tags: tags}
@@ -1,4 +1,5 @@
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 
 #include <bacnet/bactext.h>
@@ -6,15 +7,37 @@
 #include <bacnet/basic/object/device.h>
 #include <bacnet/basic/object/routed_analog_input.h>
 #include <bacnet/basic/object/routed_multistate_input.h>
+#include <bacnet/basic/object/routed_object.h>
 #include <bacnet/datalink/datalink.h>
 #include <bacnet/datalink/dlenv.h>
 
 #include "bacnet.h"
+#include "capture.h"
+#include "device_index.h"
 #include "log.h"
+#include "memory.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "timer.h"
+#include "watchdog.h"
 #include "protocol/decode_call.h"
+#include "protocol/encode_stats.h"
+#include "protocol/event.h"
 #include "object/binary_input.h"
 #include "object/characterstring_value.h"
 #include "object/command.h"
+#include "object/name_index.h"
+#include "object/string_arena.h"
+#include "object/value_table.h"
+#include "service/deferred_reply.h"
+#include "service/ingress.h"
+#include "service/pdu.h"
+#include "service/read_property.h"
+#include "service/reply_cache.h"
+#include "service/segment.h"
+#include "service/subscribe_cov.h"
+#include "service/who_has.h"
+#include "service/who_is.h"
 
 #define REPLY_OK(reply) \
   ei_x_encode_atom(reply, "ok")
@@ -27,35 +50,99 @@
 static pthread_t thread_id;
 pthread_mutex_t exit_signal_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool should_exit = false;
+
+// port calls wait while the event loop restores the snapshot
+static atomic_bool     is_ready = true;
+static pthread_mutex_t ready_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  ready_signal = PTHREAD_COND_INITIALIZER;
 static int bacnet_network_id = 1000;
 
-static int init_service_handlers();
+// held while BACnet requests and port calls touch the stack's objects
+static pthread_mutex_t stack_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// the stack cannot remove routed devices, so deleted ones leave their slot
+// to the next device created
+static bool is_retired[MAX_NUM_DEVICES] = { 0 };
+
+// a bulk call counts its changes, and bumps Database_Revision once at the
+// end; both are only set while the bulk call holds the stack lock, so that
+// changes made by other threads in between are never absorbed
+static bool   is_bulk_change = false;
+static size_t bulk_changes   = 0;
+
 static void* event_loop(void* arg);
+static void database_changed(void);
+static void scan_values(void* arg);
+static void dispatch_call(char* buffer, int* index, ei_x_buff* reply);
+
+typedef int (*call_handler_t)(void* data, ei_x_buff* reply);
+
+static int handle_create_gateway(
+  create_routed_device_t* device,
+  ei_x_buff* reply);
+
+static int handle_create_routed_device(
+  create_routed_device_t* device,
+  ei_x_buff* reply);
+
+static int handle_create_routed_analog_input(
+  create_routed_analog_input_t* params,
+  ei_x_buff* reply);
+
+static int handle_set_routed_analog_input_value(
+  set_routed_analog_input_value_t* params,
+  ei_x_buff* reply);
+
+static int handle_create_routed_multistate_input(
+  create_routed_multistate_input_t* params,
+  ei_x_buff* reply);
+
+static int handle_set_routed_multistate_value(
+  set_routed_multistate_input_value_t* params,
+  ei_x_buff* reply);
+
+static int handle_create_routed_command(
+  create_routed_command_t* params,
+  ei_x_buff* reply);
+
+static int handle_set_routed_command_status(
+  set_routed_command_status_t* params,
+  ei_x_buff* reply);
 
-typedef int (*call_handler_t)(void* data);
-static int handle_create_gateway(create_routed_device_t* device);
-static int handle_create_routed_device(create_routed_device_t* device);
+static int handle_create_characterstring_value(
+  create_characterstring_value_t* params,
+  ei_x_buff* reply);
 
-static int
-handle_create_routed_analog_input(create_routed_analog_input_t* params);
+static int handle_create_binary_input(
+  create_binary_input_t* params,
+  ei_x_buff* reply);
 
-static int
-handle_set_routed_analog_input_value(set_routed_analog_input_value_t* params);
+static int handle_set_binary_input_value(
+  set_binary_input_value_t* params,
+  ei_x_buff* reply);
 
-static int
-handle_create_routed_multistate_input(create_routed_multistate_input_t* params);
+static int handle_set_log_level(set_log_level_t* params, ei_x_buff* reply);
+static int handle_get_stats(get_stats_t* params, ei_x_buff* reply);
+static int handle_get_hot_points(get_hot_points_t* params, ei_x_buff* reply);
 
-static int
-handle_set_routed_multistate_value(set_routed_multistate_input_value_t* params);
+static int handle_get_flight_recorder(
+  get_flight_recorder_t* params,
+  ei_x_buff* reply);
 
-static int handle_create_routed_command(create_routed_command_t* params);
-static int handle_set_routed_command_status(set_routed_command_status_t* params);
+static int handle_provision_device(
+  provision_device_t* params,
+  ei_x_buff* reply);
 
-static int
-handle_create_characterstring_value(create_characterstring_value_t* params);
+static int handle_get_memory(get_memory_t* params, ei_x_buff* reply);
+static int handle_delete_object(delete_object_t* params, ei_x_buff* reply);
 
-static int handle_create_binary_input(create_binary_input_t* params);
-static int handle_set_binary_input_value(set_binary_input_value_t* params);
+static int handle_delete_routed_device(
+  delete_routed_device_t* params,
+  ei_x_buff* reply);
+
+static int handle_set_command_actions(
+  set_command_actions_t* params,
+  ei_x_buff* reply);
 
 static call_handler_t CALL_HANDLERS_BY_TYPE[] = {
   (call_handler_t)handle_create_gateway,
@@ -69,8 +156,29 @@ static call_handler_t CALL_HANDLERS_BY_TYPE[] = {
   (call_handler_t)handle_create_characterstring_value,
   (call_handler_t)handle_create_binary_input,
   (call_handler_t)handle_set_binary_input_value,
+  (call_handler_t)handle_set_log_level,
+  (call_handler_t)handle_get_stats,
+  (call_handler_t)handle_get_hot_points,
+  (call_handler_t)handle_get_flight_recorder,
+  (call_handler_t)handle_provision_device,
+  (call_handler_t)handle_get_memory,
+  (call_handler_t)handle_delete_object,
+  (call_handler_t)handle_delete_routed_device,
+  (call_handler_t)handle_set_command_actions,
 };
 
+/**
+ * @brief Reads the BACnet configuration from the environment.
+ *
+ * The routed network number may be set with `BACNET_NETWORK_ID`.
+ */
+void bacnet_configure()
+{
+  const char* network_id_raw = getenv("BACNET_NETWORK_ID");
+  if (network_id_raw)
+    bacnet_network_id = (int)strtol(network_id_raw, NULL, 0);
+}
+
 /**
  * @brief Initializes BACnet services.
  *
@@ -81,11 +189,11 @@ static call_handler_t CALL_HANDLERS_BY_TYPE[] = {
  */
 int bacnet_start_services()
 {
-  const char* network_id_raw = getenv("BACNET_NETWORK_ID");
-  if (network_id_raw)
-    bacnet_network_id = (int)strtol(network_id_raw, NULL, 0);
+  bacnet_configure();
 
   should_exit = false;
+  atomic_store(&is_ready, false);
+
   if (pthread_create(&thread_id, NULL, &event_loop, NULL) != 0) {
     LOG_ERROR("bacnetd: failed to create bacnet thread");
     return -1;
@@ -133,7 +241,8 @@ int bacnet_wait_until_done()
  * @brief Processes incoming BACnet requests.
  *
  * Manages the handling of BACnet requests, including decoding and preparing
- * responses based on the request's content.
+ * responses based on the request's content. Calls that arrive while the
+ * snapshot is being restored wait for it to finish.
  *
  * @param buffer A pointer to the buffer containing the incoming BACnet request.
  * @param index  A pointer to the current index in the buffer.
@@ -141,14 +250,34 @@ int bacnet_wait_until_done()
  *               will be stored.
  */
 void handle_bacnet_request(char* buffer, int* index, ei_x_buff* reply)
+{
+  if (!atomic_load(&is_ready)) {
+    pthread_mutex_lock(&ready_lock);
+
+    while (!atomic_load(&is_ready))
+      pthread_cond_wait(&ready_signal, &ready_lock);
+
+    pthread_mutex_unlock(&ready_lock);
+  }
+
+  dispatch_call(buffer, index, reply);
+}
+
+static void dispatch_call(char* buffer, int* index, ei_x_buff* reply)
 {
   bacnet_call_type_t type = CALL_UNKNOWN;
   void*              data = NULL;
 
+  int call_start = *index;
+
+  uint64_t started_at = stats_now_us();
+  size_t   handler_count =
+    sizeof(CALL_HANDLERS_BY_TYPE) / sizeof(CALL_HANDLERS_BY_TYPE[0]);
+
   bool is_bad_request =
        decode_bacnet_call_type(buffer, index, &type)
     || type == CALL_UNKNOWN
-    || type > sizeof(CALL_HANDLERS_BY_TYPE)
+    || type >= handler_count
     || bacnet_call_malloc(type, &data)
     || decode_bacnet_call(buffer, index, type, data);
 
@@ -159,15 +288,136 @@ void handle_bacnet_request(char* buffer, int* index, ei_x_buff* reply)
 
   call_handler_t handler = CALL_HANDLERS_BY_TYPE[type];
 
-  if (handler(data)) {
+  // these take the stack lock themselves, so BACnet requests are served
+  // between the objects they handle
+  bool is_self_locking =
+       type == CALL_PROVISION_DEVICE
+    || type == CALL_DELETE_ROUTED_DEVICE;
+
+  if (!is_self_locking)
+    pthread_mutex_lock(&stack_lock);
+
+  // handlers that answer with data encode it themselves, on success only
+  int  reply_start = reply->index;
+  bool is_failed   = handler(data, reply) != 0;
+
+  if (!is_self_locking)
+    pthread_mutex_unlock(&stack_lock);
+
+  if (is_failed) {
+    reply->index = reply_start;
     REPLY_ERROR(reply, "failed_processing");
   }
-  else {
+  else if (reply->index == reply_start) {
     REPLY_OK(reply);
   }
 
+  if (!is_failed)
+    snapshot_record(type, data, buffer, call_start);
+
+  stats_record_call(type, is_failed, stats_now_us() - started_at);
+
 cleanup:
-  if (data) free(data);
+  bacnet_call_free(type, data);
+}
+
+static int request_device_index(pdu_info_t* info)
+{
+  // without a destination network, only confirmed requests are unicast
+  if (info->dest.net == 0)
+    return info->pdu_type == PDU_TYPE_CONFIRMED_SERVICE_REQUEST ? 0 : -1;
+
+  bool is_routed =
+       info->dest.net == bacnet_network_id
+    && info->dest.len == 3;
+
+  if (!is_routed)
+    return -1;
+
+  uint32_t instance = 0;
+  decode_unsigned24(&info->dest.adr[0], &instance);
+
+  return device_index_lookup(instance);
+}
+
+static void handle_pdu(
+  BACNET_ADDRESS* src,
+  int* network_ids,
+  uint8_t* pdu,
+  uint16_t pdu_len
+) {
+  uint64_t   started_at = stats_now_us();
+  pdu_info_t info = { 0 };
+  bool is_decoded = pdu_decode(src, pdu, pdu_len, &info) == 0;
+
+  pthread_mutex_lock(&stack_lock);
+
+  watchdog_annotate(info.pdu_type, info.service_choice, pdu_len);
+
+  bool is_handled =
+       is_decoded
+    && (
+         segment_handle_pdu(&info)
+      || reply_cache_replay(&info)
+      || deferred_reply_is_pending(&info)
+    );
+
+  if (!is_handled) {
+    LOG_DEBUG("bacnetd: sending request to npdu handler");
+    reply_cache_begin(is_decoded ? &info : NULL);
+    deferred_reply_begin(is_decoded ? &info : NULL);
+    routing_npdu_handler(src, network_ids, pdu, pdu_len);
+    deferred_reply_end();
+    reply_cache_end();
+  }
+
+  pthread_mutex_unlock(&stack_lock);
+
+  if (is_decoded) {
+    stats_record_apdu(
+      stats_service_of(info.pdu_type, info.service_choice),
+      request_device_index(&info),
+      stats_now_us() - started_at
+    );
+  }
+}
+
+static void restore_snapshot(void)
+{
+  snapshot_restore_result_t restored = { 0 };
+
+  if (snapshot_restore(dispatch_call, &restored)) {
+    LOG_WARNING("bacnetd: failed to restore snapshot");
+  }
+  else if (restored.records > 0) {
+    send_snapshot_restored(
+      restored.records,
+      restored.failed,
+      (uint32_t)(restored.elapsed_us / 1000)
+    );
+  }
+
+  pthread_mutex_lock(&ready_lock);
+  atomic_store(&is_ready, true);
+  pthread_cond_broadcast(&ready_signal);
+  pthread_mutex_unlock(&ready_lock);
+}
+
+/**
+ * @brief Dispatches a BACnet packet as if it had been received.
+ *
+ * Used to replay captured traffic without a datalink. Must be called from
+ * the thread that owns the BACnet objects.
+ *
+ * @param src     The address the packet was received from.
+ * @param pdu     A pointer to the NPDU.
+ * @param pdu_len The length of the NPDU.
+ */
+void bacnet_dispatch_pdu(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len)
+{
+  int network_ids[2] = { bacnet_network_id, -1 };
+
+  handle_pdu(src, network_ids, pdu, pdu_len);
 }
 
 static void* event_loop(void* arg)
@@ -179,27 +429,66 @@ static void* event_loop(void* arg)
 
   address_init();
   dlenv_init();
-  init_service_handlers();
+  bacnet_init_service_handlers();
   atexit(datalink_cleanup);
+  watchdog_watch_thread();
+  restore_snapshot();
+  timer_schedule_interval(VALUE_TABLE_SCAN_MS, scan_values, NULL);
 
   while (true) {
     BACNET_ADDRESS src_address = { 0 };
+    uint16_t       length      = 0;
 
     if (should_exit)
       break;
 
-    uint16_t timeout = apdu_timeout();
-    int length = bip_receive(&src_address, &buffer[0], MAX_MPDU, timeout);
-    if (length <= 0)
-      continue;
+    // only block on the socket when there is nothing left to dispatch
+    uint32_t timeout =
+      ingress_is_empty() ? timer_next_timeout_ms(apdu_timeout()) : 0;
 
-    LOG_DEBUG("bacnetd: sending request to npdu handler");
-    routing_npdu_handler(&src_address, network_ids, &buffer[0], length);
+    watchdog_mark_t mark = watchdog_enter(WATCHDOG_STAGE_RECEIVE, timeout);
+
+    for (int i = 0; i < INGRESS_RECEIVE_BATCH; i++) {
+      int received =
+        bip_receive(&src_address, &buffer[0], MAX_MPDU, i ? 0 : timeout);
+
+      if (received <= 0)
+        break;
+
+      capture_bacnet(&src_address, &buffer[0], received);
+      ingress_enqueue(&src_address, &buffer[0], received);
+    }
+
+    watchdog_leave(mark);
+
+    mark = watchdog_enter(WATCHDOG_STAGE_TIMERS, 0);
+    pthread_mutex_lock(&stack_lock);
+    timer_run_expired();
+    ingress_send_aborts();
+    pthread_mutex_unlock(&stack_lock);
+    watchdog_leave(mark);
+
+    if (ingress_dequeue(&src_address, &buffer[0], MAX_MPDU, &length)) {
+      mark = watchdog_enter(WATCHDOG_STAGE_DISPATCH, 0);
+      handle_pdu(&src_address, network_ids, &buffer[0], length);
+      watchdog_leave(mark);
+    }
   }
 
   pthread_exit(NULL);
 }
 
+static void scan_values(void* arg)
+{
+  size_t changed = value_table_scan();
+
+  if (changed > 0)
+    LOG_DEBUG("bacnetd: %zu values left their COV increment", changed);
+
+  // inputs outside the table flag their changes as they are set
+  subscribe_cov_task();
+}
+
 static void abort_handler(
   BACNET_ADDRESS* src,
   uint8_t invoke_id,
@@ -222,6 +511,51 @@ static void reject_handler(
 extern int Routed_Device_Read_Property_Local(BACNET_READ_PROPERTY_DATA* data);
 extern bool Routed_Device_Write_Property_Local(BACNET_WRITE_PROPERTY_DATA* data);
 
+/**
+ * @brief Reads a routed device property, reporting segmentation support.
+ *
+ * The stack always reports that devices do not support segmentation, so the
+ * segmentation properties are answered here instead.
+ *
+ * @param data The read property data.
+ *
+ * @return Returns the length of the encoded value, or a negative BACnet status.
+ */
+static int gateway_device_read_property(BACNET_READ_PROPERTY_DATA* data)
+{
+  bool is_invalid =
+       data == NULL
+    || data->application_data == NULL
+    || data->application_data_len == 0;
+
+  if (is_invalid)
+    return 0;
+
+  switch (data->object_property) {
+    case PROP_SEGMENTATION_SUPPORTED:
+      return encode_application_enumerated(
+        &data->application_data[0],
+        SEGMENTATION_TRANSMIT
+      );
+
+    case PROP_MAX_SEGMENTS_ACCEPTED:
+      return encode_application_unsigned(
+        &data->application_data[0],
+        SEGMENT_MAX_SEGMENTS
+      );
+
+    // each routed device reports the revision of its own objects
+    case PROP_DATABASE_REVISION:
+      return encode_application_unsigned(
+        &data->application_data[0],
+        Get_Routed_Device_Object(-1)->Database_Revision
+      );
+
+    default:
+      return Routed_Device_Read_Property_Local(data);
+  }
+}
+
 static object_functions_t SUPPORTED_OBJECT_TABLE[] = {
   {
     .Object_Type = OBJECT_DEVICE,
@@ -230,7 +564,7 @@ static object_functions_t SUPPORTED_OBJECT_TABLE[] = {
     .Object_Index_To_Instance = Routed_Device_Index_To_Instance,
     .Object_Valid_Instance = Routed_Device_Valid_Object_Instance_Number,
     .Object_Name = Routed_Device_Name,
-    .Object_Read_Property = Routed_Device_Read_Property_Local,
+    .Object_Read_Property = gateway_device_read_property,
     .Object_Write_Property = Routed_Device_Write_Property_Local,
     .Object_RPM_List = Device_Property_Lists,
     .Object_RR_Info = DeviceGetRRInfo,
@@ -357,30 +691,49 @@ static object_functions_t SUPPORTED_OBJECT_TABLE[] = {
   },
 };
 
-static int init_service_handlers()
+// multistate state lists are interned, as many inputs share the same states
+static char* intern_state_text(const char* state_text_list, size_t length)
+{
+  return (char*)string_arena_intern(state_text_list, length);
+}
+
+static void release_state_text(char* state_text_list)
+{
+  string_arena_release(state_text_list);
+}
+
+/**
+ * @brief Registers the object table and the BACnet service handlers.
+ *
+ * Called by the event loop before it starts receiving. Exposed so the
+ * benchmarks can drive the stack without a datalink.
+ *
+ * @return Always returns 0.
+ */
+int bacnet_init_service_handlers()
 {
   Device_Init(SUPPORTED_OBJECT_TABLE);
 
+  Routed_Multistate_Input_State_Text_Allocator_Set(
+    intern_state_text,
+    release_state_text
+  );
+
   apdu_set_unrecognized_service_handler_handler(handler_unrecognized_service);
 
-  apdu_set_unconfirmed_handler(
-    SERVICE_UNCONFIRMED_WHO_IS,
-    handler_who_is_bcast_for_routing
-  );
+  who_is_init();
+  apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_WHO_IS, who_is_handler);
 
-  apdu_set_unconfirmed_handler(
-    SERVICE_UNCONFIRMED_WHO_HAS,
-    handler_who_has_for_routing
-  );
+  apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_WHO_HAS, who_has_handler);
 
   apdu_set_confirmed_handler(
     SERVICE_CONFIRMED_READ_PROPERTY,
-    handler_read_property
+    read_property_handler
   );
 
   apdu_set_confirmed_handler(
     SERVICE_CONFIRMED_READ_PROP_MULTIPLE,
-    handler_read_property_multiple
+    read_property_multiple_handler
   );
 
   apdu_set_confirmed_handler(
@@ -412,7 +765,7 @@ static int init_service_handlers()
 
   apdu_set_confirmed_handler(
     SERVICE_CONFIRMED_SUBSCRIBE_COV,
-    handler_cov_subscribe
+    subscribe_cov_handler
   );
 
   apdu_set_unconfirmed_handler(
@@ -447,14 +800,47 @@ static void set_device_address(DEVICE_OBJECT_DATA* device, int network_id)
   }
 }
 
-static int handle_create_gateway(create_routed_device_t* device)
+static int index_device_name(create_routed_device_t* device)
 {
-  Add_Routed_Device(
-    device->bacnet_id,
-    &device->name,
-    device->description,
-    device->model,
-    device->firmware_version);
+  char name[MAX_CHARACTER_STRING_BYTES] = { 0 };
+  characterstring_ansi_copy(name, sizeof(name), &device->name);
+
+  bool is_indexed =
+    name_index_insert(
+      device->bacnet_id,
+      name,
+      OBJECT_DEVICE,
+      device->bacnet_id
+    );
+
+  return is_indexed ? 0 : -1;
+}
+
+static bool index_input_name(
+  uint32_t device_id,
+  const char* old_name,
+  const char* new_name,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance
+) {
+  if (old_name[0] != '\0')
+    return name_index_rename(device_id, old_name, new_name, type, instance);
+
+  return name_index_insert(device_id, new_name, type, instance);
+}
+
+static int handle_create_gateway(
+  create_routed_device_t* device,
+  ei_x_buff* reply
+) {
+  int index =
+    Add_Routed_Device(
+      device->bacnet_id,
+      &device->name,
+      device->description,
+      device->model,
+      device->firmware_version
+    );
 
   Routed_Device_Set_Object_Instance_Number(device->bacnet_id);
   Routed_Device_Set_Model(device->model, strlen(device->model));
@@ -483,33 +869,104 @@ static int handle_create_gateway(create_routed_device_t* device)
     strlen(device->firmware_version)
   );
 
-  return 0;
+  if (device_index_insert(device->bacnet_id, index))
+    return -1;
+
+  return index_device_name(device);
 }
 
-static int handle_create_routed_device(create_routed_device_t* device)
+static int reuse_routed_device(create_routed_device_t* device)
 {
-  int index =
-    Add_Routed_Device(
-      device->bacnet_id,
-      &device->name,
-      device->description,
-      device->model,
-      device->firmware_version
-    );
+  int index = 1;
+  while (index < MAX_NUM_DEVICES && !is_retired[index])
+    index++;
+
+  if (index == MAX_NUM_DEVICES)
+    return -1;
+
+  Get_Routed_Device_Object(index);
+  Routed_Device_Set_Object_Instance_Number(device->bacnet_id);
+
+  Routed_Device_Set_Object_Name(
+    device->name.encoding,
+    device->name.value,
+    device->name.length
+  );
+
+  Routed_Device_Set_Description(
+    device->description,
+    strlen(device->description)
+  );
+
+  Routed_Device_Set_Model(device->model, strlen(device->model));
+
+  Routed_Device_Set_Firmware_Version(
+    device->firmware_version,
+    strlen(device->firmware_version)
+  );
+
+  // clients that cached the retired device's objects must read them again
+  Routed_Device_Inc_Database_Revision();
+  is_retired[index] = false;
+
+  return index;
+}
+
+static int handle_create_routed_device(
+  create_routed_device_t* device,
+  ei_x_buff* reply
+) {
+  int index = reuse_routed_device(device);
+
+  if (index < 0) {
+    index =
+      Add_Routed_Device(
+        device->bacnet_id,
+        &device->name,
+        device->description,
+        device->model,
+        device->firmware_version
+      );
+  }
 
   DEVICE_OBJECT_DATA* child = Get_Routed_Device_Object(index);
   set_device_address(child, bacnet_network_id);
 
-  return 0;
+  if (device_index_insert(device->bacnet_id, index))
+    return -1;
+
+  return index_device_name(device);
 }
 
-static int
-handle_create_routed_analog_input(create_routed_analog_input_t* params)
-{
+static int handle_create_routed_analog_input(
+  create_routed_analog_input_t* params,
+  ei_x_buff* reply
+) {
   uint32_t device_index =
     Routed_Device_Instance_To_Index(params->device_bacnet_id);
 
-  Get_Routed_Device_Object(device_index);
+  bool is_name_available =
+    name_index_is_available(
+      params->device_bacnet_id,
+      params->name,
+      OBJECT_ANALOG_INPUT,
+      params->object_bacnet_id
+    );
+
+  if (!is_name_available)
+    return -1;
+
+  DEVICE_OBJECT_DATA* device = Get_Routed_Device_Object(device_index);
+  bool is_new = !Keylist_Data(device->objects, params->object_bacnet_id);
+
+  // re-creating an input renames it, so its old name leaves the index
+  char old_name[MAX_CHARACTER_STRING_BYTES] = { 0 };
+  if (!is_new) {
+    BACNET_CHARACTER_STRING object_name = { 0 };
+    Routed_Analog_Input_Object_Name(params->object_bacnet_id, &object_name);
+    characterstring_ansi_copy(old_name, sizeof(old_name), &object_name);
+  }
+
   Routed_Analog_Input_Create(
     params->object_bacnet_id,
     params->name,
@@ -517,18 +974,60 @@ handle_create_routed_analog_input(create_routed_analog_input_t* params)
   );
 
   Routed_Analog_Input_Units_Set(params->object_bacnet_id, params->unit);
-  Routed_Analog_Input_Name_Set(params->object_bacnet_id, params->name);
+  bool is_name_set =
+    Routed_Analog_Input_Name_Set(params->object_bacnet_id, params->name);
+
+  // no object was created, or the existing one kept its name
+  void* object = Keylist_Data(device->objects, params->object_bacnet_id);
+  if (!object || (!is_new && !is_name_set)) {
+    Get_Routed_Device_Object(0);
+    return -1;
+  }
+
+  bool is_renamed = !is_new && strcmp(old_name, params->name) != 0;
+
+  if (is_new || is_renamed)
+    database_changed();
+
   Get_Routed_Device_Object(0);
 
-  return 0;
+  value_table_add(
+    device_index,
+    OBJECT_ANALOG_INPUT,
+    params->object_bacnet_id,
+    object
+  );
+
+  bool is_indexed =
+    index_input_name(
+      params->device_bacnet_id,
+      old_name,
+      params->name,
+      OBJECT_ANALOG_INPUT,
+      params->object_bacnet_id
+    );
+
+  return is_indexed ? 0 : -1;
 }
 
-static int
-handle_set_routed_analog_input_value(set_routed_analog_input_value_t* params)
-{
+static int handle_set_routed_analog_input_value(
+  set_routed_analog_input_value_t* params,
+  ei_x_buff* reply
+) {
   uint32_t device_index =
     Routed_Device_Instance_To_Index(params->device_bacnet_id);
 
+  bool is_set =
+    value_table_set(
+      device_index,
+      OBJECT_ANALOG_INPUT,
+      params->object_bacnet_id,
+      params->value
+    );
+
+  if (is_set)
+    return 0;
+
   Get_Routed_Device_Object(device_index);
   Routed_Analog_Input_Present_Value_Set(
     params->object_bacnet_id,
@@ -540,13 +1039,33 @@ handle_set_routed_analog_input_value(set_routed_analog_input_value_t* params)
   return 0;
 }
 
-static int
-handle_create_routed_multistate_input(create_routed_multistate_input_t* params)
-{
+static int handle_create_routed_multistate_input(
+  create_routed_multistate_input_t* params,
+  ei_x_buff* reply
+) {
   uint32_t device_index =
     Routed_Device_Instance_To_Index(params->device_bacnet_id);
 
-  Get_Routed_Device_Object(device_index);
+  bool is_name_available =
+    name_index_is_available(
+      params->device_bacnet_id,
+      params->name,
+      OBJECT_MULTI_STATE_INPUT,
+      params->object_bacnet_id
+    );
+
+  if (!is_name_available)
+    return -1;
+
+  DEVICE_OBJECT_DATA* device = Get_Routed_Device_Object(device_index);
+  bool is_new = !Keylist_Data(device->objects, params->object_bacnet_id);
+
+  char old_name[MAX_CHARACTER_STRING_BYTES] = { 0 };
+  if (!is_new) {
+    BACNET_CHARACTER_STRING object_name = { 0 };
+    Routed_Multistate_Input_Object_Name(params->object_bacnet_id, &object_name);
+    characterstring_ansi_copy(old_name, sizeof(old_name), &object_name);
+  }
 
   Routed_Multistate_Input_Create(
     params->object_bacnet_id,
@@ -560,14 +1079,39 @@ handle_create_routed_multistate_input(create_routed_multistate_input_t* params)
     (int)params->states_length
   );
 
+  bool is_name_set =
+    Routed_Multistate_Input_Name_Set(params->object_bacnet_id, params->name);
+
+  // no object was created, or the existing one kept its name
+  void* object = Keylist_Data(device->objects, params->object_bacnet_id);
+  if (!object || (!is_new && !is_name_set)) {
+    Get_Routed_Device_Object(0);
+    return -1;
+  }
+
+  bool is_renamed = !is_new && strcmp(old_name, params->name) != 0;
+
+  if (is_new || is_renamed)
+    database_changed();
+
   Get_Routed_Device_Object(0);
 
-  return 0;
+  bool is_indexed =
+    index_input_name(
+      params->device_bacnet_id,
+      old_name,
+      params->name,
+      OBJECT_MULTI_STATE_INPUT,
+      params->object_bacnet_id
+    );
+
+  return is_indexed ? 0 : -1;
 }
 
-static int
-handle_set_routed_multistate_value(set_routed_multistate_input_value_t* params)
-{
+static int handle_set_routed_multistate_value(
+  set_routed_multistate_input_value_t* params,
+  ei_x_buff* reply
+) {
   uint32_t device_index =
     Routed_Device_Instance_To_Index(params->device_bacnet_id);
 
@@ -583,12 +1127,27 @@ handle_set_routed_multistate_value(set_routed_multistate_input_value_t* params)
   return 0;
 }
 
-static int handle_create_routed_command(create_routed_command_t* params)
-{
+static int handle_create_routed_command(
+  create_routed_command_t* params,
+  ei_x_buff* reply
+) {
   uint32_t device_index =
     Routed_Device_Instance_To_Index(params->device_bacnet_id);
 
   DEVICE_OBJECT_DATA* device = Get_Routed_Device_Object(device_index);
+  COMMAND_OBJECT*     object =
+    Keylist_Data(device->objects, params->object_bacnet_id);
+
+  // re-creating a command renames it
+  if (object && strcmp(object->name, params->name) != 0) {
+    bool is_renamed = command_name_set(params->object_bacnet_id, params->name);
+    if (is_renamed)
+      database_changed();
+
+    Get_Routed_Device_Object(0);
+
+    return is_renamed ? 0 : -1;
+  }
 
   uint32_t bacnet_id =
     command_create(
@@ -600,16 +1159,23 @@ static int handle_create_routed_command(create_routed_command_t* params)
       params->in_progress
     );
 
-  if (bacnet_id != params->object_bacnet_id)
+  if (bacnet_id != params->object_bacnet_id) {
+    Get_Routed_Device_Object(0);
     return -1;
+  }
+
+  if (!object)
+    database_changed();
 
   Get_Routed_Device_Object(0);
 
   return 0;
 }
 
-static int handle_set_routed_command_status(set_routed_command_status_t* params)
-{
+static int handle_set_routed_command_status(
+  set_routed_command_status_t* params,
+  ei_x_buff* reply
+) {
   uint32_t device_index =
     Routed_Device_Instance_To_Index(params->device_bacnet_id);
 
@@ -625,13 +1191,15 @@ static int handle_set_routed_command_status(set_routed_command_status_t* params)
   return 0;
 }
 
-static int
-handle_create_characterstring_value(create_characterstring_value_t* params)
-{
+static int handle_create_characterstring_value(
+  create_characterstring_value_t* params,
+  ei_x_buff* reply
+) {
   uint32_t device_index =
     Routed_Device_Instance_To_Index(params->device_bacnet_id);
 
   DEVICE_OBJECT_DATA* device = Get_Routed_Device_Object(device_index);
+  bool is_new = !Keylist_Data(device->objects, params->object_bacnet_id);
 
   uint32_t bacnet_id =
     characterstring_value_create(
@@ -645,17 +1213,23 @@ handle_create_characterstring_value(create_characterstring_value_t* params)
   if (bacnet_id != params->object_bacnet_id)
     return -1;
 
+  if (is_new)
+    database_changed();
+
   Get_Routed_Device_Object(0);
 
   return 0;
 }
 
-static int handle_create_binary_input(create_binary_input_t* params)
-{
+static int handle_create_binary_input(
+  create_binary_input_t* params,
+  ei_x_buff* reply
+) {
   uint32_t device_index =
     Routed_Device_Instance_To_Index(params->device_bacnet_id);
 
   DEVICE_OBJECT_DATA* device = Get_Routed_Device_Object(device_index);
+  bool is_new = !Keylist_Data(device->objects, params->object_bacnet_id);
 
   uint32_t bacnet_id =
     binary_input_create(
@@ -672,13 +1246,18 @@ static int handle_create_binary_input(create_binary_input_t* params)
   if (bacnet_id != params->object_bacnet_id)
     return -1;
 
+  if (is_new)
+    database_changed();
+
   Get_Routed_Device_Object(0);
 
   return 0;
 }
 
-static int handle_set_binary_input_value(set_binary_input_value_t* params)
-{
+static int handle_set_binary_input_value(
+  set_binary_input_value_t* params,
+  ei_x_buff* reply
+) {
   uint32_t device_index =
     Routed_Device_Instance_To_Index(params->device_bacnet_id);
 
@@ -693,3 +1272,383 @@ static int handle_set_binary_input_value(set_binary_input_value_t* params)
 
   return 0;
 }
+
+static int handle_set_log_level(set_log_level_t* params, ei_x_buff* reply)
+{
+  log_set_level(params->level);
+
+  return 0;
+}
+
+static int handle_get_stats(get_stats_t* params, ei_x_buff* reply)
+{
+  ei_x_encode_tuple_header(reply, 2);
+  ei_x_encode_atom(reply, "ok");
+
+  return encode_stats(reply);
+}
+
+static int handle_get_hot_points(get_hot_points_t* params, ei_x_buff* reply)
+{
+  ei_x_encode_tuple_header(reply, 2);
+  ei_x_encode_atom(reply, "ok");
+
+  return encode_hot_points(reply, params->limit);
+}
+
+static int handle_get_flight_recorder(
+  get_flight_recorder_t* params,
+  ei_x_buff* reply
+) {
+  ei_x_encode_tuple_header(reply, 2);
+  ei_x_encode_atom(reply, "ok");
+
+  return encode_flight_recorder(reply);
+}
+
+static int compare_provision_objects(const void* a, const void* b)
+{
+  uint32_t left  = ((const provision_object_t*)a)->object_bacnet_id;
+  uint32_t right = ((const provision_object_t*)b)->object_bacnet_id;
+
+  return (left > right) - (left < right);
+}
+
+static void encode_provision_failure(
+  ei_x_buff* reply,
+  provision_object_t* object,
+  const char* reason
+) {
+  ei_x_encode_list_header(reply, 1);
+  ei_x_encode_tuple_header(reply, 3);
+  ei_x_encode_atom(
+    reply,
+    find_enum_atom(PROVISION_OBJECT_ATOMS, object->type)
+  );
+  ei_x_encode_ulong(reply, object->object_bacnet_id);
+  ei_x_encode_atom(reply, reason);
+}
+
+static int handle_provision_device(
+  provision_device_t* params,
+  ei_x_buff* reply
+) {
+  provision_object_params_t object_params;
+
+  uint32_t device_id = params->device.bacnet_id;
+
+  pthread_mutex_lock(&stack_lock);
+
+  bool is_device_ready =
+       device_index_lookup(device_id) >= 0
+    || handle_create_routed_device(&params->device, NULL) == 0;
+
+  Get_Routed_Device_Object(0);
+  pthread_mutex_unlock(&stack_lock);
+
+  if (!is_device_ready)
+    return -1;
+
+  // in instance order every object is appended to the device's Keylist,
+  // rather than inserted with a memmove
+  qsort(
+    params->objects,
+    params->object_count,
+    sizeof(provision_object_t),
+    compare_provision_objects
+  );
+
+  name_index_reserve(params->object_count);
+
+  size_t changes = 0;
+
+  ei_x_encode_tuple_header(reply, 2);
+  ei_x_encode_atom(reply, "ok");
+
+  for (size_t i = 0; i < params->object_count; i++) {
+    provision_object_t* object  = &params->objects[i];
+    call_handler_t      handler = CALL_HANDLERS_BY_TYPE[object->type];
+
+    bool is_decoded =
+      decode_provision_object(
+        params->buffer,
+        object,
+        device_id,
+        &object_params
+      ) == 0;
+
+    pthread_mutex_lock(&stack_lock);
+
+    is_bulk_change = true;
+    bulk_changes   = 0;
+
+    bool is_created = is_decoded && handler(&object_params, NULL) == 0;
+
+    is_bulk_change = false;
+    changes       += bulk_changes;
+
+    Get_Routed_Device_Object(0);
+    pthread_mutex_unlock(&stack_lock);
+
+    // the stack keeps its own copy of the state texts
+    if (is_decoded && object->type == CALL_CREATE_ROUTED_MULTISTATE_INPUT)
+      memory_free(MEMORY_CALLS, object_params.multistate_input.states);
+
+    if (!is_decoded)
+      encode_provision_failure(reply, object, "bad_request");
+    else if (!is_created)
+      encode_provision_failure(reply, object, "failed_processing");
+  }
+
+  ei_x_encode_empty_list(reply);
+
+  pthread_mutex_lock(&stack_lock);
+
+  if (changes > 0) {
+    Get_Routed_Device_Object(device_index_lookup(device_id));
+    Routed_Device_Inc_Database_Revision();
+    Get_Routed_Device_Object(0);
+  }
+
+  pthread_mutex_unlock(&stack_lock);
+
+  return 0;
+}
+
+static int handle_get_memory(get_memory_t* params, ei_x_buff* reply)
+{
+  ei_x_encode_tuple_header(reply, 2);
+  ei_x_encode_atom(reply, "ok");
+
+  return encode_memory(reply);
+}
+
+// the types of object that delete_object can delete
+static bool is_deletable_type(BACNET_OBJECT_TYPE type)
+{
+  switch (type) {
+    case OBJECT_ANALOG_INPUT:
+    case OBJECT_MULTI_STATE_INPUT:
+    case OBJECT_COMMAND:
+    case OBJECT_CHARACTERSTRING_VALUE:
+    case OBJECT_BINARY_INPUT:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+// deletes an object of the selected device, along with its subscriptions
+static bool delete_object(
+  DEVICE_OBJECT_DATA* device,
+  int device_index,
+  uint32_t device_id,
+  uint32_t instance
+) {
+  ROUTED_OBJECT* object = Keylist_Data(device->objects, instance);
+  if (!object)
+    return false;
+
+  BACNET_OBJECT_TYPE      type        = object->Type;
+  BACNET_CHARACTER_STRING object_name = { 0 };
+  bool                    is_deleted  = false;
+
+  // the stack only cancels subscriptions to objects that exist
+  subscribe_cov_cancel_object(device_id, type, instance);
+
+  // the stack's inputs do not index their names, so it is done for them
+  switch (type) {
+    case OBJECT_ANALOG_INPUT:
+      Routed_Analog_Input_Object_Name(instance, &object_name);
+      value_table_remove(device_index, type, instance);
+      is_deleted = Routed_Analog_Input_Delete(instance);
+      break;
+
+    case OBJECT_MULTI_STATE_INPUT:
+      Routed_Multistate_Input_Object_Name(instance, &object_name);
+      is_deleted = Routed_Multistate_Input_Delete(instance);
+      break;
+
+    case OBJECT_COMMAND:
+      is_deleted = command_delete(device, instance);
+      break;
+
+    case OBJECT_CHARACTERSTRING_VALUE:
+      is_deleted = characterstring_value_delete(device, instance);
+      break;
+
+    case OBJECT_BINARY_INPUT:
+      is_deleted = binary_input_delete(device, instance);
+      break;
+
+    default:
+      break;
+  }
+
+  if (characterstring_length(&object_name) > 0) {
+    char name[MAX_CHARACTER_STRING_BYTES] = { 0 };
+    characterstring_ansi_copy(name, sizeof(name), &object_name);
+    name_index_remove(device_id, name);
+  }
+
+  if (is_deleted)
+    database_changed();
+
+  return is_deleted;
+}
+
+static int handle_delete_object(delete_object_t* params, ei_x_buff* reply)
+{
+  int index = device_index_lookup(params->device_bacnet_id);
+  if (index < 0)
+    return -1;
+
+  DEVICE_OBJECT_DATA* device = Get_Routed_Device_Object(index);
+
+  bool is_deleted =
+    delete_object(
+      device,
+      index,
+      params->device_bacnet_id,
+      params->object_bacnet_id
+    );
+
+  Get_Routed_Device_Object(0);
+
+  return is_deleted ? 0 : -1;
+}
+
+static int handle_delete_routed_device(
+  delete_routed_device_t* params,
+  ei_x_buff* reply
+) {
+  uint32_t device_id = params->bacnet_id;
+
+  pthread_mutex_lock(&stack_lock);
+
+  // the gateway routes for every other device, and is never deleted
+  int index = device_index_lookup(device_id);
+  if (index <= 0) {
+    pthread_mutex_unlock(&stack_lock);
+    return -1;
+  }
+
+  DEVICE_OBJECT_DATA* device = Get_Routed_Device_Object(index);
+
+  // a device holding objects bacnetd can't delete is kept whole
+  int object_count = Keylist_Count(device->objects);
+  for (int i = 0; i < object_count; i++) {
+    ROUTED_OBJECT* object = Keylist_Data_Index(device->objects, i);
+
+    if (!object || !is_deletable_type(object->Type)) {
+      Get_Routed_Device_Object(0);
+      pthread_mutex_unlock(&stack_lock);
+      return -1;
+    }
+  }
+
+  // no request is routed to the device from here on
+  BACNET_ADDRESS address = device->bacDevAddr;
+  memset(&device->bacDevAddr, 0, sizeof(device->bacDevAddr));
+  device->bacObj.Object_Instance_Number = 0;
+  device_index_remove(device_id);
+
+  Get_Routed_Device_Object(0);
+  pthread_mutex_unlock(&stack_lock);
+
+  // the last object is deleted first, so the Keylist never shifts, and the
+  // revision of a device that is going away is left alone
+  bool is_empty  = false;
+  bool is_failed = false;
+
+  while (!is_empty && !is_failed) {
+    pthread_mutex_lock(&stack_lock);
+    device         = Get_Routed_Device_Object(index);
+    is_bulk_change = true;
+
+    for (int i = 0; i < DEVICE_DELETE_BATCH && !is_empty && !is_failed; i++) {
+      int count = Keylist_Count(device->objects);
+      KEY key   = 0;
+
+      is_empty =
+           count == 0
+        || !Keylist_Index_Key(device->objects, count - 1, &key);
+
+      is_failed = !is_empty && !delete_object(device, index, device_id, key);
+    }
+
+    is_bulk_change = false;
+    bulk_changes   = 0;
+
+    // the device is routed again with the objects left, which changed
+    if (is_failed) {
+      LOG_ERROR("bacnetd: failed to delete an object of device %u", device_id);
+
+      device->bacDevAddr                    = address;
+      device->bacObj.Object_Instance_Number = device_id;
+      device_index_insert(device_id, (uint32_t)index);
+      Routed_Device_Inc_Database_Revision();
+    }
+
+    Get_Routed_Device_Object(0);
+    pthread_mutex_unlock(&stack_lock);
+  }
+
+  if (is_failed)
+    return -1;
+
+  pthread_mutex_lock(&stack_lock);
+
+  device = Get_Routed_Device_Object(index);
+  memset(device->bacObj.Object_Name, 0, sizeof(device->bacObj.Object_Name));
+  Get_Routed_Device_Object(0);
+
+  name_index_remove_device(device_id);
+  value_table_remove_device((uint32_t)index);
+  subscribe_cov_forget_device(device_id);
+  is_retired[index] = true;
+
+  pthread_mutex_unlock(&stack_lock);
+
+  return 0;
+}
+
+static int handle_set_command_actions(
+  set_command_actions_t* params,
+  ei_x_buff* reply
+) {
+  int index = device_index_lookup(params->device_bacnet_id);
+  if (index < 0 || params->list_count > MAX_COMMAND_ACTIONS)
+    return -1;
+
+  DEVICE_OBJECT_DATA* device = Get_Routed_Device_Object(index);
+  COMMAND_OBJECT*     object =
+    Keylist_Data(device->objects, params->object_bacnet_id);
+
+  bool is_set = object && object->type == OBJECT_COMMAND;
+
+  // lists past the ones given are emptied
+  const BACNET_ACTION_LIST* commands = params->commands;
+
+  for (uint32_t list = 0; is_set && list < MAX_COMMAND_ACTIONS; list++) {
+    uint32_t length =
+      list < params->list_count ? params->list_lengths[list] : 0;
+
+    is_set = command_set_actions(object, list, commands, length);
+    commands += length;
+  }
+
+  Get_Routed_Device_Object(0);
+
+  return is_set ? 0 : -1;
+}
+
+// called with the changed device selected
+static void database_changed(void)
+{
+  if (is_bulk_change)
+    bulk_changes++;
+  else
+    Routed_Device_Inc_Database_Revision();
+}
@@ -1,10 +1,21 @@
 #ifndef BACNET_H
 #define BACNET_H
 
+#include <stdint.h>
+#include <bacnet/bacdef.h>
+
 #include "ei.h"
 
+// objects deleted with a device between BACnet requests
+#ifndef DEVICE_DELETE_BATCH
+#define DEVICE_DELETE_BATCH 64
+#endif
+
 void handle_bacnet_request(char* buffer, int* index, ei_x_buff* reply);
+void bacnet_dispatch_pdu(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len);
 
+void bacnet_configure();
+int bacnet_init_service_handlers();
 int bacnet_start_services();
 int bacnet_stop_services();
 int bacnet_wait_until_done();
@@ -0,0 +1,232 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "capture.h"
+#include "log.h"
+#include "stats.h"
+
+static uint8_t*        ring = NULL;
+static size_t          head = 0;
+static size_t          tail = 0;
+static pthread_mutex_t ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  ring_ready = PTHREAD_COND_INITIALIZER;
+
+static FILE*        file = NULL;
+static pthread_t    writer_thread_id;
+static atomic_bool  is_enabled = false;
+static bool         should_stop = false;
+static atomic_uint  dropped = 0;
+static uint64_t     started_us = 0;
+
+static void* writer_loop(void* arg);
+
+static void enqueue(
+  capture_kind_t kind,
+  const void* prefix,
+  size_t prefix_len,
+  const void* payload,
+  size_t payload_len
+);
+
+/**
+ * @brief Starts capturing traffic, if enabled.
+ *
+ * Capturing is enabled by setting `BACNET_CAPTURE` to the path of the
+ * capture file, which is truncated.
+ *
+ * @return Returns 0 on success or when capturing is disabled, or -1 if the
+ *         file, buffer or writer thread cannot be created.
+ */
+int capture_start(void)
+{
+  const char* path = getenv("BACNET_CAPTURE");
+  if (path == NULL || path[0] == '\0')
+    return 0;
+
+  file = fopen(path, "wb");
+  if (file == NULL)
+    return -1;
+
+  ring        = malloc(CAPTURE_RING_SIZE);
+  head        = 0;
+  tail        = 0;
+  should_stop = false;
+
+  bool is_failed =
+       ring == NULL
+    || fwrite(CAPTURE_MAGIC, 1, CAPTURE_MAGIC_LEN, file) != CAPTURE_MAGIC_LEN
+    || pthread_create(&writer_thread_id, NULL, &writer_loop, NULL) != 0;
+
+  if (is_failed) {
+    fclose(file);
+    free(ring);
+    file = NULL;
+    ring = NULL;
+    return -1;
+  }
+
+  started_us = stats_now_us();
+  atomic_store(&is_enabled, true);
+
+  return 0;
+}
+
+/**
+ * @brief Flushes buffered records and closes the capture file.
+ */
+void capture_stop(void)
+{
+  if (!atomic_exchange(&is_enabled, false))
+    return;
+
+  pthread_mutex_lock(&ring_lock);
+  should_stop = true;
+  pthread_cond_signal(&ring_ready);
+  pthread_mutex_unlock(&ring_lock);
+
+  pthread_join(writer_thread_id, NULL);
+
+  unsigned dropped_count = atomic_load(&dropped);
+  if (dropped_count > 0)
+    LOG_WARNING("bacnetd: capture dropped %u records", dropped_count);
+
+  fclose(file);
+  free(ring);
+  file = NULL;
+  ring = NULL;
+}
+
+/**
+ * @brief Records an inbound BACnet datagram.
+ *
+ * @param src     The address the datagram was received from.
+ * @param pdu     A pointer to the NPDU.
+ * @param pdu_len The length of the NPDU.
+ */
+void capture_bacnet(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len)
+{
+  if (!atomic_load_explicit(&is_enabled, memory_order_relaxed))
+    return;
+
+  capture_address_t address = {
+    .mac_len = src->mac_len,
+    .net     = src->net,
+    .len     = src->len,
+  };
+
+  memcpy(address.mac, src->mac, sizeof(address.mac));
+  memcpy(address.adr, src->adr, sizeof(address.adr));
+
+  enqueue(CAPTURE_BACNET, &address, sizeof(address), pdu, pdu_len);
+}
+
+/**
+ * @brief Records a frame read from the port.
+ *
+ * @param frame     A pointer to the frame, without its length prefix.
+ * @param frame_len The length of the frame.
+ */
+void capture_port(const char* frame, size_t frame_len)
+{
+  if (!atomic_load_explicit(&is_enabled, memory_order_relaxed))
+    return;
+
+  enqueue(CAPTURE_PORT, NULL, 0, frame, frame_len);
+}
+
+// copies into the ring at a running offset, wrapping at the end
+static void copy_in(size_t offset, const void* data, size_t length)
+{
+  if (length == 0)
+    return;
+
+  size_t start = offset % CAPTURE_RING_SIZE;
+  size_t first = CAPTURE_RING_SIZE - start;
+
+  if (first > length)
+    first = length;
+
+  memcpy(&ring[start], data, first);
+  memcpy(&ring[0], (const uint8_t*)data + first, length - first);
+}
+
+static void enqueue(
+  capture_kind_t kind,
+  const void* prefix,
+  size_t prefix_len,
+  const void* payload,
+  size_t payload_len
+) {
+  capture_record_t record = {
+    .timestamp_us = stats_now_us() - started_us,
+    .length       = (uint32_t)(prefix_len + payload_len),
+    .kind         = kind,
+  };
+
+  size_t total = sizeof(record) + record.length;
+
+  pthread_mutex_lock(&ring_lock);
+
+  if (should_stop) {
+    pthread_mutex_unlock(&ring_lock);
+    return;
+  }
+
+  // a full ring drops the record rather than stall the caller
+  if (head - tail + total > CAPTURE_RING_SIZE) {
+    pthread_mutex_unlock(&ring_lock);
+    atomic_fetch_add(&dropped, 1);
+    return;
+  }
+
+  copy_in(head, &record, sizeof(record));
+  copy_in(head + sizeof(record), prefix, prefix_len);
+  copy_in(head + sizeof(record) + prefix_len, payload, payload_len);
+  head += total;
+
+  pthread_cond_signal(&ring_ready);
+  pthread_mutex_unlock(&ring_lock);
+}
+
+static void* writer_loop(void* arg)
+{
+  while (true) {
+    pthread_mutex_lock(&ring_lock);
+
+    while (head == tail && !should_stop)
+      pthread_cond_wait(&ring_ready, &ring_lock);
+
+    size_t end     = head;
+    size_t start   = tail;
+    bool   is_last = should_stop;
+
+    pthread_mutex_unlock(&ring_lock);
+
+    // producers only write past head, so [start, end) is stable unlocked
+    while (start < end) {
+      size_t offset = start % CAPTURE_RING_SIZE;
+      size_t length = CAPTURE_RING_SIZE - offset;
+
+      if (length > end - start)
+        length = end - start;
+
+      fwrite(&ring[offset], 1, length, file);
+      start += length;
+    }
+
+    pthread_mutex_lock(&ring_lock);
+    tail = end;
+    is_last = is_last && head == tail;
+    pthread_mutex_unlock(&ring_lock);
+
+    if (is_last)
+      break;
+  }
+
+  fflush(file);
+  pthread_exit(NULL);
+}
@@ -0,0 +1,48 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <bacnet/bacdef.h>
+
+// bytes buffered between the capturing threads and the file writer
+#ifndef CAPTURE_RING_SIZE
+#define CAPTURE_RING_SIZE (4 * 1024 * 1024)
+#endif
+
+#define CAPTURE_MAGIC     "BNCAP001"
+#define CAPTURE_MAGIC_LEN 8
+
+/*
+ * A capture file is CAPTURE_MAGIC followed by records, each a
+ * capture_record_t header and `length` bytes of payload, in host byte order.
+ * BACnet payloads start with the source address as a capture_address_t,
+ * followed by the NPDU. Port payloads are the frame as read from the port,
+ * without its length prefix.
+ */
+
+typedef enum {
+  CAPTURE_BACNET = 1,
+  CAPTURE_PORT   = 2,
+} capture_kind_t;
+
+typedef struct __attribute__((packed)) {
+  uint64_t timestamp_us;
+  uint32_t length;
+  uint8_t  kind;
+} capture_record_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t  mac_len;
+  uint8_t  mac[MAX_MAC_LEN];
+  uint16_t net;
+  uint8_t  len;
+  uint8_t  adr[MAX_MAC_LEN];
+} capture_address_t;
+
+int capture_start(void);
+void capture_stop(void);
+void capture_bacnet(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len);
+void capture_port(const char* frame, size_t frame_len);
+
+#endif /* CAPTURE_H */
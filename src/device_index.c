@@ -0,0 +1,169 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "device_index.h"
+
+static device_index_entry_t entries[DEVICE_INDEX_CAPACITY] = { 0 };
+static size_t               entry_count = 0;
+static pthread_mutex_t      index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t lower_bound(uint32_t instance);
+
+/**
+ * @brief Adds a routed device to the instance-sorted index.
+ *
+ * @param instance The BACnet instance number of the device.
+ * @param index    The routed device table index of the device.
+ *
+ * @return Returns 0 on success, or -1 if the index is full.
+ */
+int device_index_insert(uint32_t instance, uint32_t index)
+{
+  int result = 0;
+  pthread_mutex_lock(&index_lock);
+
+  size_t position = lower_bound(instance);
+
+  bool is_present =
+       position < entry_count
+    && entries[position].instance == instance;
+
+  if (is_present) {
+    entries[position].index = index;
+    goto unlock;
+  }
+
+  if (entry_count >= DEVICE_INDEX_CAPACITY) {
+    result = -1;
+    goto unlock;
+  }
+
+  memmove(
+    &entries[position + 1],
+    &entries[position],
+    (entry_count - position) * sizeof(entries[0])
+  );
+
+  entries[position].instance = instance;
+  entries[position].index    = index;
+  entry_count++;
+
+unlock:
+  pthread_mutex_unlock(&index_lock);
+  return result;
+}
+
+/**
+ * @brief Removes a routed device from the index.
+ *
+ * @param instance The BACnet instance number of the device.
+ *
+ * @return Returns 0 on success, or -1 if the device is not indexed.
+ */
+int device_index_remove(uint32_t instance)
+{
+  int result = -1;
+  pthread_mutex_lock(&index_lock);
+
+  size_t position = lower_bound(instance);
+
+  bool is_present =
+       position < entry_count
+    && entries[position].instance == instance;
+
+  if (is_present) {
+    memmove(
+      &entries[position],
+      &entries[position + 1],
+      (entry_count - position - 1) * sizeof(entries[0])
+    );
+
+    entry_count--;
+    result = 0;
+  }
+
+  pthread_mutex_unlock(&index_lock);
+  return result;
+}
+
+/**
+ * @brief Finds the routed device table index of a device.
+ *
+ * @param instance The BACnet instance number of the device.
+ *
+ * @return Returns the routed device table index, or -1 if not found.
+ */
+int device_index_lookup(uint32_t instance)
+{
+  int result = -1;
+  pthread_mutex_lock(&index_lock);
+
+  size_t position = lower_bound(instance);
+  if (position < entry_count && entries[position].instance == instance)
+    result = (int)entries[position].index;
+
+  pthread_mutex_unlock(&index_lock);
+  return result;
+}
+
+/**
+ * @brief Returns the number of indexed devices.
+ */
+size_t device_index_count(void)
+{
+  pthread_mutex_lock(&index_lock);
+  size_t count = entry_count;
+  pthread_mutex_unlock(&index_lock);
+
+  return count;
+}
+
+/**
+ * @brief Copies the devices within an instance range, in instance order.
+ *
+ * The first device is found with a binary search, and the rest of the range
+ * is a contiguous scan from there.
+ *
+ * @param low_limit   The lowest instance number to include.
+ * @param high_limit  The highest instance number to include.
+ * @param matches     A pointer to where the matching devices will be stored.
+ * @param max_entries The maximum number of devices to store.
+ *
+ * @return Returns the number of devices stored.
+ */
+size_t device_index_range(
+  uint32_t low_limit,
+  uint32_t high_limit,
+  device_index_entry_t* matches,
+  size_t max_entries
+) {
+  size_t count = 0;
+  pthread_mutex_lock(&index_lock);
+
+  for (size_t i = lower_bound(low_limit); i < entry_count; i++) {
+    if (entries[i].instance > high_limit || count >= max_entries)
+      break;
+
+    matches[count++] = entries[i];
+  }
+
+  pthread_mutex_unlock(&index_lock);
+  return count;
+}
+
+static size_t lower_bound(uint32_t instance)
+{
+  size_t low  = 0;
+  size_t high = entry_count;
+
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+
+    if (entries[middle].instance < instance)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return low;
+}
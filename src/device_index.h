@@ -0,0 +1,29 @@
+#ifndef DEVICE_INDEX_H
+#define DEVICE_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <bacnet/basic/object/device.h>
+
+#ifndef DEVICE_INDEX_CAPACITY
+#define DEVICE_INDEX_CAPACITY MAX_NUM_DEVICES
+#endif
+
+typedef struct {
+  uint32_t instance;
+  uint32_t index;
+} device_index_entry_t;
+
+int device_index_insert(uint32_t instance, uint32_t index);
+int device_index_remove(uint32_t instance);
+int device_index_lookup(uint32_t instance);
+size_t device_index_count(void);
+
+size_t device_index_range(
+  uint32_t low_limit,
+  uint32_t high_limit,
+  device_index_entry_t* matches,
+  size_t max_entries);
+
+#endif /* DEVICE_INDEX_H */
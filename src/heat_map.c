@@ -0,0 +1,275 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "heat_map.h"
+
+typedef struct {
+  uint32_t         rows[HEAT_MAP_DEPTH][HEAT_MAP_WIDTH];
+  heat_map_point_t top[HEAT_MAP_TOP_K];
+  size_t           top_count;
+} heat_map_t;
+
+static heat_map_t      maps[HEAT_MAP_KIND_COUNT] = { 0 };
+static pthread_mutex_t map_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void hash_point(heat_map_point_t* point, uint32_t* slots);
+static uint32_t estimate(heat_map_t* map, uint32_t* slots);
+static void update_top(heat_map_t* map, heat_map_point_t* point);
+
+/**
+ * @brief Counts an access to an object property.
+ *
+ * Counts are kept approximately in a count-min sketch, with conservative
+ * updates, so memory does not grow with the number of points. The
+ * HEAT_MAP_TOP_K points with the highest counts are tracked exactly by key
+ * in a min-heap.
+ *
+ * @param kind            Whether the property was read or subscribed to.
+ * @param device_instance The instance number of the device owning the object.
+ * @param object_type     The object's type.
+ * @param object_instance The object's instance number.
+ * @param property        The property accessed.
+ */
+void heat_map_record(
+  heat_map_kind_t kind,
+  uint32_t device_instance,
+  BACNET_OBJECT_TYPE object_type,
+  uint32_t object_instance,
+  BACNET_PROPERTY_ID property
+) {
+  heat_map_point_t point = {
+    .device_instance = device_instance,
+    .object_type     = object_type,
+    .object_instance = object_instance,
+    .property        = property,
+  };
+
+  uint32_t slots[HEAT_MAP_DEPTH] = { 0 };
+  hash_point(&point, slots);
+
+  pthread_mutex_lock(&map_lock);
+
+  heat_map_t* map = &maps[kind];
+
+  // only the rows at the minimum are raised, which bounds overestimation
+  point.count = estimate(map, slots) + 1;
+
+  for (int row = 0; row < HEAT_MAP_DEPTH; row++) {
+    if (map->rows[row][slots[row]] < point.count)
+      map->rows[row][slots[row]] = point.count;
+  }
+
+  update_top(map, &point);
+
+  pthread_mutex_unlock(&map_lock);
+}
+
+/**
+ * @brief Returns the approximate access count of an object property.
+ *
+ * The estimate is never lower than the true count.
+ *
+ * @param kind            Whether to count reads or subscriptions.
+ * @param device_instance The instance number of the device owning the object.
+ * @param object_type     The object's type.
+ * @param object_instance The object's instance number.
+ * @param property        The property accessed.
+ */
+uint32_t heat_map_estimate(
+  heat_map_kind_t kind,
+  uint32_t device_instance,
+  BACNET_OBJECT_TYPE object_type,
+  uint32_t object_instance,
+  BACNET_PROPERTY_ID property
+) {
+  heat_map_point_t point = {
+    .device_instance = device_instance,
+    .object_type     = object_type,
+    .object_instance = object_instance,
+    .property        = property,
+  };
+
+  uint32_t slots[HEAT_MAP_DEPTH] = { 0 };
+  hash_point(&point, slots);
+
+  pthread_mutex_lock(&map_lock);
+  uint32_t count = estimate(&maps[kind], slots);
+  pthread_mutex_unlock(&map_lock);
+
+  return count;
+}
+
+static int compare_points(const void* a, const void* b)
+{
+  const heat_map_point_t* left  = a;
+  const heat_map_point_t* right = b;
+
+  if (left->count == right->count)
+    return 0;
+
+  return left->count < right->count ? 1 : -1;
+}
+
+/**
+ * @brief Lists the most accessed object properties.
+ *
+ * @param kind       Whether to list reads or subscriptions.
+ * @param points     A pointer to where the points will be stored.
+ * @param max_points The maximum number of points to store.
+ *
+ * @return Returns the number of points stored, hottest first.
+ */
+size_t heat_map_top(
+  heat_map_kind_t kind,
+  heat_map_point_t* points,
+  size_t max_points
+) {
+  heat_map_point_t top[HEAT_MAP_TOP_K] = { 0 };
+
+  pthread_mutex_lock(&map_lock);
+
+  size_t count = maps[kind].top_count;
+  memcpy(top, maps[kind].top, count * sizeof(top[0]));
+
+  pthread_mutex_unlock(&map_lock);
+
+  qsort(top, count, sizeof(top[0]), compare_points);
+
+  if (count > max_points)
+    count = max_points;
+
+  memcpy(points, top, count * sizeof(top[0]));
+
+  return count;
+}
+
+/**
+ * @brief Clears all counts.
+ */
+void heat_map_reset(void)
+{
+  pthread_mutex_lock(&map_lock);
+  memset(maps, 0, sizeof(maps));
+  pthread_mutex_unlock(&map_lock);
+}
+
+static uint64_t mix(uint64_t value)
+{
+  // splitmix64 finalizer
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebULL;
+  value ^= value >> 31;
+
+  return value;
+}
+
+static void hash_point(heat_map_point_t* point, uint32_t* slots)
+{
+  uint64_t object =
+      ((uint64_t)point->object_type << 22)
+    | (point->object_instance & 0x3FFFFF);
+
+  uint64_t key =
+    mix(((uint64_t)point->device_instance << 32) | object)
+    ^ mix((uint64_t)point->property + 0x9e3779b97f4a7c15ULL);
+
+  // double hashing derives every row's slot from two hashes
+  uint64_t first  = mix(key);
+  uint64_t second = mix(first) | 1;
+
+  for (int row = 0; row < HEAT_MAP_DEPTH; row++) {
+    uint64_t hash = first + row * second;
+    slots[row] = (uint32_t)(hash >> 32) & (HEAT_MAP_WIDTH - 1);
+  }
+}
+
+static uint32_t estimate(heat_map_t* map, uint32_t* slots)
+{
+  uint32_t count = UINT32_MAX;
+
+  for (int row = 0; row < HEAT_MAP_DEPTH; row++) {
+    if (map->rows[row][slots[row]] < count)
+      count = map->rows[row][slots[row]];
+  }
+
+  return count;
+}
+
+static bool is_same_point(heat_map_point_t* a, heat_map_point_t* b)
+{
+  return
+       a->device_instance == b->device_instance
+    && a->object_type == b->object_type
+    && a->object_instance == b->object_instance
+    && a->property == b->property;
+}
+
+static void swap_points(heat_map_point_t* a, heat_map_point_t* b)
+{
+  heat_map_point_t swap = *a;
+  *a = *b;
+  *b = swap;
+}
+
+static void sift_down(heat_map_t* map, size_t position)
+{
+  while (true) {
+    heat_map_point_t* top = map->top;
+
+    size_t smallest = position;
+    size_t left     = 2 * position + 1;
+    size_t right    = left + 1;
+
+    if (left < map->top_count && top[left].count < top[smallest].count)
+      smallest = left;
+
+    if (right < map->top_count && top[right].count < top[smallest].count)
+      smallest = right;
+
+    if (smallest == position)
+      return;
+
+    swap_points(&map->top[position], &map->top[smallest]);
+    position = smallest;
+  }
+}
+
+static void sift_up(heat_map_t* map, size_t position)
+{
+  while (position > 0) {
+    size_t parent = (position - 1) / 2;
+
+    if (map->top[parent].count <= map->top[position].count)
+      return;
+
+    swap_points(&map->top[position], &map->top[parent]);
+    position = parent;
+  }
+}
+
+static void update_top(heat_map_t* map, heat_map_point_t* point)
+{
+  // the heap is small enough that a linear search beats a second index
+  for (size_t i = 0; i < map->top_count; i++) {
+    if (is_same_point(&map->top[i], point)) {
+      map->top[i].count = point->count;
+      sift_down(map, i);
+      return;
+    }
+  }
+
+  if (map->top_count < HEAT_MAP_TOP_K) {
+    map->top[map->top_count++] = *point;
+    sift_up(map, map->top_count - 1);
+    return;
+  }
+
+  if (point->count > map->top[0].count) {
+    map->top[0] = *point;
+    sift_down(map, 0);
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef HEAT_MAP_H
+#define HEAT_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <bacnet/bacenum.h>
+
+// counters per row of the count-min sketch, a power of two
+#ifndef HEAT_MAP_WIDTH
+#define HEAT_MAP_WIDTH 2048
+#endif
+
+#ifndef HEAT_MAP_DEPTH
+#define HEAT_MAP_DEPTH 4
+#endif
+
+#ifndef HEAT_MAP_TOP_K
+#define HEAT_MAP_TOP_K 32
+#endif
+
+typedef enum {
+  HEAT_MAP_READ,
+  HEAT_MAP_SUBSCRIBE,
+  HEAT_MAP_KIND_COUNT,
+} heat_map_kind_t;
+
+typedef struct {
+  uint32_t           device_instance;
+  BACNET_OBJECT_TYPE object_type;
+  uint32_t           object_instance;
+  BACNET_PROPERTY_ID property;
+  uint32_t           count;
+} heat_map_point_t;
+
+void heat_map_record(
+  heat_map_kind_t kind,
+  uint32_t device_instance,
+  BACNET_OBJECT_TYPE object_type,
+  uint32_t object_instance,
+  BACNET_PROPERTY_ID property);
+
+uint32_t heat_map_estimate(
+  heat_map_kind_t kind,
+  uint32_t device_instance,
+  BACNET_OBJECT_TYPE object_type,
+  uint32_t object_instance,
+  BACNET_PROPERTY_ID property);
+
+size_t heat_map_top(
+  heat_map_kind_t kind,
+  heat_map_point_t* points,
+  size_t max_points);
+
+void heat_map_reset(void);
+
+#endif /* HEAT_MAP_H */
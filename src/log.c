@@ -1,53 +1,195 @@
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "log.h"
 #include "port.h"
 
 #define MAX_LOG_LEN 1024
+#define RATE_SITES  128
+
+typedef struct {
+  atomic_size_t sequence;
+  log_level_t   level;
+  char          message[MAX_LOG_LEN];
+} log_slot_t;
+
+typedef struct {
+  _Atomic(const char*) format;
+  atomic_uint_fast64_t window;
+  atomic_uint          count;
+  atomic_uint          suppressed;
+  log_level_t          level;
+} log_site_t;
+
+atomic_int log_max_level = DEBUG;
+
+static log_slot_t    ring[LOG_RING_SIZE];
+static atomic_size_t enqueue_position = 0;
+static size_t        dequeue_position = 0;
+static atomic_uint   dropped = 0;
+static log_site_t    sites[RATE_SITES];
+static sem_t         pending;
+static pthread_t     writer_thread_id;
+static atomic_bool   is_writer_running = false;
+static atomic_bool   should_stop = false;
 
 static const char* level_to_str(log_level_t level);
+static void* writer_loop(void* arg);
+static bool is_suppressed(log_level_t level, const char* format);
+static int write_message(log_level_t level, const char* message);
+
+/**
+ * @brief Starts the background log writer.
+ *
+ * Messages logged before the writer starts, or after it stops, are sent
+ * synchronously. The initial level may be set with `BACNET_LOG_LEVEL`,
+ * using the same names as the Elixir Logger levels.
+ *
+ * @return Returns 0 on success, or -1 if the writer thread cannot be created.
+ */
+int log_start(void)
+{
+  const char* level_raw = getenv("BACNET_LOG_LEVEL");
+
+  for (int level = EMERGENCY; level_raw && level <= DEBUG; level++) {
+    if (strcmp(level_raw, level_to_str(level)) == 0)
+      log_set_level(level);
+  }
+
+  for (size_t i = 0; i < LOG_RING_SIZE; i++)
+    atomic_init(&ring[i].sequence, i);
+
+  if (sem_init(&pending, 0, 0) != 0)
+    return -1;
+
+  atomic_store(&should_stop, false);
+
+  if (pthread_create(&writer_thread_id, NULL, &writer_loop, NULL) != 0)
+    return -1;
+
+  atomic_store(&is_writer_running, true);
+
+  return 0;
+}
+
+/**
+ * @brief Flushes queued messages and stops the background log writer.
+ */
+void log_stop(void)
+{
+  if (!atomic_load(&is_writer_running))
+    return;
+
+  atomic_store(&should_stop, true);
+  sem_post(&pending);
+  pthread_join(writer_thread_id, NULL);
+
+  atomic_store(&is_writer_running, false);
+}
+
+/**
+ * @brief Sets the least severe level that is logged.
+ *
+ * Messages below this level are discarded by the LOG_* macros before their
+ * arguments are formatted.
+ *
+ * @param level The least severe level to log.
+ */
+void log_set_level(log_level_t level)
+{
+  if (level > DEBUG)
+    level = DEBUG;
+
+  atomic_store_explicit(&log_max_level, level, memory_order_relaxed);
+}
 
 /**
  * @brief Sends a log message at a specified log level.
  *
- * Prepares a log message based on the provided format and arguments, and
- * dispatches it through the port. If transmission fails, then the an attempt
- * is made to print to stderr.
+ * Formats the message directly into a slot of a lock-free ring, which is
+ * drained by the background writer. A call site that logs more than
+ * LOG_RATE_BURST messages within LOG_RATE_WINDOW_MS is suppressed for the
+ * rest of the window, and the writer reports how many messages it lost.
+ * If the ring is full, the message is dropped and counted.
  *
  * @param level  The log level indicating the severity of the message.
  * @param format The format string for the log message.
  * @param ...    Additional arguments for the format string.
  *
- * @return Returns 0 on success, or -1 if message formatting fails.
+ * @return Returns 0 on success, or -1 if the message was not queued.
  */
 int send_log(log_level_t level, const char* format, ...)
 {
   va_list args;
   va_start(args, format);
 
-  char buffer[MAX_LOG_LEN];
-  int length = vsnprintf(buffer, sizeof(buffer), format, args);
-  if (length < 0) {
+  if (!atomic_load_explicit(&is_writer_running, memory_order_acquire)) {
+    char buffer[MAX_LOG_LEN];
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    if (length < 0)
+      return -1;
+
+    return write_message(level, buffer);
+  }
+
+  if (is_suppressed(level, format)) {
     va_end(args);
     return -1;
   }
 
-  ei_x_buff message;
-  ei_x_new_with_version(&message);
-  ei_x_encode_tuple_header(&message, 3);
-  ei_x_encode_atom(&message, "log");
-  ei_x_encode_atom(&message, level_to_str(level));
-  ei_x_encode_string(&message, buffer);
+  // bounded MPMC queue, each slot's sequence tells whose turn it is
+  log_slot_t* slot     = NULL;
+  size_t      position =
+    atomic_load_explicit(&enqueue_position, memory_order_relaxed);
 
-  if (port_send(&message) == -1) {
-    fprintf(stderr, "failed to send log %d\n", errno);
-    vfprintf(stderr, format, args);
-    fprintf(stderr, "\n");
+  while (true) {
+    slot = &ring[position % LOG_RING_SIZE];
+
+    size_t   sequence =
+      atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    intptr_t distance = (intptr_t)sequence - (intptr_t)position;
+
+    if (distance < 0) {
+      atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+      va_end(args);
+      return -1;
+    }
+
+    bool is_claimed =
+         distance == 0
+      && atomic_compare_exchange_weak_explicit(
+           &enqueue_position,
+           &position,
+           position + 1,
+           memory_order_relaxed,
+           memory_order_relaxed
+         );
+
+    if (is_claimed)
+      break;
+
+    if (distance > 0)
+      position = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
   }
 
-  ei_x_free(&message);
+  if (vsnprintf(slot->message, sizeof(slot->message), format, args) < 0)
+    strcpy(slot->message, format);
+
   va_end(args);
 
+  slot->level = level;
+  atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+  sem_post(&pending);
+
   return 0;
 }
 
@@ -64,3 +206,177 @@ static const char* level_to_str(log_level_t level)
     case DEBUG:     return "debug";
   }
 }
+
+static int write_message(log_level_t level, const char* message)
+{
+  ei_x_buff term;
+  ei_x_new_with_version(&term);
+  ei_x_encode_tuple_header(&term, 3);
+  ei_x_encode_atom(&term, "log");
+  ei_x_encode_atom(&term, level_to_str(level));
+  ei_x_encode_string(&term, message);
+
+  int result = port_send(&term);
+  if (result == -1) {
+    fprintf(stderr, "failed to send log %d\n", errno);
+    fprintf(stderr, "%s\n", message);
+  }
+
+  ei_x_free(&term);
+
+  return result;
+}
+
+static bool drain(void)
+{
+  bool is_drained = false;
+
+  while (true) {
+    log_slot_t* slot = &ring[dequeue_position % LOG_RING_SIZE];
+
+    size_t sequence =
+      atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+    if (sequence != dequeue_position + 1)
+      break;
+
+    write_message(slot->level, slot->message);
+
+    atomic_store_explicit(
+      &slot->sequence,
+      dequeue_position + LOG_RING_SIZE,
+      memory_order_release
+    );
+
+    dequeue_position++;
+    is_drained = true;
+  }
+
+  return is_drained;
+}
+
+static void report_suppressed(uint64_t window)
+{
+  char message[MAX_LOG_LEN];
+
+  for (size_t i = 0; i < RATE_SITES; i++) {
+    log_site_t* site   = &sites[i];
+    const char* format = atomic_load(&site->format);
+
+    // summaries wait until the site's window has closed
+    bool is_due =
+         format != NULL
+      && atomic_load(&site->suppressed) > 0
+      && atomic_load(&site->window) < window;
+
+    if (!is_due)
+      continue;
+
+    unsigned count = atomic_exchange(&site->suppressed, 0);
+
+    snprintf(
+      message,
+      sizeof(message),
+      "bacnetd: %u messages suppressed like \"%s\"",
+      count,
+      format
+    );
+
+    write_message(site->level, message);
+  }
+
+  unsigned dropped_count = atomic_exchange(&dropped, 0);
+
+  if (dropped_count > 0) {
+    snprintf(
+      message,
+      sizeof(message),
+      "bacnetd: %u log messages dropped, log ring full",
+      dropped_count
+    );
+
+    write_message(WARNING, message);
+  }
+}
+
+static uint64_t now_window(void)
+{
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+
+  uint64_t now_ms = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+
+  return now_ms / LOG_RATE_WINDOW_MS;
+}
+
+static void* writer_loop(void* arg)
+{
+  while (true) {
+    struct timespec deadline = { 0 };
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (LOG_RATE_WINDOW_MS + 999) / 1000;
+
+    sem_timedwait(&pending, &deadline);
+
+    // one post per message, the rest were already drained with this one
+    while (drain())
+      while (sem_trywait(&pending) == 0);
+
+    report_suppressed(now_window());
+
+    if (atomic_load(&should_stop)) {
+      drain();
+      break;
+    }
+  }
+
+  pthread_exit(NULL);
+}
+
+static log_site_t* find_site(log_level_t level, const char* format)
+{
+  size_t hash = ((uintptr_t)format >> 3) % RATE_SITES;
+
+  for (size_t i = 0; i < RATE_SITES; i++) {
+    log_site_t* site     = &sites[(hash + i) % RATE_SITES];
+    const char* expected = NULL;
+
+    if (atomic_load(&site->format) == format)
+      return site;
+
+    if (atomic_compare_exchange_strong(&site->format, &expected, format)) {
+      site->level = level;
+      return site;
+    }
+
+    if (expected == format)
+      return site;
+  }
+
+  return NULL;
+}
+
+static bool is_suppressed(log_level_t level, const char* format)
+{
+  // call sites are told apart by their format string literal
+  log_site_t* site = find_site(level, format);
+  if (site == NULL)
+    return false;
+
+  uint64_t window  = now_window();
+  uint64_t current = atomic_load(&site->window);
+
+  bool is_new_window =
+       current != window
+    && atomic_compare_exchange_strong(&site->window, &current, window);
+
+  if (is_new_window)
+    atomic_store(&site->count, 0);
+
+  if (atomic_fetch_add(&site->count, 1) < LOG_RATE_BURST)
+    return false;
+
+  atomic_fetch_add(&site->suppressed, 1);
+
+  return true;
+}
@@ -1,14 +1,36 @@
 #ifndef LOG_H
 #define LOG_H
 
-#define LOG_EMERGENCY(format, ...) send_log(EMERGENCY, format, ##__VA_ARGS__)
-#define LOG_ALERT(format, ...)     send_log(ALERT, format, ##__VA_ARGS__)
-#define LOG_CRITICAL(format, ...)  send_log(CRITICAL, format, ##__VA_ARGS__)
-#define LOG_ERROR(format, ...)     send_log(ERROR, format, ##__VA_ARGS__)
-#define LOG_WARNING(format, ...)   send_log(WARNING, format, ##__VA_ARGS__)
-#define LOG_NOTICE(format, ...)    send_log(NOTICE, format, ##__VA_ARGS__)
-#define LOG_INFO(format, ...)      send_log(INFO, format, ##__VA_ARGS__)
-#define LOG_DEBUG(format, ...)     send_log(DEBUG, format, ##__VA_ARGS__)
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 256
+#endif
+
+#ifndef LOG_RATE_WINDOW_MS
+#define LOG_RATE_WINDOW_MS 1000
+#endif
+
+#ifndef LOG_RATE_BURST
+#define LOG_RATE_BURST 20
+#endif
+
+// the level is checked before the arguments are evaluated or formatted
+#define LOG_AT(level, format, ...)               \
+  do {                                           \
+    if (log_is_enabled(level))                   \
+      send_log(level, format, ##__VA_ARGS__);    \
+  } while (0)
+
+#define LOG_EMERGENCY(format, ...) LOG_AT(EMERGENCY, format, ##__VA_ARGS__)
+#define LOG_ALERT(format, ...)     LOG_AT(ALERT, format, ##__VA_ARGS__)
+#define LOG_CRITICAL(format, ...)  LOG_AT(CRITICAL, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...)     LOG_AT(ERROR, format, ##__VA_ARGS__)
+#define LOG_WARNING(format, ...)   LOG_AT(WARNING, format, ##__VA_ARGS__)
+#define LOG_NOTICE(format, ...)    LOG_AT(NOTICE, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...)      LOG_AT(INFO, format, ##__VA_ARGS__)
+#define LOG_DEBUG(format, ...)     LOG_AT(DEBUG, format, ##__VA_ARGS__)
 
 typedef enum {
   EMERGENCY,
@@ -21,6 +43,16 @@ typedef enum {
   DEBUG,
 } log_level_t;
 
+extern atomic_int log_max_level;
+
+static inline bool log_is_enabled(log_level_t level)
+{
+  return (int)level <= atomic_load_explicit(&log_max_level, memory_order_relaxed);
+}
+
+int log_start(void);
+void log_stop(void);
+void log_set_level(log_level_t level);
 int send_log(log_level_t level, const char* format, ...);
 
 #endif /* LOG_H */
@@ -1,6 +1,9 @@
 #include "bacnet.h"
+#include "capture.h"
 #include "log.h"
 #include "port.h"
+#include "snapshot.h"
+#include "watchdog.h"
 
 int main(int argc, char** argv)
 {
@@ -9,15 +12,31 @@ int main(int argc, char** argv)
     return -1;
   }
 
+  if (log_start() == -1)
+    LOG_WARNING("bacnetd: failed to start log writer, logging synchronously");
+
+  if (capture_start() == -1)
+    LOG_WARNING("bacnetd: failed to start traffic capture");
+
+  if (snapshot_start() == -1)
+    LOG_WARNING("bacnetd: failed to start snapshot writer");
+
   if (bacnet_start_services() != 0) {
     LOG_ERROR("bacnetd: failed to start bacnet services");
     return -1;
   }
 
+  if (watchdog_start() == -1)
+    LOG_WARNING("bacnetd: failed to start event loop watchdog");
+
   LOG_DEBUG("bacnetd: process started");
   port_wait_until_done();
   bacnet_stop_services();
   bacnet_wait_until_done();
+  snapshot_stop();
+  capture_stop();
+  watchdog_stop();
+  log_stop();
 
   return 0;
 }
@@ -0,0 +1,203 @@
+#include <malloc.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "memory.h"
+
+/*
+ * Heap usage is charged to the subsystem that allocated it, using the
+ * allocator's usable size, so that slack is counted too. Buffers owned by
+ * another allocator, such as ei's, are charged with memory_track once they
+ * are allocated.
+ */
+
+typedef struct {
+  atomic_size_t bytes;
+  atomic_size_t allocations;
+  atomic_size_t peak_bytes;
+} account_t;
+
+static account_t accounts[MEMORY_SUBSYSTEM_COUNT] = { 0 };
+static account_t total = { 0 };
+
+static void charge(account_t* account, size_t bytes);
+static void credit(account_t* account, size_t bytes);
+static void read_account(account_t* account, memory_stats_t* stats);
+
+/**
+ * @brief Allocates memory charged to a subsystem.
+ *
+ * @param subsystem The subsystem the memory is charged to.
+ * @param size      The number of bytes to allocate.
+ *
+ * @return Returns the memory, or NULL if it could not be allocated.
+ */
+void* memory_malloc(memory_subsystem_t subsystem, size_t size)
+{
+  void* pointer = malloc(size);
+  memory_track(subsystem, pointer);
+
+  return pointer;
+}
+
+/**
+ * @brief Allocates zeroed memory charged to a subsystem.
+ *
+ * @param subsystem The subsystem the memory is charged to.
+ * @param count     The number of elements to allocate.
+ * @param size      The size of each element.
+ *
+ * @return Returns the memory, or NULL if it could not be allocated.
+ */
+void* memory_calloc(memory_subsystem_t subsystem, size_t count, size_t size)
+{
+  void* pointer = calloc(count, size);
+  memory_track(subsystem, pointer);
+
+  return pointer;
+}
+
+/**
+ * @brief Resizes memory charged to a subsystem.
+ *
+ * @param subsystem The subsystem the memory is charged to.
+ * @param pointer   Memory from the same subsystem, or NULL.
+ * @param size      The new size in bytes.
+ *
+ * @return Returns the resized memory, or NULL if it could not be resized,
+ *         in which case `pointer` is left as is.
+ */
+void* memory_realloc(memory_subsystem_t subsystem, void* pointer, size_t size)
+{
+  size_t old_size = pointer ? malloc_usable_size(pointer) : 0;
+  void*  resized  = realloc(pointer, size);
+
+  if (resized == NULL)
+    return NULL;
+
+  if (pointer) {
+    credit(&accounts[subsystem], old_size);
+    credit(&total, old_size);
+  }
+
+  memory_track(subsystem, resized);
+
+  return resized;
+}
+
+/**
+ * @brief Allocates aligned memory charged to a subsystem.
+ *
+ * @param subsystem The subsystem the memory is charged to.
+ * @param alignment The alignment, a power of two.
+ * @param size      The number of bytes to allocate, a multiple of alignment.
+ *
+ * @return Returns the memory, or NULL if it could not be allocated.
+ */
+void* memory_aligned_alloc(
+  memory_subsystem_t subsystem,
+  size_t alignment,
+  size_t size
+) {
+  void* pointer = aligned_alloc(alignment, size);
+  memory_track(subsystem, pointer);
+
+  return pointer;
+}
+
+/**
+ * @brief Frees memory charged to a subsystem.
+ *
+ * @param subsystem The subsystem the memory was charged to.
+ * @param pointer   The memory, or NULL.
+ */
+void memory_free(memory_subsystem_t subsystem, void* pointer)
+{
+  memory_untrack(subsystem, pointer);
+  free(pointer);
+}
+
+/**
+ * @brief Charges memory allocated elsewhere to a subsystem.
+ *
+ * @param subsystem The subsystem to charge.
+ * @param pointer   Memory from the C allocator, or NULL.
+ */
+void memory_track(memory_subsystem_t subsystem, void* pointer)
+{
+  if (pointer == NULL)
+    return;
+
+  size_t size = malloc_usable_size(pointer);
+
+  charge(&accounts[subsystem], size);
+  charge(&total, size);
+}
+
+/**
+ * @brief Stops charging memory to a subsystem, before it is freed elsewhere.
+ *
+ * @param subsystem The subsystem the memory was charged to.
+ * @param pointer   The memory, or NULL.
+ */
+void memory_untrack(memory_subsystem_t subsystem, void* pointer)
+{
+  if (pointer == NULL)
+    return;
+
+  size_t size = malloc_usable_size(pointer);
+
+  credit(&accounts[subsystem], size);
+  credit(&total, size);
+}
+
+/**
+ * @brief Reports the memory charged to a subsystem.
+ *
+ * @param subsystem  The subsystem to report on.
+ * @param[out] stats The live bytes and allocations, and the most bytes that
+ *                   were live at once.
+ */
+void memory_get_stats(memory_subsystem_t subsystem, memory_stats_t* stats)
+{
+  read_account(&accounts[subsystem], stats);
+}
+
+/**
+ * @brief Reports the memory charged to all subsystems.
+ *
+ * The peak is that of the sum, not the sum of the subsystems' peaks.
+ *
+ * @param[out] stats The live bytes and allocations, and the most bytes that
+ *                   were live at once.
+ */
+void memory_get_total(memory_stats_t* stats)
+{
+  read_account(&total, stats);
+}
+
+static void charge(account_t* account, size_t bytes)
+{
+  size_t live = atomic_fetch_add(&account->bytes, bytes) + bytes;
+  size_t peak = atomic_load(&account->peak_bytes);
+
+  atomic_fetch_add(&account->allocations, 1);
+
+  while (live > peak) {
+    if (atomic_compare_exchange_weak(&account->peak_bytes, &peak, live))
+      break;
+  }
+}
+
+static void credit(account_t* account, size_t bytes)
+{
+  atomic_fetch_sub(&account->bytes, bytes);
+  atomic_fetch_sub(&account->allocations, 1);
+}
+
+static void read_account(account_t* account, memory_stats_t* stats)
+{
+  stats->bytes       = atomic_load(&account->bytes);
+  stats->allocations = atomic_load(&account->allocations);
+  stats->peak_bytes  = atomic_load(&account->peak_bytes);
+}
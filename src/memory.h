@@ -0,0 +1,40 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stddef.h>
+
+typedef enum {
+  MEMORY_OBJECTS,
+  MEMORY_STRINGS,
+  MEMORY_NAME_INDEX,
+  MEMORY_VALUE_TABLE,
+  MEMORY_CALLS,
+  MEMORY_PORT,
+  MEMORY_SEGMENTS,
+  MEMORY_SNAPSHOT,
+  MEMORY_SUBSYSTEM_COUNT,
+} memory_subsystem_t;
+
+typedef struct {
+  size_t bytes;
+  size_t allocations;
+  size_t peak_bytes;
+} memory_stats_t;
+
+void* memory_malloc(memory_subsystem_t subsystem, size_t size);
+void* memory_calloc(memory_subsystem_t subsystem, size_t count, size_t size);
+void* memory_realloc(memory_subsystem_t subsystem, void* pointer, size_t size);
+
+void* memory_aligned_alloc(
+  memory_subsystem_t subsystem,
+  size_t alignment,
+  size_t size);
+
+void memory_free(memory_subsystem_t subsystem, void* pointer);
+void memory_track(memory_subsystem_t subsystem, void* pointer);
+void memory_untrack(memory_subsystem_t subsystem, void* pointer);
+
+void memory_get_stats(memory_subsystem_t subsystem, memory_stats_t* stats);
+void memory_get_total(memory_stats_t* stats);
+
+#endif /* MEMORY_H */
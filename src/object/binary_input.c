@@ -3,6 +3,8 @@
 #include <bacnet/basic/object/routed_object.h>
 
 #include "object/binary_input.h"
+#include "object/name_index.h"
+#include "object/string_arena.h"
 
 static const int required_properties[] = {
   PROP_OBJECT_IDENTIFIER,
@@ -26,6 +28,17 @@ static const int optional_properties[] = {
 
 static const int proprietary_properties[] = { -1 };
 
+static slab_pool_t object_pool = SLAB_POOL_INITIALIZER(BINARY_INPUT_OBJECT);
+
+static void free_object(DEVICE_OBJECT_DATA* device, BINARY_INPUT_OBJECT* object)
+{
+  string_arena_release(object->name);
+  string_arena_release(object->description);
+  string_arena_release(object->active_text);
+  string_arena_release(object->inactive_text);
+  slab_free(&object_pool, device, object);
+}
+
 /**
  * @brief Handles any setup required to create binary-input objects.
  */
@@ -64,7 +77,19 @@ uint32_t binary_input_create(
   if (object != NULL)
     return instance;
 
-  object = calloc(1, sizeof(BINARY_INPUT_OBJECT));
+  uint32_t device_instance = device->bacObj.Object_Instance_Number;
+  bool is_name_available =
+    name_index_is_available(
+      device_instance,
+      name,
+      OBJECT_BINARY_INPUT,
+      instance
+    );
+
+  if (!is_name_available)
+    return BACNET_MAX_INSTANCE;
+
+  object = slab_alloc(&object_pool, device);
   if (!object)
     return BACNET_MAX_INSTANCE;
 
@@ -72,24 +97,67 @@ uint32_t binary_input_create(
   object->polarity = polarity;
   object->present_value = value;
 
-  memset(object->name, 0, sizeof(object->name));
-  memset(object->description, 0, sizeof(object->description));
-  memset(object->active_text, 0, sizeof(object->active_text));
-  memset(object->inactive_text, 0, sizeof(object->inactive_text));
+  object->name          = string_arena_intern(name, strlen(name));
+  object->description   = string_arena_intern(description, strlen(description));
+  object->active_text   = string_arena_intern(active_text, strlen(active_text));
+  object->inactive_text =
+    string_arena_intern(inactive_text, strlen(inactive_text));
 
-  memcpy(object->name, name, strlen(name));
-  memcpy(object->description, description, strlen(description));
-  memcpy(object->active_text, active_text, strlen(active_text));
-  memcpy(object->inactive_text, inactive_text, strlen(inactive_text));
+  bool is_interned =
+       object->name
+    && object->description
+    && object->active_text
+    && object->inactive_text;
+
+  if (!is_interned) {
+    free_object(device, object);
+    return BACNET_MAX_INSTANCE;
+  }
 
   if (Keylist_Data_Add(device->objects, instance, object) < 0) {
-    free(object);
+    free_object(device, object);
+    return BACNET_MAX_INSTANCE;
+  }
+
+  bool is_indexed =
+    name_index_insert(
+      device_instance,
+      object->name,
+      OBJECT_BINARY_INPUT,
+      instance
+    );
+
+  if (!is_indexed) {
+    Keylist_Data_Delete(device->objects, instance);
+    free_object(device, object);
     return BACNET_MAX_INSTANCE;
   }
 
   return instance;
 }
 
+/**
+ * @brief Deletes a binary-input object and releases its memory.
+ *
+ * @param device - The device owning the object.
+ * @param instance - Object instance number.
+ *
+ * @return false if the device has no binary-input object with that instance.
+ */
+bool binary_input_delete(DEVICE_OBJECT_DATA* device, uint32_t instance)
+{
+  BINARY_INPUT_OBJECT* object = Keylist_Data(device->objects, instance);
+
+  if (!object || object->type != OBJECT_BINARY_INPUT)
+    return false;
+
+  Keylist_Data_Delete(device->objects, instance);
+  name_index_remove(device->bacObj.Object_Instance_Number, object->name);
+  free_object(device, object);
+
+  return true;
+}
+
 /**
  * @brief Returns the count of binary-input value objects for the currently
  *        selected Device.
@@ -145,9 +213,11 @@ bool binary_input_name(uint32_t instance, BACNET_CHARACTER_STRING* name) {
   BINARY_INPUT_OBJECT* object = Keylist_Data(device->objects, instance);
 
   if (object == NULL) return false;
-  if (strlen(object->name) <= 0) return false;
 
-  return characterstring_init_ansi(name, object->name);
+  size_t length = string_arena_length(object->name);
+  if (length == 0) return false;
+
+  return characterstring_init(name, CHARACTER_ANSI_X34, object->name, length);
 }
 
 /**
@@ -160,9 +230,15 @@ bool binary_input_description(
   BINARY_INPUT_OBJECT* object,
   BACNET_CHARACTER_STRING* description
 ) {
-  if (strlen(object->description) <= 0) return false;
-
-  return characterstring_init_ansi(description, object->description);
+  size_t length = string_arena_length(object->description);
+  if (length == 0) return false;
+
+  return characterstring_init(
+    description,
+    CHARACTER_ANSI_X34,
+    object->description,
+    length
+  );
 }
 
 /**
@@ -175,9 +251,15 @@ bool binary_input_active_text(
   BINARY_INPUT_OBJECT* object,
   BACNET_CHARACTER_STRING* active_text
 ) {
-  if (strlen(object->active_text) <= 0) return false;
-
-  return characterstring_init_ansi(active_text, object->active_text);
+  size_t length = string_arena_length(object->active_text);
+  if (length == 0) return false;
+
+  return characterstring_init(
+    active_text,
+    CHARACTER_ANSI_X34,
+    object->active_text,
+    length
+  );
 }
 
 /**
@@ -190,9 +272,15 @@ bool binary_input_inactive_text(
   BINARY_INPUT_OBJECT* object,
   BACNET_CHARACTER_STRING* inactive_text
 ) {
-  if (strlen(object->inactive_text) <= 0) return false;
-
-  return characterstring_init_ansi(inactive_text, object->inactive_text);
+  size_t length = string_arena_length(object->inactive_text);
+  if (length == 0) return false;
+
+  return characterstring_init(
+    inactive_text,
+    CHARACTER_ANSI_X34,
+    object->inactive_text,
+    length
+  );
 }
 
 /**
@@ -345,3 +433,16 @@ bool binary_input_set_present_value(BINARY_INPUT_OBJECT* object, bool value)
 
   return true;
 }
+
+/**
+ * @brief Reports the utilization of the binary-input object slabs.
+ *
+ * @param device - The device to report on, or NULL for all of them.
+ * @param[out] stats - Utilization over the device's slabs.
+ */
+void binary_input_slab_stats(
+  const DEVICE_OBJECT_DATA* device,
+  slab_stats_t* stats
+) {
+  slab_get_stats(&object_pool, device, stats);
+}
@@ -2,15 +2,16 @@
 #define BACNET_OBJECT_BINARY_INPUT_H
 
 #include "object/common.h"
+#include "object/slab.h"
 
 typedef struct {
   BACNET_OBJECT_TYPE type;
 
-  char name[MAX_STRING_LEN];
-  char description[MAX_STRING_LEN];
-  char active_text[MAX_STRING_LEN];
-  char inactive_text[MAX_STRING_LEN];
-  bool present_value;
+  const char* name;
+  const char* description;
+  const char* active_text;
+  const char* inactive_text;
+  bool        present_value;
 
   BACNET_POLARITY polarity;
 } BINARY_INPUT_OBJECT;
@@ -33,6 +34,12 @@ uint32_t binary_input_create(
   char* active_text,
   char* inactive_text);
 
+bool binary_input_delete(DEVICE_OBJECT_DATA* device, uint32_t instance);
+
+void binary_input_slab_stats(
+  const DEVICE_OBJECT_DATA* device,
+  slab_stats_t* stats);
+
 void binary_input_property_lists(
   const int** required,
   const int** optional,
@@ -3,6 +3,8 @@
 #include <bacnet/basic/object/routed_object.h>
 
 #include "object/characterstring_value.h"
+#include "object/name_index.h"
+#include "object/string_arena.h"
 
 static const int required_properties[] = {
   PROP_OBJECT_IDENTIFIER,
@@ -22,6 +24,19 @@ static const int optional_properties[] = {
 
 static const int proprietary_properties[] = { -1 };
 
+static slab_pool_t object_pool =
+  SLAB_POOL_INITIALIZER(CHARACTERSTRING_VALUE_OBJECT);
+
+static void free_object(
+  DEVICE_OBJECT_DATA* device,
+  CHARACTERSTRING_VALUE_OBJECT* object
+) {
+  string_arena_release(object->name);
+  string_arena_release(object->description);
+  string_arena_release(object->present_value);
+  slab_free(&object_pool, device, object);
+}
+
 /**
  * @brief Handles any setup required to create character-string objects.
  */
@@ -58,28 +73,86 @@ uint32_t characterstring_value_create(
   if (object != NULL)
     return instance;
 
-  object = calloc(1, sizeof(CHARACTERSTRING_VALUE_OBJECT));
+  uint32_t device_instance = device->bacObj.Object_Instance_Number;
+  bool is_name_available =
+    name_index_is_available(
+      device_instance,
+      name,
+      OBJECT_CHARACTERSTRING_VALUE,
+      instance
+    );
+
+  if (!is_name_available)
+    return BACNET_MAX_INSTANCE;
+
+  object = slab_alloc(&object_pool, device);
   if (!object)
     return BACNET_MAX_INSTANCE;
 
   object->type = OBJECT_CHARACTERSTRING_VALUE;
 
-  memset(object->name, 0, sizeof(object->name));
-  memset(object->description, 0, sizeof(object->description));
-  memset(object->present_value, 0, sizeof(object->present_value));
+  object->name          = string_arena_intern(name, strlen(name));
+  object->description   = string_arena_intern(description, strlen(description));
+  object->present_value = string_arena_intern(value, strlen(value));
 
-  memcpy(object->name, name, strlen(name));
-  memcpy(object->description, description, strlen(description));
-  memcpy(object->present_value, value, strlen(value));
+  bool is_interned =
+       object->name
+    && object->description
+    && object->present_value;
+
+  if (!is_interned) {
+    free_object(device, object);
+    return BACNET_MAX_INSTANCE;
+  }
 
   if (Keylist_Data_Add(device->objects, instance, object) < 0) {
-    free(object);
+    free_object(device, object);
+    return BACNET_MAX_INSTANCE;
+  }
+
+  bool is_indexed =
+    name_index_insert(
+      device_instance,
+      object->name,
+      OBJECT_CHARACTERSTRING_VALUE,
+      instance
+    );
+
+  if (!is_indexed) {
+    Keylist_Data_Delete(device->objects, instance);
+    free_object(device, object);
     return BACNET_MAX_INSTANCE;
   }
 
   return instance;
 }
 
+/**
+ * @brief Deletes a character-string value object and releases its memory.
+ *
+ * @param device - The device owning the object.
+ * @param instance - Object instance number.
+ *
+ * @return false if the device has no character-string value object with that
+ *         instance.
+ */
+bool characterstring_value_delete(
+  DEVICE_OBJECT_DATA* device,
+  uint32_t instance
+) {
+  CHARACTERSTRING_VALUE_OBJECT* object =
+    Keylist_Data(device->objects, instance);
+
+  if (!object || object->type != OBJECT_CHARACTERSTRING_VALUE)
+    return false;
+
+  Keylist_Data_Delete(device->objects, instance);
+  name_index_remove(device->bacObj.Object_Instance_Number, object->name);
+  free_object(device, object);
+
+  return true;
+}
+
 /**
  * @brief Returns the count of character-string value objects for the currently
  *        selected Device.
@@ -149,9 +222,11 @@ characterstring_value_name(uint32_t instance, BACNET_CHARACTER_STRING* name) {
     Keylist_Data(device->objects, instance);
 
   if (object == NULL) return false;
-  if (strlen(object->name) <= 0) return false;
 
-  return characterstring_init_ansi(name, object->name);
+  size_t length = string_arena_length(object->name);
+  if (length == 0) return false;
+
+  return characterstring_init(name, CHARACTER_ANSI_X34, object->name, length);
 }
 
 /**
@@ -164,9 +239,15 @@ bool characterstring_value_description(
   CHARACTERSTRING_VALUE_OBJECT* object,
   BACNET_CHARACTER_STRING* description
 ) {
-  if (strlen(object->description) <= 0) return false;
-
-  return characterstring_init_ansi(description, object->description);
+  size_t length = string_arena_length(object->description);
+  if (length == 0) return false;
+
+  return characterstring_init(
+    description,
+    CHARACTER_ANSI_X34,
+    object->description,
+    length
+  );
 }
 
 /**
@@ -179,9 +260,15 @@ bool characterstring_value_present_value(
   CHARACTERSTRING_VALUE_OBJECT* object,
   BACNET_CHARACTER_STRING* value
 ) {
-  if (strlen(object->present_value) <= 0) return false;
-
-  return characterstring_init_ansi(value, object->present_value);
+  size_t length = string_arena_length(object->present_value);
+  if (length == 0) return false;
+
+  return characterstring_init(
+    value,
+    CHARACTER_ANSI_X34,
+    object->present_value,
+    length
+  );
 }
 
 /**
@@ -304,3 +391,16 @@ void characterstring_value_property_lists(
   if (optional) *optional = optional_properties;
   if (proprietary) *proprietary = proprietary_properties;
 }
+
+/**
+ * @brief Reports the utilization of the character-string value object slabs.
+ *
+ * @param device - The device to report on, or NULL for all of them.
+ * @param[out] stats - Utilization over the device's slabs.
+ */
+void characterstring_value_slab_stats(
+  const DEVICE_OBJECT_DATA* device,
+  slab_stats_t* stats
+) {
+  slab_get_stats(&object_pool, device, stats);
+}
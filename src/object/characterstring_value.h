@@ -2,13 +2,14 @@
 #define BACNET_OBJECT_CHARACTERSTRING_VALUE_H
 
 #include "object/common.h"
+#include "object/slab.h"
 
 typedef struct {
   BACNET_OBJECT_TYPE type;
 
-  char name[MAX_STRING_LEN];
-  char description[MAX_STRING_LEN];
-  char present_value[MAX_STRING_LEN];
+  const char* name;
+  const char* description;
+  const char* present_value;
 } CHARACTERSTRING_VALUE_OBJECT;
 
 void characterstring_value_init(void);
@@ -20,6 +21,10 @@ uint32_t characterstring_value_create(
   char* description,
   char* value);
 
+bool characterstring_value_delete(
+  DEVICE_OBJECT_DATA* device,
+  uint32_t instance);
+
 unsigned characterstring_value_count(void);
 uint32_t characterstring_value_index_to_instance(unsigned index);
 bool characterstring_value_valid_instance(uint32_t instance);
@@ -30,6 +35,10 @@ bool characterstring_value_name(
 
 int characterstring_value_read_property(BACNET_READ_PROPERTY_DATA* data);
 
+void characterstring_value_slab_stats(
+  const DEVICE_OBJECT_DATA* device,
+  slab_stats_t* stats);
+
 void characterstring_value_property_lists(
   const int** required,
   const int** optional,
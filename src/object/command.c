@@ -1,12 +1,27 @@
 #include <stdlib.h>
 #include <bacnet/basic/object/device.h>
+#include <bacnet/basic/object/routed_analog_input.h>
+#include <bacnet/basic/object/routed_multistate_input.h>
 #include <bacnet/basic/object/routed_object.h>
 
+#include "device_index.h"
+#include "memory.h"
+#include "object/binary_input.h"
 #include "object/command.h"
+#include "object/name_index.h"
+#include "object/string_arena.h"
+#include "object/value_table.h"
+#include "log.h"
 #include "protocol/event.h"
+#include "service/deferred_reply.h"
+#include "stats.h"
+#include "timer.h"
 
 static int validate_request(int apdu_len, uint32_t index, uint32_t property);
 static int action_list_encode(uint32_t instance, uint32_t index, uint8_t* apdu);
+static bool execute_actions(COMMAND_OBJECT* object, uint32_t list);
+static void start_deadline(COMMAND_OBJECT* object);
+static void stop_deadline(COMMAND_OBJECT* object);
 
 static const int required_properties[] = {
   PROP_OBJECT_IDENTIFIER,
@@ -26,6 +41,29 @@ static const int optional_properties[] = {
 
 static const int proprietary_properties[] = { -1 };
 
+static slab_pool_t object_pool = SLAB_POOL_INITIALIZER(COMMAND_OBJECT);
+
+// set while an action list runs, whose writes answer no request of their own
+static bool is_executing = false;
+
+static void free_object(DEVICE_OBJECT_DATA* device, COMMAND_OBJECT* object)
+{
+  string_arena_release(object->name);
+  string_arena_release(object->description);
+  timer_cancel(object->timer_id);
+
+  deferred_reply_error(
+    object->reply_id,
+    ERROR_CLASS_OBJECT,
+    ERROR_CODE_UNKNOWN_OBJECT
+  );
+
+  for (int i = 0; i < MAX_COMMAND_ACTIONS; i++)
+    memory_free(MEMORY_OBJECTS, object->actions[i]);
+
+  slab_free(&object_pool, device, object);
+}
+
 /**
  * @brief Attempts to set required, optional and proprietary command properties.
  *
@@ -82,29 +120,87 @@ uint32_t command_create(
   if (object != NULL)
     return instance;
 
-  object = calloc(1, sizeof(COMMAND_OBJECT));
+  uint32_t device_instance = device->bacObj.Object_Instance_Number;
+  bool is_name_available =
+    name_index_is_available(
+      device_instance,
+      name,
+      OBJECT_COMMAND,
+      instance
+    );
+
+  if (!is_name_available)
+    return BACNET_MAX_INSTANCE;
+
+  object = slab_alloc(&object_pool, device);
   if (!object)
     return BACNET_MAX_INSTANCE;
 
-  object->type          = OBJECT_COMMAND;
-  object->present_value = value;
-  object->in_progress   = in_progress;
-  object->successful    = true;
+  object->type            = OBJECT_COMMAND;
+  object->present_value   = value;
+  object->in_progress     = in_progress;
+  object->successful      = true;
+  object->device_instance = device_instance;
+  object->instance        = instance;
+  object->timer_id        = -1;
+  object->reply_id        = -1;
 
-  memset(object->name, 0, sizeof(object->name));
-  memset(object->description, 0, sizeof(object->description));
+  object->name        = string_arena_intern(name, strlen(name));
+  object->description = string_arena_intern(description, strlen(description));
 
-  memcpy(object->name, name, strlen(name));
-  memcpy(object->description, description, strlen(description));
+  if (!object->name || !object->description) {
+    free_object(device, object);
+    return BACNET_MAX_INSTANCE;
+  }
 
   if (Keylist_Data_Add(device->objects, instance, object) < 0) {
-    free(object);
+    free_object(device, object);
+    return BACNET_MAX_INSTANCE;
+  }
+
+  bool is_indexed =
+    name_index_insert(
+      device_instance,
+      object->name,
+      OBJECT_COMMAND,
+      instance
+    );
+
+  if (!is_indexed) {
+    Keylist_Data_Delete(device->objects, instance);
+    free_object(device, object);
     return BACNET_MAX_INSTANCE;
   }
 
+  // a command created in progress has been sent already, at an unknown time
+  if (in_progress)
+    start_deadline(object);
+
   return instance;
 }
 
+/**
+ * @brief Deletes a Command object and releases its memory.
+ *
+ * @param device - The device owning the object.
+ * @param instance - Object instance number.
+ *
+ * @return false if the device has no Command object with that instance.
+ */
+bool command_delete(DEVICE_OBJECT_DATA* device, uint32_t instance)
+{
+  COMMAND_OBJECT* object = Keylist_Data(device->objects, instance);
+
+  if (!object || object->type != OBJECT_COMMAND)
+    return false;
+
+  Keylist_Data_Delete(device->objects, instance);
+  name_index_remove(device->bacObj.Object_Instance_Number, object->name);
+  free_object(device, object);
+
+  return true;
+}
+
 /**
  * @brief Returns the count of Command objects for the currently selected
  *        Device.
@@ -163,9 +259,11 @@ bool command_name(uint32_t instance, BACNET_CHARACTER_STRING* name)
     Keylist_Data(device->objects, instance);
 
   if (object == NULL) return false;
-  if (strlen(object->name) <= 0) return false;
 
-  return characterstring_init_ansi(name, object->name);
+  size_t length = string_arena_length(object->name);
+  if (length == 0) return false;
+
+  return characterstring_init(name, CHARACTER_ANSI_X34, object->name, length);
 }
 
 /**
@@ -182,8 +280,26 @@ bool command_name_set(uint32_t instance, char *name)
   if (!object || strlen(name) >= MAX_OBJ_NAME_LEN)
     return false;
 
-  memset(object->name, 0, sizeof(object->name));
-  strcpy(object->name, name);
+  const char* interned = string_arena_intern(name, strlen(name));
+  if (!interned)
+    return false;
+
+  bool is_renamed =
+    name_index_rename(
+      device->bacObj.Object_Instance_Number,
+      object->name,
+      interned,
+      OBJECT_COMMAND,
+      instance
+    );
+
+  if (!is_renamed) {
+    string_arena_release(interned);
+    return false;
+  }
+
+  string_arena_release(object->name);
+  object->name = interned;
 
   return true;
 }
@@ -198,9 +314,15 @@ bool command_description(
   COMMAND_OBJECT* object,
   BACNET_CHARACTER_STRING* description
 ) {
-  if (strlen(object->description) <= 0) return false;
-
-  return characterstring_init_ansi(description, object->description);
+  size_t length = string_arena_length(object->description);
+  if (length == 0) return false;
+
+  return characterstring_init(
+    description,
+    CHARACTER_ANSI_X34,
+    object->description,
+    length
+  );
 }
 
 /**
@@ -226,10 +348,26 @@ bool command_present_value_set(COMMAND_OBJECT* object, uint32_t value)
  * @param object - The Command Object to update.
  * @param successful - True if the command succeeded.
  *
- * @note Resets in_progress to false.
+ * @note Resets in_progress to false, and answers the write that sent the
+ *       command if its reply was deferred.
  */
 bool command_update_status(COMMAND_OBJECT* object, bool successful)
 {
+  stop_deadline(object);
+
+  if (successful) {
+    deferred_reply_ack(object->reply_id);
+  }
+  else {
+    deferred_reply_error(
+      object->reply_id,
+      ERROR_CLASS_DEVICE,
+      ERROR_CODE_OPERATIONAL_PROBLEM
+    );
+  }
+
+  object->reply_id = -1;
+
   object->in_progress   = false;
   object->present_value = 0;
   object->successful    = successful;
@@ -237,6 +375,45 @@ bool command_update_status(COMMAND_OBJECT* object, bool successful)
   return true;
 }
 
+/**
+ * @brief Replace one of a Command's action lists.
+ *
+ * @param object - The Command Object to update.
+ * @param list - The list's index, so that Action[n] is list n - 1.
+ * @param commands - The commands of the list, copied in order.
+ * @param count - The number of commands, or 0 to empty the list.
+ *
+ * @note A Command with an action list for its present value executes it
+ *       itself instead of sending the command to Elixir.
+ */
+bool command_set_actions(
+  COMMAND_OBJECT* object,
+  uint32_t list,
+  const BACNET_ACTION_LIST* commands,
+  size_t count
+) {
+  if (list >= MAX_COMMAND_ACTIONS)
+    return false;
+
+  BACNET_ACTION_LIST* chain = NULL;
+
+  if (count > 0) {
+    chain = memory_calloc(MEMORY_OBJECTS, count, sizeof(BACNET_ACTION_LIST));
+    if (!chain)
+      return false;
+
+    memcpy(chain, commands, count * sizeof(BACNET_ACTION_LIST));
+
+    for (size_t i = 0; i < count; i++)
+      chain[i].next = i + 1 < count ? &chain[i + 1] : NULL;
+  }
+
+  memory_free(MEMORY_OBJECTS, object->actions[list]);
+  object->actions[list] = chain;
+
+  return true;
+}
+
 /**
  * @brief BACnet read-property handler for a Command Object.
  *
@@ -309,7 +486,7 @@ int command_read_property(BACNET_READ_PROPERTY_DATA* data)
 
       if (apdu_len == BACNET_STATUS_ABORT) {
         data->error_class = ERROR_CLASS_COMMUNICATION;
-        data->error_code  = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+        data->error_code  = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
       }
       else if (apdu_len == BACNET_STATUS_ERROR) {
         data->error_class = ERROR_CLASS_PROPERTY;
@@ -398,7 +575,7 @@ bool command_write_property(BACNET_WRITE_PROPERTY_DATA* data)
         return false;
       }
 
-      if (value.type.Unsigned_Int >= MAX_COMMAND_ACTIONS) {
+      if (value.type.Unsigned_Int > MAX_COMMAND_ACTIONS) {
         data->error_class = ERROR_CLASS_PROPERTY;
         data->error_code  = ERROR_CODE_VALUE_OUT_OF_RANGE;
         return false;
@@ -407,6 +584,19 @@ bool command_write_property(BACNET_WRITE_PROPERTY_DATA* data)
       if (!command_present_value_set(object, value.type.Unsigned_Int))
         return false;
 
+      uint32_t list = value.type.Unsigned_Int - 1;
+
+      bool is_native =
+           value.type.Unsigned_Int > 0
+        && object->actions[list] != NULL;
+
+      if (is_native) {
+        object->successful  = execute_actions(object, list);
+        object->in_progress = false;
+
+        return true;
+      }
+
       int sent_ret =
         send_command(
           device->bacObj.Object_Instance_Number,
@@ -414,7 +604,23 @@ bool command_write_property(BACNET_WRITE_PROPERTY_DATA* data)
           value.type.Unsigned_Int
         );
 
-      return sent_ret == 0;
+      // the client is answered once Elixir sets the command's status,
+      // unless the write comes from another Command's action list
+      if (sent_ret == 0) {
+        object->sent_at_us = stats_now_us();
+        object->reply_id   = is_executing ? -1 : deferred_reply_park();
+        start_deadline(object);
+
+        return true;
+      }
+
+      // nothing will complete the command, so it must not stay busy
+      command_update_status(object, false);
+
+      data->error_class = ERROR_CLASS_DEVICE;
+      data->error_code  = ERROR_CODE_OPERATIONAL_PROBLEM;
+
+      return false;
     default:
       bool is_valid_prop =
         property_lists_member(
@@ -464,5 +670,241 @@ static int action_list_encode(
   if (!object || index >= MAX_COMMAND_ACTIONS)
     return BACNET_STATUS_ERROR;
 
-  return bacnet_action_command_encode(apdu, &object->actions[index]);
+  // a BACnetActionList is its commands within context tag 0
+  int len = encode_opening_tag(apdu, 0);
+
+  for (BACNET_ACTION_LIST* action = object->actions[index];
+       action != NULL;
+       action = action->next) {
+    len += bacnet_action_command_encode(apdu ? &apdu[len] : NULL, action);
+  }
+
+  len += encode_closing_tag(apdu ? &apdu[len] : NULL, 0);
+
+  return len;
+}
+
+static bool value_as_real(BACNET_ACTION_PROPERTY_VALUE* value, float* real)
+{
+  switch (value->tag) {
+    case BACNET_APPLICATION_TAG_REAL:
+      *real = value->type.Real;
+      return true;
+
+    case BACNET_APPLICATION_TAG_DOUBLE:
+      *real = (float)value->type.Double;
+      return true;
+
+    case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+      *real = (float)value->type.Unsigned_Int;
+      return true;
+
+    case BACNET_APPLICATION_TAG_SIGNED_INT:
+      *real = (float)value->type.Signed_Int;
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+static bool value_as_unsigned(
+  BACNET_ACTION_PROPERTY_VALUE* value,
+  uint32_t* number
+) {
+  switch (value->tag) {
+    case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+      *number = value->type.Unsigned_Int;
+      return true;
+
+    case BACNET_APPLICATION_TAG_ENUMERATED:
+      *number = value->type.Enumerated;
+      return true;
+
+    case BACNET_APPLICATION_TAG_BOOLEAN:
+      *number = value->type.Boolean;
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+/*
+ * Present values of the inputs bacnetd serves are set the way the port
+ * calls set them, since inputs aren't writable over BACnet. Anything else
+ * is written as if a WriteProperty request had named it.
+ */
+static bool write_action(
+  DEVICE_OBJECT_DATA* device,
+  uint32_t device_index,
+  BACNET_ACTION_LIST* action
+) {
+  BACNET_OBJECT_TYPE type     = action->Object_Id.type;
+  uint32_t           instance = action->Object_Id.instance;
+
+  void*          data   = Keylist_Data(device->objects, instance);
+  ROUTED_OBJECT* object = data;
+
+  if (!object || object->Type != type)
+    return false;
+
+  float    real   = 0;
+  uint32_t number = 0;
+
+  bool is_present_value =
+       action->Property_Identifier == PROP_PRESENT_VALUE
+    && action->Property_Array_Index == BACNET_ARRAY_ALL;
+
+  if (is_present_value && type == OBJECT_ANALOG_INPUT) {
+    if (!value_as_real(&action->Value, &real))
+      return false;
+
+    if (!value_table_set(device_index, type, instance, real))
+      Routed_Analog_Input_Present_Value_Set(instance, real);
+
+    return true;
+  }
+
+  if (is_present_value && type == OBJECT_MULTI_STATE_INPUT) {
+    return
+         value_as_unsigned(&action->Value, &number)
+      && Routed_Multistate_Input_Present_Value_Set(instance, number);
+  }
+
+  if (is_present_value && type == OBJECT_BINARY_INPUT) {
+    return
+         value_as_unsigned(&action->Value, &number)
+      && binary_input_set_present_value(data, number);
+  }
+
+  BACNET_WRITE_PROPERTY_DATA request = {
+    .object_type     = type,
+    .object_instance = instance,
+    .object_property = action->Property_Identifier,
+    .array_index     = action->Property_Array_Index,
+    .priority        = action->Priority,
+  };
+
+  request.application_data_len =
+    bacnet_action_property_value_encode(
+      request.application_data,
+      &action->Value
+    );
+
+  if (request.application_data_len <= 0)
+    return false;
+
+  return Device_Write_Property(&request);
+}
+
+/*
+ * Runs on the thread handling the WriteProperty request, which holds the
+ * stack lock, so the list is written without anything reading in between.
+ * Post_Delay isn't waited out; the writes follow each other immediately.
+ */
+static bool execute_actions(COMMAND_OBJECT* object, uint32_t list)
+{
+  DEVICE_OBJECT_DATA* owner = Get_Routed_Device_Object(-1);
+  uint32_t owner_instance   = owner->bacObj.Object_Instance_Number;
+  int      owner_index      = device_index_lookup(owner_instance);
+  bool     is_successful    = true;
+  bool     was_executing    = is_executing;
+
+  is_executing = true;
+
+  for (BACNET_ACTION_LIST* action = object->actions[list];
+       action != NULL;
+       action = action->next) {
+    uint32_t device_instance =
+      action->Device_Id.type == OBJECT_DEVICE
+        ? action->Device_Id.instance
+        : owner_instance;
+
+    int device_index = device_index_lookup(device_instance);
+
+    action->Write_Successful =
+         device_index >= 0
+      && write_action(
+           Get_Routed_Device_Object(device_index),
+           (uint32_t)device_index,
+           action
+         );
+
+    Get_Routed_Device_Object(owner_index);
+
+    if (action->Write_Successful)
+      continue;
+
+    is_successful = false;
+
+    if (action->Quit_On_Failure)
+      break;
+  }
+
+  is_executing = was_executing;
+
+  return is_successful;
+}
+
+/*
+ * Fails a command that Elixir never set the status of, so that the Command
+ * accepts writes again. Timers run on the event loop with the stack lock
+ * held, and a deleted Command cancels its timer, so the object is live.
+ */
+static void command_timed_out(void* arg)
+{
+  COMMAND_OBJECT* object = arg;
+
+  LOG_WARNING(
+    "bacnetd: command %u of device %u timed out",
+    object->instance,
+    object->device_instance
+  );
+
+  object->timer_id   = -1;
+  object->sent_at_us = 0;
+
+  stats_record_command_timeout();
+  command_update_status(object, false);
+}
+
+static void start_deadline(COMMAND_OBJECT* object)
+{
+  timer_cancel(object->timer_id);
+
+  object->timer_id =
+    timer_schedule(COMMAND_TIMEOUT_MS, command_timed_out, object);
+
+  if (object->timer_id < 0) {
+    LOG_WARNING(
+      "bacnetd: command %u of device %u has no deadline, no timer is free",
+      object->instance,
+      object->device_instance
+    );
+  }
+}
+
+static void stop_deadline(COMMAND_OBJECT* object)
+{
+  timer_cancel(object->timer_id);
+  object->timer_id = -1;
+
+  if (object->sent_at_us > 0)
+    stats_record_command(stats_now_us() - object->sent_at_us);
+
+  object->sent_at_us = 0;
+}
+
+/**
+ * @brief Reports the utilization of the Command object slabs.
+ *
+ * @param device - The device to report on, or NULL for all of them.
+ * @param[out] stats - Utilization over the device's slabs.
+ */
+void command_slab_stats(
+  const DEVICE_OBJECT_DATA* device,
+  slab_stats_t* stats
+) {
+  slab_get_stats(&object_pool, device, stats);
 }
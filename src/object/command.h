@@ -4,21 +4,39 @@
 #include <bacnet/bacaction.h>
 
 #include "object/common.h"
+#include "object/slab.h"
 
 #ifndef MAX_COMMAND_ACTIONS
 #define MAX_COMMAND_ACTIONS 8
 #endif
 
+// how long a command sent to Elixir may wait for its status before failing
+#ifndef COMMAND_TIMEOUT_MS
+#define COMMAND_TIMEOUT_MS 30000
+#endif
+
 typedef struct {
   BACNET_OBJECT_TYPE type;
 
-  uint32_t present_value;
-  bool     in_progress;
-  bool     successful;
-  char     name[MAX_STRING_LEN];
-  char     description[MAX_STRING_LEN];
+  uint32_t    present_value;
+  bool        in_progress;
+  bool        successful;
+  const char* name;
+  const char* description;
+
+  // identifies the command in logs once its deadline passes
+  uint32_t device_instance;
+  uint32_t instance;
+
+  // the deadline timer, or -1, and when the command was sent, or 0
+  int      timer_id;
+  uint64_t sent_at_us;
+
+  // the deferred reply to the write that sent the command, or -1
+  int reply_id;
 
-  BACNET_ACTION_LIST actions[MAX_COMMAND_ACTIONS];
+  // Action[n] is actions[n - 1], a chain of commands or NULL when empty
+  BACNET_ACTION_LIST* actions[MAX_COMMAND_ACTIONS];
 } COMMAND_OBJECT;
 
 void command_init(void);
@@ -31,7 +49,16 @@ uint32_t command_create(
   uint32_t value,
   bool in_progress);
 
+bool command_delete(DEVICE_OBJECT_DATA* device, uint32_t instance);
+
 bool command_update_status(COMMAND_OBJECT* object, bool successful);
+
+bool command_set_actions(
+  COMMAND_OBJECT* object,
+  uint32_t list,
+  const BACNET_ACTION_LIST* commands,
+  size_t count);
+
 unsigned command_count(void);
 uint32_t command_index_to_instance(unsigned index);
 bool command_valid_instance(uint32_t instance);
@@ -40,6 +67,10 @@ bool command_name_set(uint32_t instance, char* name);
 int command_read_property(BACNET_READ_PROPERTY_DATA* data);
 bool command_write_property(BACNET_WRITE_PROPERTY_DATA* data);
 
+void command_slab_stats(
+  const DEVICE_OBJECT_DATA* device,
+  slab_stats_t* stats);
+
 void command_property_lists(
   const int** required,
   const int** optional,
@@ -0,0 +1,356 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+#include "object/name_index.h"
+#include "object/string_arena.h"
+
+#define INITIAL_CAPACITY 64
+
+typedef struct {
+  uint32_t           hash;
+  uint32_t           device_instance;
+  BACNET_OBJECT_TYPE type;
+  uint32_t           instance;
+  const char*        name;
+} name_entry_t;
+
+// marks a removed entry, so that probing continues past it
+static char tombstone[] = "";
+
+static name_entry_t*   entries = NULL;
+static size_t          capacity = 0;
+static size_t          used = 0;
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static name_entry_t* find_entry(uint32_t device_instance, const char* name);
+static bool insert_entry(
+  uint32_t device_instance,
+  const char* name,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance);
+static void remove_entry(name_entry_t* entry);
+static bool resize(size_t new_capacity);
+
+/**
+ * @brief Adds an object name to a device's name index.
+ *
+ * @param device_instance - Instance number of the Device owning the object.
+ * @param name - The object's name.
+ * @param type - The object's type.
+ * @param instance - The object's instance number.
+ *
+ * @return false if the name belongs to another object of the Device, or if
+ *         the index could not grow.
+ */
+bool name_index_insert(
+  uint32_t device_instance,
+  const char* name,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance
+) {
+  pthread_mutex_lock(&index_lock);
+  bool result = insert_entry(device_instance, name, type, instance);
+  pthread_mutex_unlock(&index_lock);
+
+  return result;
+}
+
+/**
+ * @brief Grows the index ahead of a bulk insert, so it is resized once.
+ *
+ * @param count - The number of names about to be inserted.
+ *
+ * @return false if the index could not grow.
+ */
+bool name_index_reserve(size_t count)
+{
+  pthread_mutex_lock(&index_lock);
+
+  size_t new_capacity = capacity ? capacity : INITIAL_CAPACITY;
+  while ((used + count) * 4 > new_capacity * 3)
+    new_capacity *= 2;
+
+  bool result = new_capacity == capacity || resize(new_capacity);
+
+  pthread_mutex_unlock(&index_lock);
+
+  return result;
+}
+
+/**
+ * @brief Moves an object to a new name in a device's name index.
+ *
+ * @param device_instance - Instance number of the Device owning the object.
+ * @param old_name - The object's current name.
+ * @param new_name - The object's new name.
+ * @param type - The object's type.
+ * @param instance - The object's instance number.
+ *
+ * @return false if the new name belongs to another object of the Device.
+ */
+bool name_index_rename(
+  uint32_t device_instance,
+  const char* old_name,
+  const char* new_name,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance
+) {
+  pthread_mutex_lock(&index_lock);
+
+  bool result = false;
+
+  name_entry_t* conflict = find_entry(device_instance, new_name);
+  bool is_taken =
+       conflict != NULL
+    && (conflict->type != type || conflict->instance != instance);
+
+  if (is_taken)
+    goto unlock;
+
+  name_entry_t* entry = find_entry(device_instance, old_name);
+  if (entry && entry->type == type && entry->instance == instance)
+    remove_entry(entry);
+
+  result = insert_entry(device_instance, new_name, type, instance);
+
+unlock:
+  pthread_mutex_unlock(&index_lock);
+  return result;
+}
+
+/**
+ * @brief Removes an object name from a device's name index.
+ *
+ * @param device_instance - Instance number of the Device owning the object.
+ * @param name - The object's name.
+ *
+ * @return true if the name was indexed.
+ */
+bool name_index_remove(uint32_t device_instance, const char* name)
+{
+  pthread_mutex_lock(&index_lock);
+
+  name_entry_t* entry = find_entry(device_instance, name);
+  if (entry)
+    remove_entry(entry);
+
+  pthread_mutex_unlock(&index_lock);
+
+  return entry != NULL;
+}
+
+/**
+ * @brief Removes every name of a device from the name index.
+ *
+ * @param device_instance - Instance number of the Device.
+ *
+ * @return Returns the number of names removed.
+ */
+size_t name_index_remove_device(uint32_t device_instance)
+{
+  size_t removed = 0;
+
+  pthread_mutex_lock(&index_lock);
+
+  for (size_t i = 0; i < capacity; i++) {
+    name_entry_t* entry = &entries[i];
+
+    bool is_match =
+         entry->name != NULL
+      && entry->name != tombstone
+      && entry->device_instance == device_instance;
+
+    if (is_match) {
+      remove_entry(entry);
+      removed++;
+    }
+  }
+
+  pthread_mutex_unlock(&index_lock);
+
+  return removed;
+}
+
+/**
+ * @brief Finds the object with a given name on a device.
+ *
+ * @param device_instance - Instance number of the Device owning the object.
+ * @param name - The object name to look up.
+ * @param type - Where the object's type is stored, if found.
+ * @param instance - Where the object's instance number is stored, if found.
+ *
+ * @return true if an object with the name exists on the Device.
+ */
+bool name_index_lookup(
+  uint32_t device_instance,
+  const char* name,
+  BACNET_OBJECT_TYPE* type,
+  uint32_t* instance
+) {
+  pthread_mutex_lock(&index_lock);
+
+  name_entry_t* entry = find_entry(device_instance, name);
+  if (entry) {
+    if (type) *type = entry->type;
+    if (instance) *instance = entry->instance;
+  }
+
+  pthread_mutex_unlock(&index_lock);
+
+  return entry != NULL;
+}
+
+/**
+ * @brief Checks if an object may use a name on a device.
+ *
+ * @param device_instance - Instance number of the Device owning the object.
+ * @param name - The object name to check.
+ * @param type - The object's type.
+ * @param instance - The object's instance number.
+ *
+ * @return true if the name is unused, or already belongs to the object.
+ */
+bool name_index_is_available(
+  uint32_t device_instance,
+  const char* name,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance
+) {
+  BACNET_OBJECT_TYPE owner_type     = MAX_BACNET_OBJECT_TYPE;
+  uint32_t           owner_instance = 0;
+
+  if (!name_index_lookup(device_instance, name, &owner_type, &owner_instance))
+    return true;
+
+  return owner_type == type && owner_instance == instance;
+}
+
+static uint32_t hash_key(uint32_t device_instance, const char* name)
+{
+  // FNV-1a over the device instance and the name
+  uint32_t hash = 2166136261u;
+
+  for (int i = 0; i < 4; i++) {
+    hash ^= (device_instance >> (i * 8)) & 0xFF;
+    hash *= 16777619u;
+  }
+
+  for (const char* c = name; *c; c++) {
+    hash ^= (uint8_t)*c;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static name_entry_t* find_entry(uint32_t device_instance, const char* name)
+{
+  if (capacity == 0)
+    return NULL;
+
+  uint32_t hash = hash_key(device_instance, name);
+
+  for (size_t i = 0; i < capacity; i++) {
+    name_entry_t* entry = &entries[(hash + i) & (capacity - 1)];
+
+    if (entry->name == NULL)
+      return NULL;
+
+    bool is_match =
+         entry->name != tombstone
+      && entry->hash == hash
+      && entry->device_instance == device_instance
+      && strcmp(entry->name, name) == 0;
+
+    if (is_match)
+      return entry;
+  }
+
+  return NULL;
+}
+
+static name_entry_t* free_slot(uint32_t hash)
+{
+  for (size_t i = 0; i < capacity; i++) {
+    name_entry_t* entry = &entries[(hash + i) & (capacity - 1)];
+
+    if (entry->name == NULL || entry->name == tombstone)
+      return entry;
+  }
+
+  return NULL;
+}
+
+static bool resize(size_t new_capacity)
+{
+  name_entry_t* old_entries  = entries;
+  size_t        old_capacity = capacity;
+
+  name_entry_t* new_entries =
+    memory_calloc(MEMORY_NAME_INDEX, new_capacity, sizeof(name_entry_t));
+  if (!new_entries)
+    return false;
+
+  entries  = new_entries;
+  capacity = new_capacity;
+  used     = 0;
+
+  for (size_t i = 0; i < old_capacity; i++) {
+    name_entry_t* entry = &old_entries[i];
+
+    if (entry->name == NULL || entry->name == tombstone)
+      continue;
+
+    memcpy(free_slot(entry->hash), entry, sizeof(*entry));
+    used++;
+  }
+
+  memory_free(MEMORY_NAME_INDEX, old_entries);
+
+  return true;
+}
+
+static bool insert_entry(
+  uint32_t device_instance,
+  const char* name,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance
+) {
+  name_entry_t* entry = find_entry(device_instance, name);
+  if (entry)
+    return entry->type == type && entry->instance == instance;
+
+  // keep the load factor, including removed entries, under 3/4
+  if ((used + 1) * 4 > capacity * 3) {
+    size_t new_capacity = capacity ? capacity * 2 : INITIAL_CAPACITY;
+    if (!resize(new_capacity))
+      return false;
+  }
+
+  // the object holding the name usually interned it already
+  const char* copy = string_arena_intern(name, strlen(name));
+  if (!copy)
+    return false;
+
+  uint32_t hash = hash_key(device_instance, name);
+
+  entry = free_slot(hash);
+  if (entry->name == NULL)
+    used++;
+
+  entry->hash            = hash;
+  entry->device_instance = device_instance;
+  entry->type            = type;
+  entry->instance        = instance;
+  entry->name            = copy;
+
+  return true;
+}
+
+static void remove_entry(name_entry_t* entry)
+{
+  string_arena_release(entry->name);
+  entry->name = tombstone;
+}
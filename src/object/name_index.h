@@ -0,0 +1,39 @@
+#ifndef BACNET_OBJECT_NAME_INDEX_H
+#define BACNET_OBJECT_NAME_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <bacnet/bacenum.h>
+
+bool name_index_insert(
+  uint32_t device_instance,
+  const char* name,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance);
+
+bool name_index_reserve(size_t count);
+
+bool name_index_rename(
+  uint32_t device_instance,
+  const char* old_name,
+  const char* new_name,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance);
+
+bool name_index_remove(uint32_t device_instance, const char* name);
+size_t name_index_remove_device(uint32_t device_instance);
+
+bool name_index_lookup(
+  uint32_t device_instance,
+  const char* name,
+  BACNET_OBJECT_TYPE* type,
+  uint32_t* instance);
+
+bool name_index_is_available(
+  uint32_t device_instance,
+  const char* name,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance);
+
+#endif /* BACNET_OBJECT_NAME_INDEX_H */
@@ -0,0 +1,198 @@
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+#include "object/slab.h"
+
+#define INITIAL_CHUNK_CAPACITY 8
+
+static slab_t* find_slab(slab_pool_t* pool, const void* owner, bool is_new);
+static bool grow(slab_pool_t* pool, slab_t* slab);
+static void release(slab_t* slab);
+
+static size_t slot_size(slab_pool_t* pool)
+{
+  size_t alignment = alignof(max_align_t);
+
+  return (pool->object_size + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t chunk_objects(slab_pool_t* pool)
+{
+  size_t count = SLAB_CHUNK_BYTES / slot_size(pool);
+
+  return count ? count : 1;
+}
+
+static size_t chunk_size(slab_pool_t* pool)
+{
+  size_t size = slot_size(pool) * chunk_objects(pool);
+
+  return (size + SLAB_ALIGNMENT - 1) & ~((size_t)SLAB_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Allocates a zeroed object from the owner's slab.
+ *
+ * @param pool - The pool of the object's type.
+ * @param owner - The device the object belongs to.
+ *
+ * @return Returns the object, or NULL if a chunk could not be allocated or
+ *         the pool has no slab left for a new owner.
+ */
+void* slab_alloc(slab_pool_t* pool, const void* owner)
+{
+  void* object = NULL;
+
+  pthread_mutex_lock(&pool->lock);
+
+  slab_t* slab = find_slab(pool, owner, true);
+  if (!slab)
+    goto unlock;
+
+  if (slab->free_slots) {
+    object           = slab->free_slots;
+    slab->free_slots = *(void**)object;
+  } else {
+    if (slab->unused == 0 && !grow(pool, slab))
+      goto unlock;
+
+    char*  chunk = slab->chunks[slab->chunk_count - 1];
+    size_t slot  = chunk_objects(pool) - slab->unused;
+
+    object = chunk + slot * slot_size(pool);
+    slab->unused--;
+  }
+
+  slab->in_use++;
+  memset(object, 0, pool->object_size);
+
+unlock:
+  pthread_mutex_unlock(&pool->lock);
+
+  return object;
+}
+
+/**
+ * @brief Returns an object's slot to the owner's slab.
+ *
+ * The slot is handed out again by the next allocation for the owner. Once
+ * all of an owner's objects are freed, its chunks are released.
+ *
+ * @param pool - The pool the object was allocated from.
+ * @param owner - The device the object belongs to.
+ * @param object - The object, or NULL.
+ */
+void slab_free(slab_pool_t* pool, const void* owner, void* object)
+{
+  if (object == NULL)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+
+  slab_t* slab = find_slab(pool, owner, false);
+  if (slab) {
+    *(void**)object  = slab->free_slots;
+    slab->free_slots = object;
+
+    if (--slab->in_use == 0)
+      release(slab);
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Reports the utilization of a pool, for one or all of its owners.
+ *
+ * @param pool - The pool to report on.
+ * @param owner - The device to report on, or NULL for all of them.
+ * @param[out] stats - The chunk count, the slots in the chunks, the slots
+ *                     in use, and the bytes held by the chunks.
+ */
+void slab_get_stats(
+  slab_pool_t* pool,
+  const void* owner,
+  slab_stats_t* stats
+) {
+  memset(stats, 0, sizeof(*stats));
+
+  pthread_mutex_lock(&pool->lock);
+
+  for (size_t i = 0; i < SLAB_POOL_OWNERS; i++) {
+    slab_t* slab = &pool->slabs[i];
+
+    bool is_skipped =
+         slab->owner == NULL
+      || (owner != NULL && slab->owner != owner);
+
+    if (is_skipped)
+      continue;
+
+    stats->chunks   += slab->chunk_count;
+    stats->capacity += slab->chunk_count * chunk_objects(pool);
+    stats->in_use   += slab->in_use;
+    stats->bytes    +=
+        slab->chunk_count * chunk_size(pool)
+      + slab->chunk_capacity * sizeof(void*);
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static slab_t* find_slab(slab_pool_t* pool, const void* owner, bool is_new)
+{
+  slab_t* vacant = NULL;
+
+  for (size_t i = 0; i < SLAB_POOL_OWNERS; i++) {
+    slab_t* slab = &pool->slabs[i];
+
+    if (slab->owner == owner)
+      return slab;
+
+    if (slab->owner == NULL && vacant == NULL)
+      vacant = slab;
+  }
+
+  if (is_new && vacant)
+    vacant->owner = owner;
+
+  return is_new ? vacant : NULL;
+}
+
+static bool grow(slab_pool_t* pool, slab_t* slab)
+{
+  if (slab->chunk_count == slab->chunk_capacity) {
+    size_t capacity =
+      slab->chunk_capacity ? slab->chunk_capacity * 2 : INITIAL_CHUNK_CAPACITY;
+
+    void** chunks =
+      memory_realloc(MEMORY_OBJECTS, slab->chunks, capacity * sizeof(void*));
+    if (!chunks)
+      return false;
+
+    slab->chunks         = chunks;
+    slab->chunk_capacity = capacity;
+  }
+
+  void* chunk =
+    memory_aligned_alloc(MEMORY_OBJECTS, SLAB_ALIGNMENT, chunk_size(pool));
+  if (!chunk)
+    return false;
+
+  slab->chunks[slab->chunk_count++] = chunk;
+  slab->unused = chunk_objects(pool);
+
+  return true;
+}
+
+static void release(slab_t* slab)
+{
+  for (size_t i = 0; i < slab->chunk_count; i++)
+    memory_free(MEMORY_OBJECTS, slab->chunks[i]);
+
+  memory_free(MEMORY_OBJECTS, slab->chunks);
+  memset(slab, 0, sizeof(*slab));
+}
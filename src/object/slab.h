@@ -0,0 +1,61 @@
+#ifndef BACNET_OBJECT_SLAB_H
+#define BACNET_OBJECT_SLAB_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <bacnet/basic/object/device.h>
+
+// chunks hold as many objects as fit, and at least one
+#ifndef SLAB_CHUNK_BYTES
+#define SLAB_CHUNK_BYTES 16384
+#endif
+
+#ifndef SLAB_ALIGNMENT
+#define SLAB_ALIGNMENT 64
+#endif
+
+#ifndef SLAB_POOL_OWNERS
+#define SLAB_POOL_OWNERS MAX_NUM_DEVICES
+#endif
+
+/*
+ * Object structs of one type are carved out of cache-aligned chunks, with a
+ * separate slab per owning device, so that a device's objects of a type sit
+ * next to each other. Freed slots are reused by the next allocation for the
+ * same device.
+ */
+
+typedef struct {
+  const void* owner;
+  void**      chunks;
+  size_t      chunk_count;
+  size_t      chunk_capacity;
+  size_t      unused;
+  void*       free_slots;
+  size_t      in_use;
+} slab_t;
+
+typedef struct {
+  size_t          object_size;
+  pthread_mutex_t lock;
+  slab_t          slabs[SLAB_POOL_OWNERS];
+} slab_pool_t;
+
+typedef struct {
+  size_t chunks;
+  size_t capacity;
+  size_t in_use;
+  size_t bytes;
+} slab_stats_t;
+
+#define SLAB_POOL_INITIALIZER(type) \
+  { .object_size = sizeof(type), .lock = PTHREAD_MUTEX_INITIALIZER }
+
+void* slab_alloc(slab_pool_t* pool, const void* owner);
+void slab_free(slab_pool_t* pool, const void* owner, void* object);
+void slab_get_stats(
+  slab_pool_t* pool,
+  const void* owner,
+  slab_stats_t* stats);
+
+#endif /* BACNET_OBJECT_SLAB_H */
@@ -0,0 +1,256 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+#include "object/string_arena.h"
+
+#define INITIAL_CAPACITY 256
+
+/*
+ * Object strings are interned in the gateway's string arena, so a text such
+ * as a shared description or a multistate state list is stored once however
+ * many objects use it. Each entry is reference counted, and its length sits
+ * in front of the text, which is NUL terminated.
+ */
+
+typedef struct {
+  uint32_t hash;
+  uint32_t references;
+  uint32_t length;
+  char     text[];
+} string_entry_t;
+
+// marks a removed entry, so that probing continues past it
+static string_entry_t tombstone;
+
+static string_entry_t** entries = NULL;
+static size_t           capacity = 0;
+static size_t           used = 0;
+static size_t           entry_count = 0;
+static size_t           reference_count = 0;
+static size_t           entry_bytes = 0;
+static pthread_mutex_t  arena_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hash_text(const char* text, size_t length);
+static string_entry_t** find_slot(
+  const char* text,
+  size_t length,
+  uint32_t hash);
+static bool resize(size_t new_capacity);
+
+static string_entry_t* entry_of(const char* text)
+{
+  return (string_entry_t*)(text - offsetof(string_entry_t, text));
+}
+
+/**
+ * @brief Interns a string, adding a reference to it.
+ *
+ * The text does not have to be NUL terminated, and may hold NUL bytes, as
+ * multistate state lists do.
+ *
+ * @param text - The string to intern.
+ * @param length - The length of the string, in bytes.
+ *
+ * @return Returns the interned copy, to be released with
+ *         string_arena_release, or NULL if it could not be allocated.
+ */
+const char* string_arena_intern(const char* text, size_t length)
+{
+  if (length > UINT32_MAX)
+    return NULL;
+
+  uint32_t        hash  = hash_text(text, length);
+  string_entry_t* entry = NULL;
+
+  pthread_mutex_lock(&arena_lock);
+
+  string_entry_t** slot = find_slot(text, length, hash);
+  if (slot && *slot) {
+    entry = *slot;
+    goto reference;
+  }
+
+  // keep the load factor, including removed entries, under 3/4
+  if ((used + 1) * 4 > capacity * 3) {
+    size_t new_capacity = capacity ? capacity * 2 : INITIAL_CAPACITY;
+    if (!resize(new_capacity))
+      goto unlock;
+  }
+
+  entry =
+    memory_malloc(MEMORY_STRINGS, sizeof(string_entry_t) + length + 1);
+  if (!entry)
+    goto unlock;
+
+  entry->hash       = hash;
+  entry->references = 0;
+  entry->length     = (uint32_t)length;
+
+  memcpy(entry->text, text, length);
+  entry->text[length] = '\0';
+
+  for (size_t i = 0; i < capacity; i++) {
+    slot = &entries[(hash + i) & (capacity - 1)];
+
+    if (*slot == NULL || *slot == &tombstone)
+      break;
+  }
+
+  if (*slot == NULL)
+    used++;
+
+  *slot = entry;
+  entry_count++;
+  entry_bytes += sizeof(string_entry_t) + length + 1;
+
+reference:
+  entry->references++;
+  reference_count++;
+
+unlock:
+  pthread_mutex_unlock(&arena_lock);
+
+  return entry ? entry->text : NULL;
+}
+
+/**
+ * @brief Drops a reference to an interned string, freeing it with the last.
+ *
+ * @param text - A string returned by string_arena_intern, or NULL.
+ */
+void string_arena_release(const char* text)
+{
+  if (text == NULL)
+    return;
+
+  string_entry_t* entry = entry_of(text);
+
+  pthread_mutex_lock(&arena_lock);
+
+  reference_count--;
+
+  if (--entry->references > 0)
+    goto unlock;
+
+  for (size_t i = 0; i < capacity; i++) {
+    string_entry_t** slot = &entries[(entry->hash + i) & (capacity - 1)];
+
+    if (*slot == entry) {
+      *slot = &tombstone;
+      break;
+    }
+  }
+
+  entry_count--;
+  entry_bytes -= sizeof(string_entry_t) + entry->length + 1;
+  memory_free(MEMORY_STRINGS, entry);
+
+unlock:
+  pthread_mutex_unlock(&arena_lock);
+}
+
+/**
+ * @brief Returns the length of an interned string, without scanning it.
+ *
+ * @param text - A string returned by string_arena_intern.
+ */
+size_t string_arena_length(const char* text)
+{
+  return entry_of(text)->length;
+}
+
+/**
+ * @brief Reports how many strings are interned and the memory they use.
+ *
+ * @param[out] stats - The entry and reference counts, and the bytes held by
+ *                     the entries and the table.
+ */
+void string_arena_get_stats(string_arena_stats_t* stats)
+{
+  pthread_mutex_lock(&arena_lock);
+
+  stats->entries    = entry_count;
+  stats->references = reference_count;
+  stats->bytes      = entry_bytes + capacity * sizeof(string_entry_t*);
+
+  pthread_mutex_unlock(&arena_lock);
+}
+
+static uint32_t hash_text(const char* text, size_t length)
+{
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)text[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+// returns the slot holding the text, or the empty slot ending its probe
+static string_entry_t** find_slot(
+  const char* text,
+  size_t length,
+  uint32_t hash
+) {
+  for (size_t i = 0; i < capacity; i++) {
+    string_entry_t** slot = &entries[(hash + i) & (capacity - 1)];
+    string_entry_t*  entry = *slot;
+
+    if (entry == NULL)
+      return slot;
+
+    bool is_match =
+         entry != &tombstone
+      && entry->hash == hash
+      && entry->length == length
+      && memcmp(entry->text, text, length) == 0;
+
+    if (is_match)
+      return slot;
+  }
+
+  return NULL;
+}
+
+static bool resize(size_t new_capacity)
+{
+  string_entry_t** old_entries  = entries;
+  size_t           old_capacity = capacity;
+
+  string_entry_t** new_entries =
+    memory_calloc(MEMORY_STRINGS, new_capacity, sizeof(string_entry_t*));
+  if (!new_entries)
+    return false;
+
+  entries  = new_entries;
+  capacity = new_capacity;
+  used     = 0;
+
+  for (size_t i = 0; i < old_capacity; i++) {
+    string_entry_t* entry = old_entries[i];
+
+    if (entry == NULL || entry == &tombstone)
+      continue;
+
+    for (size_t j = 0; j < capacity; j++) {
+      string_entry_t** slot = &entries[(entry->hash + j) & (capacity - 1)];
+
+      if (*slot == NULL) {
+        *slot = entry;
+        break;
+      }
+    }
+
+    used++;
+  }
+
+  memory_free(MEMORY_STRINGS, old_entries);
+
+  return true;
+}
@@ -0,0 +1,18 @@
+#ifndef BACNET_OBJECT_STRING_ARENA_H
+#define BACNET_OBJECT_STRING_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  size_t entries;
+  size_t references;
+  size_t bytes;
+} string_arena_stats_t;
+
+const char* string_arena_intern(const char* text, size_t length);
+void string_arena_release(const char* text);
+size_t string_arena_length(const char* text);
+void string_arena_get_stats(string_arena_stats_t* stats);
+
+#endif /* BACNET_OBJECT_STRING_ARENA_H */
@@ -0,0 +1,510 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <bacnet/basic/object/device.h>
+#include <bacnet/basic/object/routed_analog_input.h>
+
+#include "memory.h"
+#include "object/value_table.h"
+
+// a multiple of 64, so that every changed word covers whole columns
+#define INITIAL_CAPACITY 64
+#define COLUMN_ALIGNMENT 64
+
+/*
+ * The fields read on every change-of-value check are kept per device and
+ * object type as struct-of-arrays columns, so that a scan reads contiguous
+ * floats instead of chasing object pointers. The stack's object is still
+ * updated alongside, as it answers ReadProperty, and is marked changed for
+ * COV reporting when its value leaves the deadband.
+ *
+ * The columns are padded with zeroed points up to the capacity, which never
+ * count as changed.
+ */
+
+typedef float   v4f __attribute__((vector_size(16)));
+typedef int32_t v4i __attribute__((vector_size(16)));
+
+typedef enum {
+  TABLE_ANALOG_INPUT,
+  TABLE_KIND_COUNT,
+} table_kind_t;
+
+typedef struct {
+  uint32_t  count;
+  uint32_t  capacity;
+  uint32_t* instances;
+  float*    values;
+  float*    reported;
+  float*    increments;
+  uint64_t* changed;
+  void**    objects;
+
+  // instance hash, holding slot + 1, or 0 when empty
+  uint32_t* slots;
+  uint32_t  slot_mask;
+} value_table_t;
+
+static value_table_t   tables[MAX_NUM_DEVICES][TABLE_KIND_COUNT];
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static value_table_t* find_table(
+  uint32_t device_index,
+  BACNET_OBJECT_TYPE type);
+static int find_slot(value_table_t* table, uint32_t instance);
+static uint32_t find_hash(value_table_t* table, uint32_t instance);
+static void unlink_hash(value_table_t* table, uint32_t position);
+static bool grow(value_table_t* table);
+static size_t mark_changed(value_table_t* table);
+
+/**
+ * @brief Adds an object to its device's value table.
+ *
+ * The current present value is taken as the last reported one. Adding an
+ * object that is already in the table refreshes it.
+ *
+ * @param device_index - The routed device table index of the owning device.
+ * @param type - The object's type.
+ * @param instance - The object's instance number.
+ * @param object - The stack's object.
+ *
+ * @return false if the type has no value table, or the table could not grow.
+ */
+bool value_table_add(
+  uint32_t device_index,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance,
+  void* object
+) {
+  bool result = false;
+
+  pthread_mutex_lock(&tables_lock);
+
+  value_table_t* table = find_table(device_index, type);
+  if (!table)
+    goto unlock;
+
+  int slot = find_slot(table, instance);
+
+  if (slot < 0) {
+    if (table->count == table->capacity && !grow(table))
+      goto unlock;
+
+    slot = (int)table->count++;
+
+    uint32_t i = instance * 2654435761u;
+    while (table->slots[i & table->slot_mask] != 0)
+      i++;
+
+    table->slots[i & table->slot_mask] = (uint32_t)slot + 1;
+  }
+
+  ROUTED_ANALOG_INPUT_OBJECT* analog_input = object;
+
+  table->instances[slot]  = instance;
+  table->values[slot]     = analog_input->Present_Value;
+  table->reported[slot]   = analog_input->Present_Value;
+  table->increments[slot] = analog_input->COV_Increment;
+  table->objects[slot]    = object;
+
+  result = true;
+
+unlock:
+  pthread_mutex_unlock(&tables_lock);
+  return result;
+}
+
+/**
+ * @brief Updates the present value of an object in a value table.
+ *
+ * The stack's object is written too, without selecting its device.
+ *
+ * @param device_index - The routed device table index of the owning device.
+ * @param type - The object's type.
+ * @param instance - The object's instance number.
+ * @param value - The new present value.
+ *
+ * @return false if the object is not in a value table.
+ */
+bool value_table_set(
+  uint32_t device_index,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance,
+  float value
+) {
+  pthread_mutex_lock(&tables_lock);
+
+  value_table_t* table = find_table(device_index, type);
+  int            slot  = table ? find_slot(table, instance) : -1;
+
+  if (slot >= 0) {
+    ROUTED_ANALOG_INPUT_OBJECT* object = table->objects[slot];
+
+    table->values[slot]   = value;
+    object->Present_Value = value;
+  }
+
+  pthread_mutex_unlock(&tables_lock);
+
+  return slot >= 0;
+}
+
+/**
+ * @brief Removes an object from its device's value table.
+ *
+ * The last object in the table is moved into the freed slot, so that the
+ * columns stay dense, and the slot it leaves is zeroed as padding.
+ *
+ * @param device_index - The routed device table index of the owning device.
+ * @param type - The object's type.
+ * @param instance - The object's instance number.
+ *
+ * @return false if the object is not in a value table.
+ */
+bool value_table_remove(
+  uint32_t device_index,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance
+) {
+  pthread_mutex_lock(&tables_lock);
+
+  value_table_t* table = find_table(device_index, type);
+  int            slot  = table ? find_slot(table, instance) : -1;
+
+  if (slot >= 0) {
+    uint32_t last = table->count - 1;
+
+    unlink_hash(table, find_hash(table, instance));
+
+    if ((uint32_t)slot != last) {
+      uint32_t moved    = table->instances[last];
+      uint64_t last_bit = 1ULL << (last % 64);
+      uint64_t slot_bit = 1ULL << (slot % 64);
+
+      table->slots[find_hash(table, moved)] = (uint32_t)slot + 1;
+
+      table->instances[slot]  = moved;
+      table->values[slot]     = table->values[last];
+      table->reported[slot]   = table->reported[last];
+      table->increments[slot] = table->increments[last];
+      table->objects[slot]    = table->objects[last];
+
+      table->changed[slot / 64] &= ~slot_bit;
+      if (table->changed[last / 64] & last_bit)
+        table->changed[slot / 64] |= slot_bit;
+    }
+
+    table->instances[last]  = 0;
+    table->values[last]     = 0;
+    table->reported[last]   = 0;
+    table->increments[last] = 0;
+    table->objects[last]    = NULL;
+    table->changed[last / 64] &= ~(1ULL << (last % 64));
+    table->count--;
+  }
+
+  pthread_mutex_unlock(&tables_lock);
+
+  return slot >= 0;
+}
+
+/**
+ * @brief Removes every object of a device from the value tables.
+ *
+ * The tables' memory is released, as the device's slot may be reused for a
+ * device with a different set of objects.
+ *
+ * @param device_index - The routed device table index of the device.
+ */
+void value_table_remove_device(uint32_t device_index)
+{
+  if (device_index >= MAX_NUM_DEVICES)
+    return;
+
+  pthread_mutex_lock(&tables_lock);
+
+  for (size_t k = 0; k < TABLE_KIND_COUNT; k++) {
+    value_table_t* table = &tables[device_index][k];
+
+    memory_free(MEMORY_VALUE_TABLE, table->instances);
+    memory_free(MEMORY_VALUE_TABLE, table->values);
+    memory_free(MEMORY_VALUE_TABLE, table->reported);
+    memory_free(MEMORY_VALUE_TABLE, table->increments);
+    memory_free(MEMORY_VALUE_TABLE, table->changed);
+    memory_free(MEMORY_VALUE_TABLE, table->objects);
+    memory_free(MEMORY_VALUE_TABLE, table->slots);
+
+    memset(table, 0, sizeof(*table));
+  }
+
+  pthread_mutex_unlock(&tables_lock);
+}
+
+/**
+ * @brief Marks every object whose present value left its COV deadband.
+ *
+ * A value has left the deadband when it differs from the last reported one
+ * by at least the COV increment. The stack's object is then flagged as
+ * changed, and the value becomes the last reported one.
+ *
+ * @return Returns the number of objects marked as changed.
+ */
+size_t value_table_scan(void)
+{
+  size_t changed = 0;
+
+  pthread_mutex_lock(&tables_lock);
+
+  for (size_t d = 0; d < MAX_NUM_DEVICES; d++) {
+    for (size_t k = 0; k < TABLE_KIND_COUNT; k++) {
+      value_table_t* table = &tables[d][k];
+
+      if (table->count == 0)
+        continue;
+
+      value_table_deadband(
+        table->values,
+        table->reported,
+        table->increments,
+        table->changed,
+        table->capacity
+      );
+
+      changed += mark_changed(table);
+    }
+  }
+
+  pthread_mutex_unlock(&tables_lock);
+
+  return changed;
+}
+
+/**
+ * @brief Sets a bit for every value that left its deadband.
+ *
+ * Four values are compared at a time with vector instructions. A value has
+ * left the deadband when its distance from the reported value is non-zero
+ * and at least the increment, so an increment of zero reports any change.
+ *
+ * @param values - The present values.
+ * @param reported - The last reported values.
+ * @param increments - The COV increments.
+ * @param[in,out] changed - Bit i of word i / 64 is set for value i when it
+ *                          left the deadband. Other bits are left as is.
+ * @param count - The number of values.
+ *
+ * @return Returns the number of values that left the deadband.
+ */
+size_t value_table_deadband(
+  const float* values,
+  const float* reported,
+  const float* increments,
+  uint64_t* changed,
+  size_t count
+) {
+  size_t total = 0;
+
+  for (size_t base = 0; base < count; base += 64) {
+    size_t   length = count - base < 64 ? count - base : 64;
+    uint64_t bits   = 0;
+    size_t   i      = 0;
+
+    for (; i + 4 <= length; i += 4) {
+      v4f value     = { 0 };
+      v4f last      = { 0 };
+      v4f increment = { 0 };
+
+      memcpy(&value, &values[base + i], sizeof(value));
+      memcpy(&last, &reported[base + i], sizeof(last));
+      memcpy(&increment, &increments[base + i], sizeof(increment));
+
+      // clearing the sign bit of the difference gives its magnitude
+      v4f distance = (v4f)((v4i)(value - last) & 0x7FFFFFFF);
+      v4i is_out   = (distance >= increment) & (distance > 0);
+
+      uint64_t mask =
+          (is_out[0] & 1)
+        | (is_out[1] & 2)
+        | (is_out[2] & 4)
+        | (is_out[3] & 8);
+
+      bits |= mask << i;
+    }
+
+    for (; i < length; i++) {
+      float distance = fabsf(values[base + i] - reported[base + i]);
+
+      if (distance > 0 && distance >= increments[base + i])
+        bits |= 1ULL << i;
+    }
+
+    changed[base / 64] |= bits;
+    total += (size_t)__builtin_popcountll(bits);
+  }
+
+  return total;
+}
+
+static value_table_t* find_table(
+  uint32_t device_index,
+  BACNET_OBJECT_TYPE type
+) {
+  if (device_index >= MAX_NUM_DEVICES)
+    return NULL;
+
+  switch (type) {
+    case OBJECT_ANALOG_INPUT:
+      return &tables[device_index][TABLE_ANALOG_INPUT];
+
+    default:
+      return NULL;
+  }
+}
+
+static int find_slot(value_table_t* table, uint32_t instance)
+{
+  if (table->slots == NULL)
+    return -1;
+
+  for (uint32_t i = instance * 2654435761u; ; i++) {
+    uint32_t slot = table->slots[i & table->slot_mask];
+
+    if (slot == 0)
+      return -1;
+
+    if (table->instances[slot - 1] == instance)
+      return (int)slot - 1;
+  }
+}
+
+// the hash position of an instance known to be in the table
+static uint32_t find_hash(value_table_t* table, uint32_t instance)
+{
+  uint32_t i = instance * 2654435761u;
+  while (table->instances[table->slots[i & table->slot_mask] - 1] != instance)
+    i++;
+
+  return i & table->slot_mask;
+}
+
+// backward-shift deletion, so that probing never needs tombstones
+static void unlink_hash(value_table_t* table, uint32_t position)
+{
+  uint32_t mask = table->slot_mask;
+  uint32_t hole = position;
+
+  for (uint32_t i = (position + 1) & mask; ; i = (i + 1) & mask) {
+    uint32_t slot = table->slots[i];
+    if (slot == 0)
+      break;
+
+    uint32_t home = (table->instances[slot - 1] * 2654435761u) & mask;
+
+    // the entry may fill the hole if its home is not between the two
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      table->slots[hole] = slot;
+      hole = i;
+    }
+  }
+
+  table->slots[hole] = 0;
+}
+
+static bool grow_column(
+  void** column,
+  size_t size,
+  size_t old_count,
+  size_t new_count
+) {
+  // aligned_alloc wants a multiple of the alignment, which a small changed
+  // column is not
+  size_t bytes =
+    (new_count * size + COLUMN_ALIGNMENT - 1) & ~(size_t)(COLUMN_ALIGNMENT - 1);
+
+  void* grown =
+    memory_aligned_alloc(MEMORY_VALUE_TABLE, COLUMN_ALIGNMENT, bytes);
+  if (!grown)
+    return false;
+
+  memset(grown, 0, bytes);
+  if (*column)
+    memcpy(grown, *column, old_count * size);
+
+  memory_free(MEMORY_VALUE_TABLE, *column);
+  *column = grown;
+
+  return true;
+}
+
+static bool grow(value_table_t* table)
+{
+  uint32_t old_capacity = table->capacity;
+  uint32_t capacity     = old_capacity ? old_capacity * 2 : INITIAL_CAPACITY;
+
+  // the hash is kept at most half full
+  uint32_t* slots =
+    memory_calloc(MEMORY_VALUE_TABLE, (size_t)capacity * 2, sizeof(uint32_t));
+  if (!slots)
+    return false;
+
+  uint32_t old_words = old_capacity / 64;
+  uint32_t words     = capacity / 64;
+
+  bool is_grown =
+       grow_column(
+         (void**)&table->instances, sizeof(uint32_t), old_capacity, capacity)
+    && grow_column(
+         (void**)&table->values, sizeof(float), old_capacity, capacity)
+    && grow_column(
+         (void**)&table->reported, sizeof(float), old_capacity, capacity)
+    && grow_column(
+         (void**)&table->increments, sizeof(float), old_capacity, capacity)
+    && grow_column(
+         (void**)&table->objects, sizeof(void*), old_capacity, capacity)
+    && grow_column(
+         (void**)&table->changed, sizeof(uint64_t), old_words, words);
+
+  if (!is_grown) {
+    memory_free(MEMORY_VALUE_TABLE, slots);
+    return false;
+  }
+
+  memory_free(MEMORY_VALUE_TABLE, table->slots);
+  table->slots     = slots;
+  table->slot_mask = capacity * 2 - 1;
+  table->capacity  = capacity;
+
+  for (uint32_t slot = 0; slot < table->count; slot++) {
+    uint32_t i = table->instances[slot] * 2654435761u;
+    while (slots[i & table->slot_mask] != 0)
+      i++;
+
+    slots[i & table->slot_mask] = slot + 1;
+  }
+
+  return true;
+}
+
+static size_t mark_changed(value_table_t* table)
+{
+  size_t marked = 0;
+
+  for (uint32_t word = 0; word < table->capacity / 64; word++) {
+    uint64_t bits = table->changed[word];
+    table->changed[word] = 0;
+
+    while (bits) {
+      uint32_t slot = word * 64 + (uint32_t)__builtin_ctzll(bits);
+      bits &= bits - 1;
+
+      ROUTED_ANALOG_INPUT_OBJECT* object = table->objects[slot];
+
+      table->reported[slot] = table->values[slot];
+      object->Changed       = true;
+      marked++;
+    }
+  }
+
+  return marked;
+}
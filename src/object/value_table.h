@@ -0,0 +1,42 @@
+#ifndef BACNET_OBJECT_VALUE_TABLE_H
+#define BACNET_OBJECT_VALUE_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <bacnet/bacenum.h>
+
+// how often present values are checked against their COV increment
+#ifndef VALUE_TABLE_SCAN_MS
+#define VALUE_TABLE_SCAN_MS 1000
+#endif
+
+bool value_table_add(
+  uint32_t device_index,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance,
+  void* object);
+
+bool value_table_set(
+  uint32_t device_index,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance,
+  float value);
+
+bool value_table_remove(
+  uint32_t device_index,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance);
+
+void value_table_remove_device(uint32_t device_index);
+
+size_t value_table_scan(void);
+
+size_t value_table_deadband(
+  const float* values,
+  const float* reported,
+  const float* increments,
+  uint64_t* changed,
+  size_t count);
+
+#endif /* BACNET_OBJECT_VALUE_TABLE_H */
@@ -4,8 +4,11 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "capture.h"
 #include "log.h"
+#include "memory.h"
 #include "port.h"
+#include "watchdog.h"
 
 #define STRINGIFY(x) #x
 #define TOSTR(x) STRINGIFY(x)
@@ -82,6 +85,8 @@ int port_send(ei_x_buff* message)
   uint32_t total_bytes = htonl(message->index);
   size_t sent_bytes = 0;
 
+  watchdog_mark_t mark = watchdog_enter(WATCHDOG_STAGE_PORT_SEND, 0);
+
   pthread_mutex_lock(&write_lock);
   int rt = write(STDOUT_FILENO, &total_bytes, sizeof(total_bytes));
   if (rt != 4) {
@@ -103,10 +108,12 @@ int port_send(ei_x_buff* message)
   }
 
   pthread_mutex_unlock(&write_lock);
+  watchdog_leave(mark);
   return 0;
 
 error:
   pthread_mutex_unlock(&write_lock);
+  watchdog_leave(mark);
   return -1;
 }
 
@@ -114,7 +121,8 @@ error:
  * @brief Reads a message from the port.
  *
  * Reads the total byte count of an incoming message and allocates sufficient
- * memory to store the message, expanding as needed.
+ * memory to store the message, expanding as needed. The buffer must be
+ * charged to MEMORY_PORT.
  *
  * @param message A pointer to an `ei_x_buff` structure where the
  *                incoming message will be stored.
@@ -133,7 +141,8 @@ int port_read(ei_x_buff* message)
 
   message->index = total_bytes;
   if (message->index > message->buffsz) {
-    uint8_t* expanded_buffer = realloc(message->buff, message->index);
+    uint8_t* expanded_buffer =
+      memory_realloc(MEMORY_PORT, message->buff, message->index);
     if (expanded_buffer == NULL)
       return ENOMEM;
 
@@ -156,12 +165,17 @@ static void* read_loop(void* arg)
     ei_x_buff message;
     ei_x_new(&message);
 
+    // ei frees the buffer, which port_read grows
+    memory_track(MEMORY_PORT, message.buff);
+
     int return_code = port_read(&message);
     if (return_code == EBADF)
       break;
     else if (return_code != 0)
       goto cleanup;
 
+    capture_port((const char*)message.buff, message.index);
+
     int index = 0;
     int version = 0;
     ei_term term = { 0 };
@@ -192,6 +206,7 @@ static void* read_loop(void* arg)
     ei_x_free(&reply);
 
   cleanup:
+    memory_untrack(MEMORY_PORT, message.buff);
     ei_x_free(&message);
   }
 
@@ -1,6 +1,8 @@
 #include <ei.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "memory.h"
 #include "protocol/decode_call.h"
 #include "protocol/enum.h"
 
@@ -16,6 +18,16 @@ const enum_tuple_t BACNET_CALL_ATOMS[] = {
   {"create_characterstring_value",      CALL_CREATE_CHARACTERSTRING_VALUE},
   {"create_binary_input",               CALL_CREATE_BINARY_INPUT},
   {"set_binary_input_value",            CALL_SET_BINARY_INPUT_VALUE},
+  {"set_log_level",                     CALL_SET_LOG_LEVEL},
+  {"get_stats",                         CALL_GET_STATS},
+  {"get_hot_points",                    CALL_GET_HOT_POINTS},
+  {"get_flight_recorder",               CALL_GET_FLIGHT_RECORDER},
+  {"provision_device",                  CALL_PROVISION_DEVICE},
+  {"get_memory",                        CALL_GET_MEMORY},
+  {"delete_object",                     CALL_DELETE_OBJECT},
+  {"delete_routed_device",              CALL_DELETE_ROUTED_DEVICE},
+  {"set_command_actions",               CALL_SET_COMMAND_ACTIONS},
+  {NULL,                                CALL_UNKNOWN},
 };
 
 const size_t BACNET_CALL_SIZE_LOOKUP[] = {
@@ -30,6 +42,34 @@ const size_t BACNET_CALL_SIZE_LOOKUP[] = {
   sizeof(create_characterstring_value_t),
   sizeof(create_binary_input_t),
   sizeof(set_binary_input_value_t),
+  sizeof(set_log_level_t),
+  sizeof(get_stats_t),
+  sizeof(get_hot_points_t),
+  sizeof(get_flight_recorder_t),
+  sizeof(provision_device_t),
+  sizeof(get_memory_t),
+  sizeof(delete_object_t),
+  sizeof(delete_routed_device_t),
+  sizeof(set_command_actions_t),
+};
+
+const enum_tuple_t PROVISION_OBJECT_ATOMS[] = {
+  {"analog_input",          CALL_CREATE_ROUTED_ANALOG_INPUT},
+  {"multistate_input",      CALL_CREATE_ROUTED_MULTISTATE_INPUT},
+  {"command",               CALL_CREATE_ROUTED_COMMAND},
+  {"characterstring_value", CALL_CREATE_CHARACTERSTRING_VALUE},
+  {"binary_input",          CALL_CREATE_BINARY_INPUT},
+  {NULL,                    CALL_UNKNOWN},
+};
+
+static const enum_tuple_t ACTION_OBJECT_ATOMS[] = {
+  {"analog_input",          OBJECT_ANALOG_INPUT},
+  {"multistate_input",      OBJECT_MULTI_STATE_INPUT},
+  {"command",               OBJECT_COMMAND},
+  {"characterstring_value", OBJECT_CHARACTERSTRING_VALUE},
+  {"binary_input",          OBJECT_BINARY_INPUT},
+  {"device",                OBJECT_DEVICE},
+  {NULL,                    -1},
 };
 
 static int decode_call_type(char* buffer, int* index, uint8_t* type);
@@ -40,7 +80,7 @@ static int decode_call_data(char* buffer, int* index, uint8_t type, void* data);
  *
  * Allocates a block of memory based on the given call type and initializes
  * the memory to zero. The allocated memory's address is stored in the
- * provided pointer and must be freed by the user.
+ * provided pointer and must be freed with bacnet_call_free.
  *
  * @param type The type of BACnet call for which memory is being allocated.
  * @param call A pointer to a pointer where the address of the allocated
@@ -52,16 +92,51 @@ static int decode_call_data(char* buffer, int* index, uint8_t type, void* data);
 int bacnet_call_malloc(bacnet_call_type_t type, void** call)
 {
   size_t size  = BACNET_CALL_SIZE_LOOKUP[type];
-  void* buffer = malloc(size);
+  void* buffer = memory_calloc(MEMORY_CALLS, 1, size);
 
   if (buffer == NULL)
     return -1;
 
-  *call = memset(buffer, 0, size);
+  *call = buffer;
 
   return 0;
 }
 
+/**
+ * @brief Frees a BACnet call and the buffers its decoding allocated.
+ *
+ * @param type The type of the call.
+ * @param call The call allocated by bacnet_call_malloc, or NULL.
+ */
+void bacnet_call_free(bacnet_call_type_t type, void* call)
+{
+  if (call == NULL)
+    return;
+
+  switch (type) {
+    case CALL_CREATE_ROUTED_MULTISTATE_INPUT:
+      memory_free(
+        MEMORY_CALLS,
+        ((create_routed_multistate_input_t*)call)->states
+      );
+      break;
+
+    case CALL_PROVISION_DEVICE:
+      memory_free(MEMORY_CALLS, ((provision_device_t*)call)->objects);
+      break;
+
+    case CALL_SET_COMMAND_ACTIONS:
+      memory_free(MEMORY_CALLS, ((set_command_actions_t*)call)->commands);
+      memory_free(MEMORY_CALLS, ((set_command_actions_t*)call)->list_lengths);
+      break;
+
+    default:
+      break;
+  }
+
+  memory_free(MEMORY_CALLS, call);
+}
+
 /**
  * @brief Decodes the BACnet call type from a buffer.
  *
@@ -81,7 +156,7 @@ int decode_bacnet_call_type(char* buffer, int* index, bacnet_call_type_t* type)
 
   bool is_bad_message =
        ei_decode_tuple_header(buffer, index, &size)
-    || (size < 2)
+    || (size < 1)
     || decode_call_type(buffer, index, type);
 
   if (is_bad_message)
@@ -180,7 +255,7 @@ static int decode_bacnet_unit_atom(
   return 0;
 }
 
-static int decode_create_routed_analog_input(
+static int decode_analog_input_fields(
   char* buffer,
   int* index,
   create_routed_analog_input_t* data
@@ -189,8 +264,7 @@ static int decode_create_routed_analog_input(
   int  type = 0;
 
   bool is_invalid =
-       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
-    || ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
     || ei_get_type(buffer, index, &type, (int*)&size)
     || (size >= sizeof(data->name))
     || (memset(data->name, 0, sizeof(data->name)) == NULL)
@@ -204,6 +278,18 @@ static int decode_create_routed_analog_input(
   return is_invalid ? -1 : 0;
 }
 
+static int decode_create_routed_analog_input(
+  char* buffer,
+  int* index,
+  create_routed_analog_input_t* data
+) {
+  bool is_invalid =
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
+    || decode_analog_input_fields(buffer, index, data);
+
+  return is_invalid ? -1 : 0;
+}
+
 static int decode_set_routed_analog_input_value(
   char* buffer,
   int* index,
@@ -235,10 +321,12 @@ static int decode_multistate_states(
     if (ei_get_type(buffer, index, &type, (int *)&atom_size))
       return -1;
 
-    *out = realloc(*out, cursor + atom_size + 1);
-    if (*out == NULL)
+    char* grown = memory_realloc(MEMORY_CALLS, *out, cursor + atom_size + 1);
+    if (grown == NULL)
       goto cleanup;
 
+    *out = grown;
+
     char* cursor_buffer = *out + cursor;
     memset(cursor_buffer, 0, atom_size + 1);
 
@@ -250,8 +338,8 @@ static int decode_multistate_states(
     continue;
 
   cleanup:
-    if (*out != NULL)
-      free(*out);
+    memory_free(MEMORY_CALLS, *out);
+    *out = NULL;
 
     return -1;
   }
@@ -259,7 +347,7 @@ static int decode_multistate_states(
   return 0;
 }
 
-static int decode_create_routed_multistate_input(
+static int decode_multistate_input_fields(
   char* buffer,
   int* index,
   create_routed_multistate_input_t* data
@@ -268,8 +356,7 @@ static int decode_create_routed_multistate_input(
   int  type = 0;
 
   bool is_invalid =
-       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
-    || ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
     || ei_get_type(buffer, index, &type, (int*)&size)
     || (size >= sizeof(data->name))
     || (memset(data->name, 0, sizeof(data->name)) == NULL)
@@ -283,6 +370,18 @@ static int decode_create_routed_multistate_input(
   return is_invalid ? -1 : 0;
 }
 
+static int decode_create_routed_multistate_input(
+  char* buffer,
+  int* index,
+  create_routed_multistate_input_t* data
+) {
+  bool is_invalid =
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
+    || decode_multistate_input_fields(buffer, index, data);
+
+  return is_invalid ? -1 : 0;
+}
+
 static int decode_set_routed_multistate_input_value(
   char* buffer,
   int* index,
@@ -306,7 +405,7 @@ decode_command_value(char* buffer, int* index, create_routed_command_t* data) {
   return is_invalid ? -1 : 0;
 }
 
-static int decode_create_routed_command(
+static int decode_command_fields(
   char* buffer,
   int* index,
   create_routed_command_t* data
@@ -315,8 +414,7 @@ static int decode_create_routed_command(
   int  type = 0;
 
   bool is_invalid =
-       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
-    || ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
     || ei_get_type(buffer, index, &type, (int*)&size)
     || (size >= sizeof(data->name))
     || (memset(data->name, 0, sizeof(data->name)) == NULL)
@@ -331,6 +429,18 @@ static int decode_create_routed_command(
   return is_invalid ? -1 : 0;
 }
 
+static int decode_create_routed_command(
+  char* buffer,
+  int* index,
+  create_routed_command_t* data
+) {
+  bool is_invalid =
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
+    || decode_command_fields(buffer, index, data);
+
+  return is_invalid ? -1 : 0;
+}
+
 const enum_tuple_t BACNET_COMMAND_STATUS[] = {
   {"succeeded", COMMAND_SUCCEEDED},
   {"failed",    COMMAND_FAILED},
@@ -368,7 +478,7 @@ static int decode_set_routed_command_status(
   return is_invalid ? -1 : 0;
 }
 
-static int decode_create_characterstring_value(
+static int decode_characterstring_value_fields(
   char* buffer,
   int* index,
   create_characterstring_value_t* data
@@ -377,8 +487,7 @@ static int decode_create_characterstring_value(
   int  type = 0;
 
   bool is_invalid =
-       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
-    || ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
     || ei_get_type(buffer, index, &type, (int*)&size)
     || (size >= sizeof(data->name))
     || (memset(data->name, 0, sizeof(data->name)) == NULL)
@@ -395,6 +504,18 @@ static int decode_create_characterstring_value(
   return is_invalid ? -1 : 0;
 }
 
+static int decode_create_characterstring_value(
+  char* buffer,
+  int* index,
+  create_characterstring_value_t* data
+) {
+  bool is_invalid =
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
+    || decode_characterstring_value_fields(buffer, index, data);
+
+  return is_invalid ? -1 : 0;
+}
+
 const enum_tuple_t BACNET_POLARITY_ENUM_TUPLE[] = {
   {"normal",  POLARITY_NORMAL},
   {"reverse", POLARITY_REVERSE},
@@ -417,7 +538,7 @@ static int decode_polarity(char* buffer, int* index, BACNET_POLARITY* polarity)
   return 0;
 }
 
-static int decode_create_binary_input(
+static int decode_binary_input_fields(
   char* buffer,
   int* index,
   create_binary_input_t* data
@@ -426,8 +547,7 @@ static int decode_create_binary_input(
   int  type = 0;
 
   bool is_invalid =
-       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
-    || ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->object_bacnet_id)
     || ei_get_type(buffer, index, &type, (int*)&size)
     || (size >= sizeof(data->name))
     || (memset(data->name, 0, sizeof(data->name)) == NULL)
@@ -450,6 +570,18 @@ static int decode_create_binary_input(
   return is_invalid ? -1 : 0;
 }
 
+static int decode_create_binary_input(
+  char* buffer,
+  int* index,
+  create_binary_input_t* data
+) {
+  bool is_invalid =
+       ei_decode_ulong(buffer, index, (unsigned long*)&data->device_bacnet_id)
+    || decode_binary_input_fields(buffer, index, data);
+
+  return is_invalid ? -1 : 0;
+}
+
 static int decode_set_binary_input_value(
   char* buffer,
   int* index,
@@ -463,6 +595,427 @@ static int decode_set_binary_input_value(
   return is_invalid ? -1 : 0;
 }
 
+const enum_tuple_t BACNET_LOG_LEVEL_ATOMS[] = {
+  {"emergency", EMERGENCY},
+  {"alert",     ALERT},
+  {"critical",  CRITICAL},
+  {"error",     ERROR},
+  {"warning",   WARNING},
+  {"notice",    NOTICE},
+  {"info",      INFO},
+  {"debug",     DEBUG},
+  {NULL,        -1},
+};
+
+static int decode_set_log_level(
+  char* buffer,
+  int* index,
+  set_log_level_t* data
+) {
+  char atom[MAXATOMLEN] = { 0 };
+
+  if (ei_decode_atom(buffer, index, atom) == -1)
+    return -1;
+
+  int enum_value = find_enum_value(BACNET_LOG_LEVEL_ATOMS, atom);
+  if (enum_value == -1)
+    return -1;
+
+  data->level = (log_level_t)enum_value;
+
+  return 0;
+}
+
+static int decode_get_hot_points(
+  char* buffer,
+  int* index,
+  get_hot_points_t* data
+) {
+  unsigned long limit = 0;
+
+  if (ei_decode_ulong(buffer, index, &limit))
+    return -1;
+
+  data->limit = (uint32_t)limit;
+
+  return 0;
+}
+
+static int decode_delete_object(
+  char* buffer,
+  int* index,
+  delete_object_t* data
+) {
+  unsigned long device_bacnet_id = 0;
+  unsigned long object_bacnet_id = 0;
+
+  bool is_invalid =
+       ei_decode_ulong(buffer, index, &device_bacnet_id)
+    || ei_decode_ulong(buffer, index, &object_bacnet_id);
+
+  if (is_invalid)
+    return -1;
+
+  data->device_bacnet_id = (uint32_t)device_bacnet_id;
+  data->object_bacnet_id = (uint32_t)object_bacnet_id;
+
+  return 0;
+}
+
+static int decode_delete_routed_device(
+  char* buffer,
+  int* index,
+  delete_routed_device_t* data
+) {
+  unsigned long bacnet_id = 0;
+
+  if (ei_decode_ulong(buffer, index, &bacnet_id))
+    return -1;
+
+  data->bacnet_id = (uint32_t)bacnet_id;
+
+  return 0;
+}
+
+static int decode_action_value(
+  char* buffer,
+  int* index,
+  BACNET_ACTION_PROPERTY_VALUE* value
+) {
+  char          atom[MAXATOMLEN] = { 0 };
+  int           arity            = 0;
+  long          number           = 0;
+  unsigned long enumerated       = 0;
+  double        real             = 0;
+
+  // ei leaves the index alone when a term isn't of the type asked for
+  if (ei_decode_atom(buffer, index, atom) == 0) {
+    if (strcmp(atom, "nil") == 0) {
+      value->tag = BACNET_APPLICATION_TAG_NULL;
+      return 0;
+    }
+
+    if (strcmp(atom, "true") && strcmp(atom, "false"))
+      return -1;
+
+    value->tag          = BACNET_APPLICATION_TAG_BOOLEAN;
+    value->type.Boolean = strcmp(atom, "true") == 0;
+    return 0;
+  }
+
+  if (ei_decode_double(buffer, index, &real) == 0) {
+    value->tag       = BACNET_APPLICATION_TAG_REAL;
+    value->type.Real = (float)real;
+    return 0;
+  }
+
+  if (ei_decode_long(buffer, index, &number) == 0) {
+    if (number < INT32_MIN || number > (long)UINT32_MAX)
+      return -1;
+
+    if (number < 0) {
+      value->tag             = BACNET_APPLICATION_TAG_SIGNED_INT;
+      value->type.Signed_Int = (int32_t)number;
+    }
+    else {
+      value->tag               = BACNET_APPLICATION_TAG_UNSIGNED_INT;
+      value->type.Unsigned_Int = (uint32_t)number;
+    }
+    return 0;
+  }
+
+  bool is_invalid =
+       ei_decode_tuple_header(buffer, index, &arity)
+    || (arity != 2)
+    || ei_decode_atom(buffer, index, atom)
+    || strcmp(atom, "enumerated")
+    || ei_decode_ulong(buffer, index, &enumerated)
+    || (enumerated > UINT32_MAX);
+
+  if (is_invalid)
+    return -1;
+
+  value->tag             = BACNET_APPLICATION_TAG_ENUMERATED;
+  value->type.Enumerated = (uint32_t)enumerated;
+
+  return 0;
+}
+
+static int decode_action_command(
+  char* buffer,
+  int* index,
+  BACNET_ACTION_LIST* command
+) {
+  int           arity            = 0;
+  int           quit_on_failure  = 0;
+  int           object_type      = -1;
+  unsigned long device_bacnet_id = 0;
+  unsigned long object_bacnet_id = 0;
+  unsigned long property         = PROP_PRESENT_VALUE;
+  unsigned long priority         = 0;
+  char          atom[MAXATOMLEN] = { 0 };
+
+  bool is_invalid =
+       ei_decode_tuple_header(buffer, index, &arity)
+    || (arity != 7)
+    || ei_decode_ulong(buffer, index, &device_bacnet_id)
+    || ei_decode_atom(buffer, index, atom)
+    || (object_type = find_enum_value(ACTION_OBJECT_ATOMS, atom)) == -1
+    || ei_decode_ulong(buffer, index, &object_bacnet_id);
+
+  if (is_invalid)
+    return -1;
+
+  // the property is an atom only for the present value
+  if (ei_decode_atom(buffer, index, atom) == 0) {
+    if (strcmp(atom, "present_value"))
+      return -1;
+  }
+  else if (ei_decode_ulong(buffer, index, &property)) {
+    return -1;
+  }
+
+  is_invalid =
+       decode_action_value(buffer, index, &command->Value)
+    || ei_decode_ulong(buffer, index, &priority)
+    || (priority > BACNET_MAX_PRIORITY)
+    || ei_decode_boolean(buffer, index, &quit_on_failure)
+    || (device_bacnet_id >= BACNET_MAX_INSTANCE)
+    || (object_bacnet_id >= BACNET_MAX_INSTANCE);
+
+  if (is_invalid)
+    return -1;
+
+  command->Device_Id.type       = OBJECT_DEVICE;
+  command->Device_Id.instance   = (uint32_t)device_bacnet_id;
+  command->Object_Id.type       = (BACNET_OBJECT_TYPE)object_type;
+  command->Object_Id.instance   = (uint32_t)object_bacnet_id;
+  command->Property_Identifier  = (BACNET_PROPERTY_ID)property;
+  command->Property_Array_Index = BACNET_ARRAY_ALL;
+  command->Priority             = (uint8_t)priority;
+  command->Quit_On_Failure      = quit_on_failure;
+  command->Write_Successful     = false;
+
+  return 0;
+}
+
+static int decode_action_list(
+  char* buffer,
+  int* index,
+  set_command_actions_t* data,
+  uint32_t* length
+) {
+  int count = 0;
+
+  if (ei_decode_list_header(buffer, index, &count))
+    return -1;
+
+  if (count == 0)
+    return 0;
+
+  BACNET_ACTION_LIST* grown =
+    memory_realloc(
+      MEMORY_CALLS,
+      data->commands,
+      (data->command_count + count) * sizeof(BACNET_ACTION_LIST)
+    );
+
+  if (grown == NULL)
+    return -1;
+
+  data->commands = grown;
+
+  for (int i = 0; i < count; i++) {
+    BACNET_ACTION_LIST* command = &data->commands[data->command_count];
+    memset(command, 0, sizeof(BACNET_ACTION_LIST));
+
+    if (decode_action_command(buffer, index, command))
+      return -1;
+
+    data->command_count++;
+  }
+
+  *length = (uint32_t)count;
+
+  // a non-empty list ends with an empty one
+  return ei_decode_list_header(buffer, index, &count);
+}
+
+static int decode_set_command_actions(
+  char* buffer,
+  int* index,
+  set_command_actions_t* data
+) {
+  unsigned long device_bacnet_id = 0;
+  unsigned long object_bacnet_id = 0;
+  int           list_count       = 0;
+
+  bool is_invalid =
+       ei_decode_ulong(buffer, index, &device_bacnet_id)
+    || ei_decode_ulong(buffer, index, &object_bacnet_id)
+    || ei_decode_list_header(buffer, index, &list_count);
+
+  if (is_invalid)
+    return -1;
+
+  data->device_bacnet_id = (uint32_t)device_bacnet_id;
+  data->object_bacnet_id = (uint32_t)object_bacnet_id;
+
+  if (list_count == 0)
+    return 0;
+
+  data->list_lengths =
+    memory_calloc(MEMORY_CALLS, list_count, sizeof(uint32_t));
+  if (data->list_lengths == NULL)
+    return -1;
+
+  data->list_count = list_count;
+
+  for (int i = 0; i < list_count; i++) {
+    if (decode_action_list(buffer, index, data, &data->list_lengths[i]))
+      return -1;
+  }
+
+  return 0;
+}
+
+static int decode_provision_entry(
+  char* buffer,
+  int* index,
+  provision_object_t* object
+) {
+  int           arity            = 0;
+  unsigned long instance         = 0;
+  char          atom[MAXATOMLEN] = { 0 };
+
+  object->index = *index;
+
+  bool is_invalid =
+       ei_decode_tuple_header(buffer, index, &arity)
+    || (arity < 2)
+    || ei_decode_atom(buffer, index, atom)
+    || find_enum_value(PROVISION_OBJECT_ATOMS, atom) == -1
+    || ei_decode_ulong(buffer, index, &instance);
+
+  if (is_invalid)
+    return -1;
+
+  object->type             = find_enum_value(PROVISION_OBJECT_ATOMS, atom);
+  object->object_bacnet_id = (uint32_t)instance;
+
+  // the rest of the object is decoded when it is created
+  *index = object->index;
+
+  return ei_skip_term(buffer, index);
+}
+
+static int decode_provision_device(
+  char* buffer,
+  int* index,
+  provision_device_t* data
+) {
+  int count = 0;
+
+  bool is_invalid =
+       decode_create_routed_device(buffer, index, &data->device)
+    || ei_decode_list_header(buffer, index, &count);
+
+  if (is_invalid)
+    return -1;
+
+  data->buffer = buffer;
+
+  if (count == 0)
+    return 0;
+
+  data->objects =
+    memory_calloc(MEMORY_CALLS, count, sizeof(provision_object_t));
+  if (data->objects == NULL)
+    return -1;
+
+  data->object_count = count;
+
+  for (int i = 0; i < count; i++) {
+    if (decode_provision_entry(buffer, index, &data->objects[i])) {
+      memory_free(MEMORY_CALLS, data->objects);
+      data->objects = NULL;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Decodes one object of a provision_device call.
+ *
+ * Objects are decoded as they are created, so that a malformed object fails
+ * on its own rather than failing the whole call.
+ *
+ * @param buffer           A pointer to the buffer holding the call.
+ * @param object           The object, as located by decode_bacnet_call.
+ * @param device_bacnet_id The BACnet ID of the device being provisioned.
+ * @param params           A pointer to where the create parameters for the
+ *                         object's type will be stored.
+ *
+ * @return Returns 0 if decoding is successful, or -1 if the object is
+ *         malformed.
+ */
+int decode_provision_object(
+  char* buffer,
+  provision_object_t* object,
+  uint32_t device_bacnet_id,
+  provision_object_params_t* params
+) {
+  int  index            = object->index;
+  int  arity            = 0;
+  char atom[MAXATOMLEN] = { 0 };
+
+  memset(params, 0, sizeof(*params));
+
+  bool is_invalid =
+       ei_decode_tuple_header(buffer, &index, &arity)
+    || ei_decode_atom(buffer, &index, atom);
+
+  if (is_invalid)
+    return -1;
+
+  switch (object->type) {
+    case CALL_CREATE_ROUTED_ANALOG_INPUT:
+      params->analog_input.device_bacnet_id = device_bacnet_id;
+      return decode_analog_input_fields(buffer, &index, &params->analog_input);
+
+    case CALL_CREATE_ROUTED_MULTISTATE_INPUT:
+      params->multistate_input.device_bacnet_id = device_bacnet_id;
+      return
+        decode_multistate_input_fields(
+          buffer,
+          &index,
+          &params->multistate_input
+        );
+
+    case CALL_CREATE_ROUTED_COMMAND:
+      params->command.device_bacnet_id = device_bacnet_id;
+      return decode_command_fields(buffer, &index, &params->command);
+
+    case CALL_CREATE_CHARACTERSTRING_VALUE:
+      params->characterstring_value.device_bacnet_id = device_bacnet_id;
+      return
+        decode_characterstring_value_fields(
+          buffer,
+          &index,
+          &params->characterstring_value
+        );
+
+    case CALL_CREATE_BINARY_INPUT:
+      params->binary_input.device_bacnet_id = device_bacnet_id;
+      return decode_binary_input_fields(buffer, &index, &params->binary_input);
+
+    default:
+      return -1;
+  }
+}
+
 static int decode_call_data(
   char* buffer,
   int* index,
@@ -503,6 +1056,33 @@ static int decode_call_data(
     case CALL_SET_BINARY_INPUT_VALUE:
       return decode_set_binary_input_value(buffer, index, data);
 
+    case CALL_SET_LOG_LEVEL:
+      return decode_set_log_level(buffer, index, data);
+
+    case CALL_GET_STATS:
+      return 0;
+
+    case CALL_GET_HOT_POINTS:
+      return decode_get_hot_points(buffer, index, data);
+
+    case CALL_GET_FLIGHT_RECORDER:
+      return 0;
+
+    case CALL_PROVISION_DEVICE:
+      return decode_provision_device(buffer, index, data);
+
+    case CALL_GET_MEMORY:
+      return 0;
+
+    case CALL_DELETE_OBJECT:
+      return decode_delete_object(buffer, index, data);
+
+    case CALL_DELETE_ROUTED_DEVICE:
+      return decode_delete_routed_device(buffer, index, data);
+
+    case CALL_SET_COMMAND_ACTIONS:
+      return decode_set_command_actions(buffer, index, data);
+
     default:
       return -1;
   }
@@ -1,8 +1,13 @@
 #ifndef BACNET_DECODE_CALL_H
 #define BACNET_DECODE_CALL_H
 
+#include <ei.h>
+#include <bacnet/bacaction.h>
 #include <bacnet/bacstr.h>
 
+#include "log.h"
+#include "protocol/enum.h"
+
 typedef enum {
   CALL_CREATE_GATEWAY,
   CALL_CREATE_ROUTED_DEVICE,
@@ -15,6 +20,15 @@ typedef enum {
   CALL_CREATE_CHARACTERSTRING_VALUE,
   CALL_CREATE_BINARY_INPUT,
   CALL_SET_BINARY_INPUT_VALUE,
+  CALL_SET_LOG_LEVEL,
+  CALL_GET_STATS,
+  CALL_GET_HOT_POINTS,
+  CALL_GET_FLIGHT_RECORDER,
+  CALL_PROVISION_DEVICE,
+  CALL_GET_MEMORY,
+  CALL_DELETE_OBJECT,
+  CALL_DELETE_ROUTED_DEVICE,
+  CALL_SET_COMMAND_ACTIONS,
   CALL_UNKNOWN = 255,
 } __attribute__((packed)) bacnet_call_type_t;
 
@@ -103,7 +117,72 @@ typedef struct {
   bool     value;
 } set_binary_input_value_t;
 
+typedef struct {
+  log_level_t level;
+} set_log_level_t;
+
+typedef struct {
+  uint8_t unused;
+} get_stats_t;
+
+typedef struct {
+  uint32_t limit;
+} get_hot_points_t;
+
+typedef struct {
+  uint8_t unused;
+} get_flight_recorder_t;
+
+typedef struct {
+  uint8_t unused;
+} get_memory_t;
+
+typedef struct {
+  uint32_t device_bacnet_id;
+  uint32_t object_bacnet_id;
+} delete_object_t;
+
+typedef struct {
+  uint32_t bacnet_id;
+} delete_routed_device_t;
+
+typedef struct {
+  uint32_t device_bacnet_id;
+  uint32_t object_bacnet_id;
+
+  // the commands of every list, with list n holding list_lengths[n] of them
+  BACNET_ACTION_LIST* commands;
+  size_t              command_count;
+  uint32_t*           list_lengths;
+  size_t              list_count;
+} set_command_actions_t;
+
+typedef struct {
+  uint32_t           object_bacnet_id;
+  bacnet_call_type_t type;
+  int                index;
+} provision_object_t;
+
+typedef struct {
+  create_routed_device_t device;
+  char*                  buffer;
+  provision_object_t*    objects;
+  size_t                 object_count;
+} provision_device_t;
+
+typedef union {
+  create_routed_analog_input_t     analog_input;
+  create_routed_multistate_input_t multistate_input;
+  create_routed_command_t          command;
+  create_characterstring_value_t   characterstring_value;
+  create_binary_input_t            binary_input;
+} provision_object_params_t;
+
+extern const enum_tuple_t BACNET_CALL_ATOMS[];
+extern const enum_tuple_t PROVISION_OBJECT_ATOMS[];
+
 int bacnet_call_malloc(bacnet_call_type_t type, void** call);
+void bacnet_call_free(bacnet_call_type_t type, void* call);
 
 int decode_bacnet_call_type(char* buffer, int* index, bacnet_call_type_t* type);
 
@@ -113,4 +192,10 @@ int decode_bacnet_call(
       bacnet_call_type_t type,
       void* call);
 
+int decode_provision_object(
+  char* buffer,
+  provision_object_t* object,
+  uint32_t device_bacnet_id,
+  provision_object_params_t* params);
+
 #endif /* BACNET_DECODE_CALL_H */
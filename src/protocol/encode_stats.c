@@ -0,0 +1,644 @@
+#include <stdlib.h>
+#include <bacnet/basic/object/routed_analog_input.h>
+#include <bacnet/basic/object/routed_multistate_input.h>
+#include <bacnet/basic/object/routed_object.h>
+
+#include "device_index.h"
+#include "heat_map.h"
+#include "memory.h"
+#include "object/binary_input.h"
+#include "object/characterstring_value.h"
+#include "object/command.h"
+#include "protocol/decode_call.h"
+#include "protocol/encode_stats.h"
+#include "service/ingress.h"
+#include "service/reply_cache.h"
+#include "service/segment.h"
+#include "service/who_is.h"
+#include "stats.h"
+#include "watchdog.h"
+
+static const char* SERVICE_ATOMS[STATS_SERVICE_COUNT] = {
+  [STATS_SERVICE_READ_PROPERTY]           = "read_property",
+  [STATS_SERVICE_READ_PROPERTY_MULTIPLE]  = "read_property_multiple",
+  [STATS_SERVICE_WRITE_PROPERTY]          = "write_property",
+  [STATS_SERVICE_WRITE_PROPERTY_MULTIPLE] = "write_property_multiple",
+  [STATS_SERVICE_SUBSCRIBE_COV]           = "subscribe_cov",
+  [STATS_SERVICE_WHO_IS]                  = "who_is",
+  [STATS_SERVICE_WHO_HAS]                 = "who_has",
+  [STATS_SERVICE_OTHER]                   = "other",
+};
+
+typedef void (*slab_stats_fn_t)(
+  const DEVICE_OBJECT_DATA* device,
+  slab_stats_t* stats);
+
+static const struct {
+  const char*     atom;
+  slab_stats_fn_t get_stats;
+} SLAB_POOLS[] = {
+  { "binary_input",          binary_input_slab_stats },
+  { "command",               command_slab_stats },
+  { "characterstring_value", characterstring_value_slab_stats },
+};
+
+static const char* SUBSYSTEM_ATOMS[MEMORY_SUBSYSTEM_COUNT] = {
+  [MEMORY_OBJECTS]     = "objects",
+  [MEMORY_STRINGS]     = "strings",
+  [MEMORY_NAME_INDEX]  = "name_index",
+  [MEMORY_VALUE_TABLE] = "value_table",
+  [MEMORY_CALLS]       = "calls",
+  [MEMORY_PORT]        = "port",
+  [MEMORY_SEGMENTS]    = "segments",
+  [MEMORY_SNAPSHOT]    = "snapshot",
+};
+
+// objects allocated by the stack have no slab, and are counted at their size
+static const struct {
+  const char*        atom;
+  BACNET_OBJECT_TYPE type;
+  size_t             stack_size;
+  slab_stats_fn_t    get_stats;
+} OBJECT_TYPES[] = {
+  {
+    "analog_input",
+    OBJECT_ANALOG_INPUT,
+    sizeof(ROUTED_ANALOG_INPUT_OBJECT),
+    NULL,
+  },
+  {
+    "multistate_input",
+    OBJECT_MULTI_STATE_INPUT,
+    sizeof(ROUTED_MULTISTATE_INPUT_OBJECT),
+    NULL,
+  },
+  {
+    "binary_input",
+    OBJECT_BINARY_INPUT,
+    0,
+    binary_input_slab_stats,
+  },
+  {
+    "command",
+    OBJECT_COMMAND,
+    0,
+    command_slab_stats,
+  },
+  {
+    "characterstring_value",
+    OBJECT_CHARACTERSTRING_VALUE,
+    0,
+    characterstring_value_slab_stats,
+  },
+};
+
+#define OBJECT_TYPE_COUNT (sizeof(OBJECT_TYPES) / sizeof(OBJECT_TYPES[0]))
+
+typedef struct {
+  size_t objects;
+  size_t bytes;
+} object_usage_t;
+
+static void encode_services(ei_x_buff* reply, stats_snapshot_t* snapshot);
+static void encode_calls(ei_x_buff* reply, stats_snapshot_t* snapshot);
+static void encode_devices(ei_x_buff* reply, stats_snapshot_t* snapshot);
+static void encode_histogram(ei_x_buff* reply, stats_histogram_t* histogram);
+static void encode_queues(ei_x_buff* reply);
+static void encode_ingress(ei_x_buff* reply);
+static void encode_talker(ei_x_buff* reply, ingress_talker_t* talker);
+static void encode_reply_cache(ei_x_buff* reply);
+static void encode_slabs(ei_x_buff* reply);
+static void encode_points(ei_x_buff* reply, heat_map_kind_t kind, size_t max);
+static void encode_account(ei_x_buff* reply, memory_stats_t* stats);
+static void encode_usage(ei_x_buff* reply, object_usage_t* usage);
+
+static void measure_device(
+  DEVICE_OBJECT_DATA* device,
+  object_usage_t usage[OBJECT_TYPE_COUNT]);
+
+/**
+ * @brief Encodes the runtime counters of the daemon.
+ *
+ * The counters are encoded as a map with the keys `services`, `calls`,
+ * `devices`, `apdu_latency`, `call_latency`, `command_latency`,
+ * `command_timeouts`, `cov_notifications`, `queues`, `ingress`,
+ * `reply_cache` and `slabs`.
+ * Latencies are histograms, whose buckets are `{upper_limit_us, count}`
+ * tuples for the non-empty buckets, with `:infinity` as the limit of the last
+ * one. Slabs are keyed by object type, and ingress lists its busiest sources
+ * under `top_talkers`.
+ *
+ * @param reply A pointer to the buffer to encode into.
+ *
+ * @return Returns 0.
+ */
+int encode_stats(ei_x_buff* reply)
+{
+  stats_snapshot_t snapshot = { 0 };
+  stats_collect(&snapshot);
+
+  ei_x_encode_map_header(reply, 12);
+
+  ei_x_encode_atom(reply, "services");
+  encode_services(reply, &snapshot);
+
+  ei_x_encode_atom(reply, "calls");
+  encode_calls(reply, &snapshot);
+
+  ei_x_encode_atom(reply, "devices");
+  encode_devices(reply, &snapshot);
+
+  ei_x_encode_atom(reply, "apdu_latency");
+  encode_histogram(reply, &snapshot.apdu_latency);
+
+  ei_x_encode_atom(reply, "call_latency");
+  encode_histogram(reply, &snapshot.call_latency);
+
+  ei_x_encode_atom(reply, "command_latency");
+  encode_histogram(reply, &snapshot.command_latency);
+
+  ei_x_encode_atom(reply, "command_timeouts");
+  ei_x_encode_ulonglong(reply, snapshot.command_timeouts);
+
+  ei_x_encode_atom(reply, "cov_notifications");
+  ei_x_encode_ulonglong(reply, snapshot.cov_notifications);
+
+  ei_x_encode_atom(reply, "queues");
+  encode_queues(reply);
+
+  ei_x_encode_atom(reply, "ingress");
+  encode_ingress(reply);
+
+  ei_x_encode_atom(reply, "reply_cache");
+  encode_reply_cache(reply);
+
+  ei_x_encode_atom(reply, "slabs");
+  encode_slabs(reply);
+
+  return 0;
+}
+
+/**
+ * @brief Encodes the most read and most subscribed object properties.
+ *
+ * The points are encoded as a map with the keys `read` and `subscribe`, each
+ * holding a list of `{device, object_type, object_instance, property, count}`
+ * tuples, hottest first. Counts are approximate and may be overestimated.
+ *
+ * @param reply A pointer to the buffer to encode into.
+ * @param limit The maximum number of points per list.
+ *
+ * @return Returns 0.
+ */
+int encode_hot_points(ei_x_buff* reply, uint32_t limit)
+{
+  if (limit > HEAT_MAP_TOP_K)
+    limit = HEAT_MAP_TOP_K;
+
+  ei_x_encode_map_header(reply, 2);
+
+  ei_x_encode_atom(reply, "read");
+  encode_points(reply, HEAT_MAP_READ, limit);
+
+  ei_x_encode_atom(reply, "subscribe");
+  encode_points(reply, HEAT_MAP_SUBSCRIBE, limit);
+
+  return 0;
+}
+
+/**
+ * @brief Encodes the flight recorder of the event loop.
+ *
+ * Entries are encoded as a list of maps, oldest first, with the keys
+ * `stage`, `started_us`, `duration_us`, `pdu_type`, `service` and `length`.
+ * The packet keys are only meaningful for `dispatch` entries.
+ *
+ * @param reply A pointer to the buffer to encode into.
+ *
+ * @return Returns 0, or -1 if the entries cannot be copied.
+ */
+int encode_flight_recorder(ei_x_buff* reply)
+{
+  flight_record_t* records =
+    calloc(FLIGHT_RECORDER_SIZE, sizeof(flight_record_t));
+
+  if (records == NULL)
+    return -1;
+
+  size_t count = flight_recorder_copy(records, FLIGHT_RECORDER_SIZE);
+
+  if (count > 0)
+    ei_x_encode_list_header(reply, count);
+
+  for (size_t i = 0; i < count; i++) {
+    flight_record_t* entry = &records[i];
+
+    ei_x_encode_map_header(reply, 6);
+
+    ei_x_encode_atom(reply, "stage");
+    ei_x_encode_atom(reply, watchdog_stage_name(entry->stage));
+
+    ei_x_encode_atom(reply, "started_us");
+    ei_x_encode_ulonglong(reply, entry->started_us);
+
+    ei_x_encode_atom(reply, "duration_us");
+    ei_x_encode_ulong(reply, entry->duration_us);
+
+    ei_x_encode_atom(reply, "pdu_type");
+    ei_x_encode_ulong(reply, entry->pdu_type);
+
+    ei_x_encode_atom(reply, "service");
+    ei_x_encode_ulong(reply, entry->service_choice);
+
+    ei_x_encode_atom(reply, "length");
+    ei_x_encode_ulong(reply, entry->pdu_len);
+  }
+
+  ei_x_encode_empty_list(reply);
+  free(records);
+
+  return 0;
+}
+
+/**
+ * @brief Encodes the heap usage of the daemon.
+ *
+ * Usage is encoded as a map with the keys `total`, `subsystems`,
+ * `object_types` and `devices`. The total and each subsystem are maps of
+ * live `bytes` and `allocations`, and of `peak_bytes`. Object types, and
+ * routed devices keyed by instance, are maps of their `objects` and of the
+ * `bytes` those take, strings excluded.
+ *
+ * @param reply A pointer to the buffer to encode into.
+ *
+ * @return Returns 0.
+ */
+int encode_memory(ei_x_buff* reply)
+{
+  device_index_entry_t devices[MAX_NUM_DEVICES] = { 0 };
+  object_usage_t       device_usage[MAX_NUM_DEVICES] = { 0 };
+  object_usage_t       type_usage[OBJECT_TYPE_COUNT] = { 0 };
+  memory_stats_t       stats = { 0 };
+
+  size_t count =
+    device_index_range(1, BACNET_MAX_INSTANCE, devices, MAX_NUM_DEVICES);
+
+  for (size_t i = 0; i < count; i++) {
+    object_usage_t usage[OBJECT_TYPE_COUNT] = { 0 };
+
+    measure_device(Get_Routed_Device_Object(devices[i].index), usage);
+
+    for (size_t t = 0; t < OBJECT_TYPE_COUNT; t++) {
+      device_usage[i].objects += usage[t].objects;
+      device_usage[i].bytes   += usage[t].bytes;
+      type_usage[t].objects   += usage[t].objects;
+      type_usage[t].bytes     += usage[t].bytes;
+    }
+  }
+
+  Get_Routed_Device_Object(0);
+
+  ei_x_encode_map_header(reply, 4);
+
+  ei_x_encode_atom(reply, "total");
+  memory_get_total(&stats);
+  encode_account(reply, &stats);
+
+  ei_x_encode_atom(reply, "subsystems");
+  ei_x_encode_map_header(reply, MEMORY_SUBSYSTEM_COUNT);
+
+  for (int s = 0; s < MEMORY_SUBSYSTEM_COUNT; s++) {
+    memory_get_stats(s, &stats);
+
+    ei_x_encode_atom(reply, SUBSYSTEM_ATOMS[s]);
+    encode_account(reply, &stats);
+  }
+
+  ei_x_encode_atom(reply, "object_types");
+  ei_x_encode_map_header(reply, OBJECT_TYPE_COUNT);
+
+  for (size_t t = 0; t < OBJECT_TYPE_COUNT; t++) {
+    ei_x_encode_atom(reply, OBJECT_TYPES[t].atom);
+    encode_usage(reply, &type_usage[t]);
+  }
+
+  ei_x_encode_atom(reply, "devices");
+  ei_x_encode_map_header(reply, count);
+
+  for (size_t i = 0; i < count; i++) {
+    ei_x_encode_ulong(reply, devices[i].instance);
+    encode_usage(reply, &device_usage[i]);
+  }
+
+  return 0;
+}
+
+static void encode_services(ei_x_buff* reply, stats_snapshot_t* snapshot)
+{
+  ei_x_encode_map_header(reply, STATS_SERVICE_COUNT);
+
+  for (int i = 0; i < STATS_SERVICE_COUNT; i++) {
+    ei_x_encode_atom(reply, SERVICE_ATOMS[i]);
+    ei_x_encode_ulonglong(reply, snapshot->services[i]);
+  }
+}
+
+static void encode_calls(ei_x_buff* reply, stats_snapshot_t* snapshot)
+{
+  long count = 0;
+  while (BACNET_CALL_ATOMS[count].atom != NULL)
+    count++;
+
+  ei_x_encode_map_header(reply, count);
+
+  for (long i = 0; i < count; i++) {
+    int type = BACNET_CALL_ATOMS[i].value;
+
+    // %{count: n, failed: n}
+    ei_x_encode_atom(reply, BACNET_CALL_ATOMS[i].atom);
+    ei_x_encode_map_header(reply, 2);
+    ei_x_encode_atom(reply, "count");
+    ei_x_encode_ulonglong(reply, snapshot->calls[type]);
+    ei_x_encode_atom(reply, "failed");
+    ei_x_encode_ulonglong(reply, snapshot->calls_failed[type]);
+  }
+}
+
+static void encode_devices(ei_x_buff* reply, stats_snapshot_t* snapshot)
+{
+  device_index_entry_t devices[MAX_NUM_DEVICES] = { 0 };
+
+  // keyed by device instance, instance 0 marks an unused slot
+  size_t count =
+    device_index_range(1, BACNET_MAX_INSTANCE, devices, MAX_NUM_DEVICES);
+
+  ei_x_encode_map_header(reply, count);
+
+  for (size_t i = 0; i < count; i++) {
+    uint32_t index = devices[i].index;
+
+    ei_x_encode_ulong(reply, devices[i].instance);
+    ei_x_encode_ulonglong(
+      reply,
+      index < MAX_NUM_DEVICES ? snapshot->devices[index] : 0
+    );
+  }
+}
+
+static void encode_histogram(ei_x_buff* reply, stats_histogram_t* histogram)
+{
+  long buckets = 0;
+  for (int b = 0; b < STATS_LATENCY_BUCKETS; b++)
+    buckets += histogram->buckets[b] > 0;
+
+  ei_x_encode_map_header(reply, 4);
+
+  ei_x_encode_atom(reply, "count");
+  ei_x_encode_ulonglong(reply, histogram->count);
+
+  ei_x_encode_atom(reply, "total_us");
+  ei_x_encode_ulonglong(reply, histogram->total_us);
+
+  ei_x_encode_atom(reply, "max_us");
+  ei_x_encode_ulonglong(reply, histogram->max_us);
+
+  ei_x_encode_atom(reply, "buckets");
+  if (buckets > 0)
+    ei_x_encode_list_header(reply, buckets);
+
+  for (int b = 0; b < STATS_LATENCY_BUCKETS; b++) {
+    if (histogram->buckets[b] == 0)
+      continue;
+
+    uint64_t limit = stats_bucket_limit_us(b);
+
+    ei_x_encode_tuple_header(reply, 2);
+    if (limit)
+      ei_x_encode_ulonglong(reply, limit);
+    else
+      ei_x_encode_atom(reply, "infinity");
+
+    ei_x_encode_ulonglong(reply, histogram->buckets[b]);
+  }
+
+  ei_x_encode_empty_list(reply);
+}
+
+static void encode_queues(ei_x_buff* reply)
+{
+  ingress_stats_t ingress = { 0 };
+  segment_stats_t segment = { 0 };
+  who_is_stats_t  who_is  = { 0 };
+
+  ingress_get_stats(&ingress);
+  segment_get_stats(&segment);
+  who_is_get_stats(&who_is);
+
+  ei_x_encode_map_header(reply, 9);
+
+  ei_x_encode_atom(reply, "ingress_high");
+  ei_x_encode_ulong(reply, ingress.queue_depth[INGRESS_PRIORITY_HIGH]);
+
+  ei_x_encode_atom(reply, "ingress_low");
+  ei_x_encode_ulong(reply, ingress.queue_depth[INGRESS_PRIORITY_LOW]);
+
+  ei_x_encode_atom(reply, "ingress_high_peak");
+  ei_x_encode_ulong(reply, ingress.queue_high_water[INGRESS_PRIORITY_HIGH]);
+
+  ei_x_encode_atom(reply, "ingress_low_peak");
+  ei_x_encode_ulong(reply, ingress.queue_high_water[INGRESS_PRIORITY_LOW]);
+
+  ei_x_encode_atom(reply, "segment_transactions");
+  ei_x_encode_ulong(reply, segment.active);
+
+  ei_x_encode_atom(reply, "i_am_pending");
+  ei_x_encode_ulong(reply, who_is.i_am_pending);
+
+  ei_x_encode_atom(reply, "i_am_rate");
+  ei_x_encode_ulong(reply, who_is.i_am_rate);
+
+  ei_x_encode_atom(reply, "i_am_peak_rate");
+  ei_x_encode_ulong(reply, who_is.i_am_peak_rate);
+
+  ei_x_encode_atom(reply, "i_am_sent");
+  ei_x_encode_ulong(reply, who_is.i_am_sent);
+}
+
+static void encode_ingress(ei_x_buff* reply)
+{
+  ingress_stats_t  stats = { 0 };
+  ingress_talker_t talkers[INGRESS_TOP_TALKERS] = { 0 };
+
+  ingress_get_stats(&stats);
+  int count = ingress_top_talkers(talkers, INGRESS_TOP_TALKERS);
+
+  ei_x_encode_map_header(reply, 7);
+
+  ei_x_encode_atom(reply, "received");
+  ei_x_encode_ulong(reply, stats.received);
+
+  ei_x_encode_atom(reply, "dispatched");
+  ei_x_encode_ulong(reply, stats.dispatched);
+
+  ei_x_encode_atom(reply, "shed_rate_limited");
+  ei_x_encode_ulong(reply, stats.shed_rate_limited);
+
+  ei_x_encode_atom(reply, "shed_queue_full");
+  ei_x_encode_ulong(reply, stats.shed_queue_full);
+
+  ei_x_encode_atom(reply, "shed_stale");
+  ei_x_encode_ulong(reply, stats.shed_stale);
+
+  ei_x_encode_atom(reply, "aborts_sent");
+  ei_x_encode_ulong(reply, stats.aborts_sent);
+
+  ei_x_encode_atom(reply, "top_talkers");
+  if (count > 0)
+    ei_x_encode_list_header(reply, count);
+
+  for (int i = 0; i < count; i++)
+    encode_talker(reply, &talkers[i]);
+
+  ei_x_encode_empty_list(reply);
+}
+
+static void encode_talker(ei_x_buff* reply, ingress_talker_t* talker)
+{
+  BACNET_ADDRESS* address = &talker->address;
+
+  // %{network: n, address: <<...>>, packets: n, bytes: n, shed: n}
+  ei_x_encode_map_header(reply, 5);
+
+  // a source behind a router is known by its address on the remote network
+  ei_x_encode_atom(reply, "network");
+  ei_x_encode_ulong(reply, address->net);
+
+  ei_x_encode_atom(reply, "address");
+  if (address->net > 0)
+    ei_x_encode_binary(reply, address->adr, address->len);
+  else
+    ei_x_encode_binary(reply, address->mac, address->mac_len);
+
+  ei_x_encode_atom(reply, "packets");
+  ei_x_encode_ulong(reply, talker->packets);
+
+  ei_x_encode_atom(reply, "bytes");
+  ei_x_encode_ulong(reply, talker->bytes);
+
+  ei_x_encode_atom(reply, "shed");
+  ei_x_encode_ulong(reply, talker->shed);
+}
+
+static void encode_reply_cache(ei_x_buff* reply)
+{
+  reply_cache_stats_t stats = { 0 };
+  reply_cache_get_stats(&stats);
+
+  ei_x_encode_map_header(reply, 6);
+
+  ei_x_encode_atom(reply, "hits");
+  ei_x_encode_ulong(reply, stats.hits);
+
+  ei_x_encode_atom(reply, "misses");
+  ei_x_encode_ulong(reply, stats.misses);
+
+  ei_x_encode_atom(reply, "stored");
+  ei_x_encode_ulong(reply, stats.stored);
+
+  ei_x_encode_atom(reply, "evicted");
+  ei_x_encode_ulong(reply, stats.evicted);
+
+  ei_x_encode_atom(reply, "expired");
+  ei_x_encode_ulong(reply, stats.expired);
+
+  ei_x_encode_atom(reply, "mismatched");
+  ei_x_encode_ulong(reply, stats.mismatched);
+}
+
+static void encode_points(ei_x_buff* reply, heat_map_kind_t kind, size_t max)
+{
+  heat_map_point_t points[HEAT_MAP_TOP_K] = { 0 };
+  size_t count = heat_map_top(kind, points, max);
+
+  if (count > 0)
+    ei_x_encode_list_header(reply, count);
+
+  for (size_t i = 0; i < count; i++) {
+    ei_x_encode_tuple_header(reply, 5);
+    ei_x_encode_ulong(reply, points[i].device_instance);
+    ei_x_encode_ulong(reply, points[i].object_type);
+    ei_x_encode_ulong(reply, points[i].object_instance);
+    ei_x_encode_ulong(reply, points[i].property);
+    ei_x_encode_ulong(reply, points[i].count);
+  }
+
+  ei_x_encode_empty_list(reply);
+}
+
+static void encode_slabs(ei_x_buff* reply)
+{
+  size_t count = sizeof(SLAB_POOLS) / sizeof(SLAB_POOLS[0]);
+
+  ei_x_encode_map_header(reply, count);
+
+  for (size_t i = 0; i < count; i++) {
+    slab_stats_t stats = { 0 };
+    SLAB_POOLS[i].get_stats(NULL, &stats);
+
+    // %{chunks: n, capacity: n, in_use: n, bytes: n}
+    ei_x_encode_atom(reply, SLAB_POOLS[i].atom);
+    ei_x_encode_map_header(reply, 4);
+    ei_x_encode_atom(reply, "chunks");
+    ei_x_encode_ulong(reply, stats.chunks);
+    ei_x_encode_atom(reply, "capacity");
+    ei_x_encode_ulong(reply, stats.capacity);
+    ei_x_encode_atom(reply, "in_use");
+    ei_x_encode_ulong(reply, stats.in_use);
+    ei_x_encode_atom(reply, "bytes");
+    ei_x_encode_ulong(reply, stats.bytes);
+  }
+}
+
+static void encode_account(ei_x_buff* reply, memory_stats_t* stats)
+{
+  // %{bytes: n, allocations: n, peak_bytes: n}
+  ei_x_encode_map_header(reply, 3);
+  ei_x_encode_atom(reply, "bytes");
+  ei_x_encode_ulong(reply, stats->bytes);
+  ei_x_encode_atom(reply, "allocations");
+  ei_x_encode_ulong(reply, stats->allocations);
+  ei_x_encode_atom(reply, "peak_bytes");
+  ei_x_encode_ulong(reply, stats->peak_bytes);
+}
+
+static void encode_usage(ei_x_buff* reply, object_usage_t* usage)
+{
+  // %{objects: n, bytes: n}
+  ei_x_encode_map_header(reply, 2);
+  ei_x_encode_atom(reply, "objects");
+  ei_x_encode_ulong(reply, usage->objects);
+  ei_x_encode_atom(reply, "bytes");
+  ei_x_encode_ulong(reply, usage->bytes);
+}
+
+static void measure_device(
+  DEVICE_OBJECT_DATA* device,
+  object_usage_t usage[OBJECT_TYPE_COUNT]
+) {
+  if (device == NULL || device->objects == NULL)
+    return;
+
+  for (size_t t = 0; t < OBJECT_TYPE_COUNT; t++) {
+    usage[t].objects =
+      Routed_Object_Count_By_Type(device->objects, OBJECT_TYPES[t].type);
+
+    if (OBJECT_TYPES[t].get_stats) {
+      slab_stats_t stats = { 0 };
+      OBJECT_TYPES[t].get_stats(device, &stats);
+
+      usage[t].bytes = stats.bytes;
+    } else {
+      usage[t].bytes = usage[t].objects * OBJECT_TYPES[t].stack_size;
+    }
+  }
+}
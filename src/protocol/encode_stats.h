@@ -0,0 +1,11 @@
+#ifndef BACNET_ENCODE_STATS_H
+#define BACNET_ENCODE_STATS_H
+
+#include <ei.h>
+
+int encode_stats(ei_x_buff* reply);
+int encode_hot_points(ei_x_buff* reply, uint32_t limit);
+int encode_flight_recorder(ei_x_buff* reply);
+int encode_memory(ei_x_buff* reply);
+
+#endif /* BACNET_ENCODE_STATS_H */
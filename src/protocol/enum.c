@@ -478,3 +478,27 @@ int find_enum_value(const enum_tuple_t* enum_tuples, const char* atom)
 
   return -1;
 }
+
+/**
+ * @brief Finds the string identifier for an integer value.
+ *
+ * The reverse of find_enum_value.
+ *
+ * @param enum_tuples A pointer to an array of structures that pair string
+ *                    identifiers with integer values, terminated by a
+ *                    sentinel structure where the `atom` member is NULL.
+ *
+ * @param value An integer value.
+ *
+ * @return The string identifier of the first entry with the value, or NULL
+ *         if there is none.
+ */
+const char* find_enum_atom(const enum_tuple_t* enum_tuples, int value)
+{
+  for (size_t index = 0; enum_tuples[index].atom != NULL; index++) {
+    if (enum_tuples[index].value == value)
+      return enum_tuples[index].atom;
+  }
+
+  return NULL;
+}
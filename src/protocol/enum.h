@@ -9,5 +9,6 @@ typedef struct {
 extern const enum_tuple_t BACNET_UNIT_ATOMS[];
 
 int find_enum_value(const enum_tuple_t* enum_tuples, const char* atom);
+const char* find_enum_atom(const enum_tuple_t* enum_tuples, int value);
 
 #endif /* BACNET_ENUM_H */
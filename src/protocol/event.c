@@ -20,3 +20,45 @@ int send_command(
 
   return port_send(&reply);
 }
+
+int send_stall(const char* stage, uint32_t elapsed_ms)
+{
+  ei_x_buff event;
+  ei_x_new_with_version(&event);
+  ei_x_encode_tuple_header(&event, 2);
+  ei_x_encode_atom(&event, "$event");
+
+  // {:stall, stage, elapsed_ms}
+  ei_x_encode_tuple_header(&event, 3);
+  ei_x_encode_atom(&event, "stall");
+  ei_x_encode_atom(&event, stage);
+  ei_x_encode_ulong(&event, elapsed_ms);
+
+  int result = port_send(&event);
+  ei_x_free(&event);
+
+  return result;
+}
+
+int send_snapshot_restored(
+  uint32_t records,
+  uint32_t failed,
+  uint32_t elapsed_ms
+) {
+  ei_x_buff event;
+  ei_x_new_with_version(&event);
+  ei_x_encode_tuple_header(&event, 2);
+  ei_x_encode_atom(&event, "$event");
+
+  // {:snapshot_restored, records, failed, elapsed_ms}
+  ei_x_encode_tuple_header(&event, 4);
+  ei_x_encode_atom(&event, "snapshot_restored");
+  ei_x_encode_ulong(&event, records);
+  ei_x_encode_ulong(&event, failed);
+  ei_x_encode_ulong(&event, elapsed_ms);
+
+  int result = port_send(&event);
+  ei_x_free(&event);
+
+  return result;
+}
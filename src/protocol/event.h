@@ -8,4 +8,11 @@ int send_command(
   uint32_t object_instance,
   uint32_t value);
 
+int send_stall(const char* stage, uint32_t elapsed_ms);
+
+int send_snapshot_restored(
+  uint32_t records,
+  uint32_t failed,
+  uint32_t elapsed_ms);
+
 #endif /* BACNET_EVENT_H */
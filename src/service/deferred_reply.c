@@ -0,0 +1,272 @@
+#include <string.h>
+#include <bacnet/bacaddr.h>
+#include <bacnet/bacerror.h>
+#include <bacnet/bacdcode.h>
+
+#include "log.h"
+#include "service/deferred_reply.h"
+#include "service/reply_cache.h"
+#include "timer.h"
+
+/*
+ * A WriteProperty whose outcome is decided by Elixir is parked here while
+ * the object handling it waits. The stack still answers the request as it
+ * returns, and that reply is dropped on its way out; the parked request is
+ * answered later, on behalf of the device it was addressed to, and its
+ * retransmits are ignored in the meantime. Everything here runs with the
+ * stack lock held.
+ */
+
+typedef struct {
+  bool       is_used;
+  uint32_t   generation;
+  int        timer_id;
+  pdu_info_t request;
+  uint8_t    apdu[MAX_APDU];
+} deferred_t;
+
+static deferred_t  deferred[DEFERRED_REPLY_MAX] = { 0 };
+static pdu_info_t* current = NULL;
+static bool        is_parked = false;
+
+static deferred_t* find(int reply_id);
+static void send_reply(deferred_t* entry, uint8_t* apdu, int apdu_len);
+static void timed_out(void* arg);
+
+/**
+ * @brief Marks the start of processing for an inbound PDU.
+ *
+ * @param request The decoded headers of the inbound PDU, or NULL if the PDU
+ *                could not be decoded.
+ */
+void deferred_reply_begin(pdu_info_t* request)
+{
+  current   = request;
+  is_parked = false;
+}
+
+/**
+ * @brief Marks the end of processing for an inbound PDU.
+ */
+void deferred_reply_end(void)
+{
+  current   = NULL;
+  is_parked = false;
+}
+
+/**
+ * @brief Checks if an inbound PDU retransmits a parked request.
+ *
+ * @param request The decoded headers of the inbound PDU.
+ *
+ * @return Returns true if the request is parked and must not be handled.
+ */
+bool deferred_reply_is_pending(pdu_info_t* request)
+{
+  if (request->pdu_type != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
+    return false;
+
+  for (int i = 0; i < DEFERRED_REPLY_MAX; i++) {
+    pdu_info_t* parked = &deferred[i].request;
+
+    bool is_match =
+         deferred[i].is_used
+      && parked->invoke_id == request->invoke_id
+      && parked->service_choice == request->service_choice
+      && bacnet_address_same(&parked->src, &request->src)
+      && bacnet_address_same(&parked->dest, &request->dest);
+
+    if (is_match)
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Checks if an outbound PDU is the stack's reply to a parked request.
+ *
+ * Only the first reply after parking is dropped.
+ *
+ * @param dest The destination address of the PDU.
+ *
+ * @return Returns true if the PDU must not be sent.
+ */
+bool deferred_reply_suppress(BACNET_ADDRESS* dest)
+{
+  if (!is_parked || !bacnet_address_same(dest, &current->src))
+    return false;
+
+  is_parked = false;
+
+  return true;
+}
+
+/**
+ * @brief Parks the WriteProperty request being handled.
+ *
+ * Called by an object's write handler before it returns success. The
+ * request must then be answered with deferred_reply_ack or
+ * deferred_reply_error, or it is answered with a timeout error after
+ * DEFERRED_REPLY_TIMEOUT_MS.
+ *
+ * @return Returns an id for the reply, or -1 if the request can't be
+ *         parked and is answered as the handler returns.
+ */
+int deferred_reply_park(void)
+{
+  bool is_parkable =
+       current != NULL
+    && !is_parked
+    && current->pdu_type == PDU_TYPE_CONFIRMED_SERVICE_REQUEST
+    && current->service_choice == SERVICE_CONFIRMED_WRITE_PROPERTY
+    && !current->segmented
+    && current->apdu_len <= MAX_APDU;
+
+  if (!is_parkable)
+    return -1;
+
+  for (int i = 0; i < DEFERRED_REPLY_MAX; i++) {
+    deferred_t* entry = &deferred[i];
+    if (entry->is_used)
+      continue;
+
+    entry->timer_id =
+      timer_schedule(DEFERRED_REPLY_TIMEOUT_MS, timed_out, entry);
+
+    if (entry->timer_id < 0)
+      return -1;
+
+    memcpy(&entry->request, current, sizeof(entry->request));
+    memcpy(entry->apdu, current->apdu, current->apdu_len);
+
+    entry->request.apdu = entry->apdu;
+    entry->is_used      = true;
+    entry->generation   =
+      (entry->generation + 1) % (INT32_MAX / DEFERRED_REPLY_MAX);
+
+    is_parked = true;
+
+    return (int)(entry->generation * DEFERRED_REPLY_MAX + i);
+  }
+
+  LOG_WARNING("bacnetd: no room to defer a reply, acknowledging it early");
+
+  return -1;
+}
+
+/**
+ * @brief Answers a parked request with a SimpleACK.
+ *
+ * An id of -1, or one already answered, is a no-op.
+ *
+ * @param reply_id The id returned when the request was parked.
+ */
+void deferred_reply_ack(int reply_id)
+{
+  deferred_t* entry = find(reply_id);
+  if (!entry)
+    return;
+
+  uint8_t apdu[MAX_APDU] = { 0 };
+
+  int apdu_len =
+    encode_simple_ack(
+      apdu,
+      entry->request.invoke_id,
+      entry->request.service_choice
+    );
+
+  send_reply(entry, apdu, apdu_len);
+}
+
+/**
+ * @brief Answers a parked request with an Error.
+ *
+ * An id of -1, or one already answered, is a no-op.
+ *
+ * @param reply_id    The id returned when the request was parked.
+ * @param error_class The BACnet error class.
+ * @param error_code  The BACnet error code.
+ */
+void deferred_reply_error(
+  int reply_id,
+  BACNET_ERROR_CLASS error_class,
+  BACNET_ERROR_CODE error_code
+) {
+  deferred_t* entry = find(reply_id);
+  if (!entry)
+    return;
+
+  uint8_t apdu[MAX_APDU] = { 0 };
+
+  int apdu_len =
+    bacerror_encode_apdu(
+      apdu,
+      entry->request.invoke_id,
+      entry->request.service_choice,
+      error_class,
+      error_code
+    );
+
+  send_reply(entry, apdu, apdu_len);
+}
+
+static deferred_t* find(int reply_id)
+{
+  if (reply_id < 0)
+    return NULL;
+
+  deferred_t* entry      = &deferred[reply_id % DEFERRED_REPLY_MAX];
+  uint32_t    generation = (uint32_t)(reply_id / DEFERRED_REPLY_MAX);
+
+  if (!entry->is_used || entry->generation != generation)
+    return NULL;
+
+  return entry;
+}
+
+static void send_reply(deferred_t* entry, uint8_t* apdu, int apdu_len)
+{
+  pdu_info_t* request = &entry->request;
+
+  BACNET_ADDRESS device_address = { 0 };
+  if (request->dest.net > 0 && request->dest.net != BACNET_BROADCAST_NETWORK)
+    memcpy(&device_address, &request->dest, sizeof(device_address));
+
+  timer_cancel(entry->timer_id);
+
+  // cached like any other reply, for a retransmit crossing it
+  reply_cache_begin(request);
+
+  pdu_send_apdu(
+    &request->src,
+    &device_address,
+    request->npdu_data.priority,
+    false,
+    apdu,
+    apdu_len
+  );
+
+  reply_cache_end();
+
+  entry->is_used  = false;
+  entry->timer_id = -1;
+}
+
+static void timed_out(void* arg)
+{
+  deferred_t* entry = arg;
+
+  LOG_WARNING(
+    "bacnetd: deferred reply to invoke ID %u timed out",
+    entry->request.invoke_id
+  );
+
+  entry->timer_id = -1;
+
+  int reply_id =
+    (int)(entry->generation * DEFERRED_REPLY_MAX + (entry - deferred));
+
+  deferred_reply_error(reply_id, ERROR_CLASS_COMMUNICATION, ERROR_CODE_TIMEOUT);
+}
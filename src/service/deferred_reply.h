@@ -0,0 +1,32 @@
+#ifndef BACNET_SERVICE_DEFERRED_REPLY_H
+#define BACNET_SERVICE_DEFERRED_REPLY_H
+
+#include <stdbool.h>
+#include <bacnet/bacdef.h>
+#include <bacnet/bacenum.h>
+
+#include "service/pdu.h"
+
+#ifndef DEFERRED_REPLY_MAX
+#define DEFERRED_REPLY_MAX 16
+#endif
+
+// within the time a client retrying with the default APDU timeout waits
+#ifndef DEFERRED_REPLY_TIMEOUT_MS
+#define DEFERRED_REPLY_TIMEOUT_MS 10000
+#endif
+
+void deferred_reply_begin(pdu_info_t* request);
+void deferred_reply_end(void);
+bool deferred_reply_is_pending(pdu_info_t* request);
+bool deferred_reply_suppress(BACNET_ADDRESS* dest);
+
+int deferred_reply_park(void);
+void deferred_reply_ack(int reply_id);
+
+void deferred_reply_error(
+  int reply_id,
+  BACNET_ERROR_CLASS error_class,
+  BACNET_ERROR_CODE error_code);
+
+#endif /* BACNET_SERVICE_DEFERRED_REPLY_H */
@@ -0,0 +1,355 @@
+#include <stdlib.h>
+#include <string.h>
+#include <bacnet/abort.h>
+#include <bacnet/bacaddr.h>
+#include <bacnet/basic/services.h>
+
+#include "log.h"
+#include "service/ingress.h"
+#include "service/pdu.h"
+#include "timer.h"
+
+// token buckets are kept in thousandths of a token
+#define TOKEN_SCALE 1000
+
+typedef struct {
+  BACNET_ADDRESS src;
+  uint64_t       received_at;
+  uint16_t       pdu_len;
+  uint8_t        pdu[MAX_MPDU];
+} ingress_packet_t;
+
+typedef struct {
+  ingress_packet_t packets[INGRESS_QUEUE_DEPTH];
+  uint32_t         head;
+  uint32_t         count;
+} ingress_queue_t;
+
+// shed requests waiting to be answered with an Abort
+typedef struct {
+  pdu_info_t requests[INGRESS_QUEUE_DEPTH];
+  uint32_t   head;
+  uint32_t   count;
+} ingress_aborts_t;
+
+typedef struct {
+  bool             active;
+  bool             throttled;
+  uint32_t         tokens;
+  uint64_t         refilled_at;
+  uint64_t         last_seen;
+  ingress_talker_t talker;
+} ingress_source_t;
+
+static ingress_queue_t  queues[INGRESS_PRIORITY_COUNT] = { 0 };
+static ingress_source_t sources[INGRESS_MAX_SOURCES] = { 0 };
+static ingress_aborts_t aborts = { 0 };
+static ingress_stats_t  stats = { 0 };
+
+static ingress_priority_t classify(pdu_info_t* info, bool is_decoded);
+static bool is_rate_limited(pdu_info_t* info, bool is_decoded);
+static ingress_source_t* find_source(BACNET_ADDRESS* address, uint64_t now);
+static bool take_token(ingress_source_t* source, uint64_t now);
+static void shed(pdu_info_t* info, bool is_decoded);
+
+/**
+ * @brief Classifies and queues an inbound datagram.
+ *
+ * Requests are charged against a token bucket for their source, and are
+ * shed once it is empty. Confirmed requests that are shed, either because
+ * their source is over its rate or because the queue is full, are answered
+ * with an Abort so that the client does not wait out its APDU timeout. The
+ * Aborts are sent later by ingress_send_aborts.
+ *
+ * @param src     The datalink source address of the datagram.
+ * @param pdu     A pointer to the received NPDU.
+ * @param pdu_len The length of the received NPDU.
+ */
+void ingress_enqueue(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len)
+{
+  uint64_t   now = timer_now_ms();
+  pdu_info_t info = { 0 };
+
+  bool is_decoded = pdu_decode(src, pdu, pdu_len, &info) == 0;
+  stats.received++;
+
+  ingress_source_t* source =
+    find_source(is_decoded ? &info.src : src, now);
+
+  source->talker.packets++;
+  source->talker.bytes += pdu_len;
+
+  if (is_rate_limited(&info, is_decoded) && !take_token(source, now)) {
+    if (!source->throttled) {
+      LOG_WARNING(
+        "bacnetd: rate limiting source after %u packets",
+        source->talker.packets
+      );
+
+      source->throttled = true;
+    }
+
+    source->talker.shed++;
+    stats.shed_rate_limited++;
+    shed(&info, is_decoded);
+    return;
+  }
+
+  ingress_priority_t priority = classify(&info, is_decoded);
+  ingress_queue_t*   queue    = &queues[priority];
+
+  if (queue->count >= INGRESS_QUEUE_DEPTH) {
+    source->talker.shed++;
+    stats.shed_queue_full++;
+    shed(&info, is_decoded);
+    return;
+  }
+
+  uint32_t tail = (queue->head + queue->count) % INGRESS_QUEUE_DEPTH;
+  ingress_packet_t* packet = &queue->packets[tail];
+
+  memcpy(&packet->src, src, sizeof(packet->src));
+  memcpy(&packet->pdu[0], pdu, pdu_len);
+  packet->pdu_len     = pdu_len;
+  packet->received_at = now;
+
+  queue->count++;
+  stats.queue_depth[priority] = queue->count;
+  if (queue->count > stats.queue_high_water[priority])
+    stats.queue_high_water[priority] = queue->count;
+}
+
+/**
+ * @brief Takes the next datagram to dispatch, highest priority first.
+ *
+ * Datagrams that waited longer than the APDU timeout are dropped, since the
+ * client will have retried or given up by then.
+ *
+ * @param src      A pointer to where the datalink source address is stored.
+ * @param pdu      A pointer to where the NPDU is copied.
+ * @param pdu_size The size of the `pdu` buffer.
+ * @param pdu_len  A pointer to where the NPDU length is stored.
+ *
+ * @return Returns true if a datagram was dequeued.
+ */
+bool ingress_dequeue(
+  BACNET_ADDRESS* src,
+  uint8_t* pdu,
+  uint16_t pdu_size,
+  uint16_t* pdu_len
+) {
+  uint64_t now = timer_now_ms();
+
+  for (int priority = 0; priority < INGRESS_PRIORITY_COUNT; priority++) {
+    ingress_queue_t* queue = &queues[priority];
+
+    while (queue->count > 0) {
+      ingress_packet_t* packet = &queue->packets[queue->head];
+
+      queue->head = (queue->head + 1) % INGRESS_QUEUE_DEPTH;
+      queue->count--;
+      stats.queue_depth[priority] = queue->count;
+
+      if (now - packet->received_at > apdu_timeout()) {
+        stats.shed_stale++;
+        continue;
+      }
+
+      if (packet->pdu_len > pdu_size)
+        continue;
+
+      memcpy(src, &packet->src, sizeof(*src));
+      memcpy(pdu, &packet->pdu[0], packet->pdu_len);
+      *pdu_len = packet->pdu_len;
+
+      stats.dispatched++;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Sends the Aborts for confirmed requests that were shed.
+ *
+ * Datagrams are received without the stack lock, so the Aborts are queued
+ * rather than sent as requests are shed. Must be called with the stack lock
+ * held.
+ */
+void ingress_send_aborts(void)
+{
+  while (aborts.count > 0) {
+    pdu_info_t* request = &aborts.requests[aborts.head];
+
+    aborts.head = (aborts.head + 1) % INGRESS_QUEUE_DEPTH;
+    aborts.count--;
+
+    if (pdu_send_abort(request, ABORT_REASON_OUT_OF_RESOURCES) == 0)
+      stats.aborts_sent++;
+  }
+}
+
+/**
+ * @brief Checks if no datagrams are waiting to be dispatched.
+ */
+bool ingress_is_empty(void)
+{
+  for (int priority = 0; priority < INGRESS_PRIORITY_COUNT; priority++) {
+    if (queues[priority].count > 0)
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Copies the ingress counters.
+ *
+ * @param out A pointer to where the counters will be stored.
+ */
+void ingress_get_stats(ingress_stats_t* out)
+{
+  memcpy(out, &stats, sizeof(*out));
+}
+
+static int compare_talkers(const void* a, const void* b)
+{
+  const ingress_talker_t* left  = a;
+  const ingress_talker_t* right = b;
+
+  if (left->packets == right->packets)
+    return 0;
+
+  return left->packets < right->packets ? 1 : -1;
+}
+
+/**
+ * @brief Lists the sources that sent the most datagrams.
+ *
+ * @param talkers     A pointer to where the talkers will be stored.
+ * @param max_talkers The maximum number of talkers to store.
+ *
+ * @return Returns the number of talkers stored, busiest first.
+ */
+int ingress_top_talkers(ingress_talker_t* talkers, int max_talkers)
+{
+  ingress_talker_t all[INGRESS_MAX_SOURCES] = { 0 };
+  int count = 0;
+
+  for (int i = 0; i < INGRESS_MAX_SOURCES; i++) {
+    if (sources[i].active)
+      memcpy(&all[count++], &sources[i].talker, sizeof(all[0]));
+  }
+
+  qsort(all, count, sizeof(all[0]), compare_talkers);
+
+  if (count > max_talkers)
+    count = max_talkers;
+
+  memcpy(talkers, all, count * sizeof(all[0]));
+
+  return count;
+}
+
+static ingress_priority_t classify(pdu_info_t* info, bool is_decoded)
+{
+  if (!is_decoded)
+    return INGRESS_PRIORITY_LOW;
+
+  if (info->pdu_type != PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST)
+    return INGRESS_PRIORITY_HIGH;
+
+  if (info->service_choice == SERVICE_UNCONFIRMED_COV_NOTIFICATION)
+    return INGRESS_PRIORITY_HIGH;
+
+  return INGRESS_PRIORITY_LOW;
+}
+
+static bool is_rate_limited(pdu_info_t* info, bool is_decoded)
+{
+  // replies to our own requests and segment acks are never charged
+  bool is_request =
+       info->pdu_type == PDU_TYPE_CONFIRMED_SERVICE_REQUEST
+    || info->pdu_type == PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+
+  return !is_decoded || is_request;
+}
+
+static ingress_source_t* find_source(BACNET_ADDRESS* address, uint64_t now)
+{
+  ingress_source_t* oldest = &sources[0];
+
+  // sources are never released, so the free slots are all at the end
+  for (int i = 0; i < INGRESS_MAX_SOURCES; i++) {
+    ingress_source_t* source = &sources[i];
+
+    bool is_match =
+         source->active
+      && bacnet_address_same(&source->talker.address, address);
+
+    if (is_match) {
+      source->last_seen = now;
+      return source;
+    }
+
+    if (!source->active || source->last_seen < oldest->last_seen)
+      oldest = source;
+
+    if (!oldest->active)
+      break;
+  }
+
+  memset(oldest, 0, sizeof(*oldest));
+  memcpy(&oldest->talker.address, address, sizeof(oldest->talker.address));
+
+  oldest->active      = true;
+  oldest->tokens      = INGRESS_SOURCE_BURST * TOKEN_SCALE;
+  oldest->refilled_at = now;
+  oldest->last_seen   = now;
+
+  return oldest;
+}
+
+static bool take_token(ingress_source_t* source, uint64_t now)
+{
+  uint64_t refill = (now - source->refilled_at) * INGRESS_SOURCE_RATE;
+  uint64_t tokens = source->tokens + refill;
+
+  if (tokens > INGRESS_SOURCE_BURST * TOKEN_SCALE)
+    tokens = INGRESS_SOURCE_BURST * TOKEN_SCALE;
+
+  // a throttled source is reported again only after its bucket refills
+  if (tokens == INGRESS_SOURCE_BURST * TOKEN_SCALE)
+    source->throttled = false;
+
+  source->tokens      = (uint32_t)tokens;
+  source->refilled_at = now;
+
+  if (source->tokens < TOKEN_SCALE)
+    return false;
+
+  source->tokens -= TOKEN_SCALE;
+
+  return true;
+}
+
+static void shed(pdu_info_t* info, bool is_decoded)
+{
+  bool is_confirmed =
+       is_decoded
+    && info->pdu_type == PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+
+  // the client retries on its own when the Abort can't be queued
+  if (!is_confirmed || aborts.count >= INGRESS_QUEUE_DEPTH)
+    return;
+
+  uint32_t    tail    = (aborts.head + aborts.count) % INGRESS_QUEUE_DEPTH;
+  pdu_info_t* request = &aborts.requests[tail];
+
+  memcpy(request, info, sizeof(*request));
+  request->apdu     = NULL;
+  request->apdu_len = 0;
+
+  aborts.count++;
+}
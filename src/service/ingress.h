@@ -0,0 +1,70 @@
+#ifndef BACNET_SERVICE_INGRESS_H
+#define BACNET_SERVICE_INGRESS_H
+
+#include <bacnet/bacdef.h>
+
+#ifndef INGRESS_QUEUE_DEPTH
+#define INGRESS_QUEUE_DEPTH 64
+#endif
+
+#ifndef INGRESS_MAX_SOURCES
+#define INGRESS_MAX_SOURCES 128
+#endif
+
+// sustained requests per second allowed from a single source
+#ifndef INGRESS_SOURCE_RATE
+#define INGRESS_SOURCE_RATE 100
+#endif
+
+#ifndef INGRESS_SOURCE_BURST
+#define INGRESS_SOURCE_BURST 200
+#endif
+
+// sources reported by get_stats, busiest first
+#ifndef INGRESS_TOP_TALKERS
+#define INGRESS_TOP_TALKERS 8
+#endif
+
+// datagrams read from the socket per event loop iteration
+#ifndef INGRESS_RECEIVE_BATCH
+#define INGRESS_RECEIVE_BATCH 16
+#endif
+
+typedef enum {
+  INGRESS_PRIORITY_HIGH,
+  INGRESS_PRIORITY_LOW,
+  INGRESS_PRIORITY_COUNT,
+} ingress_priority_t;
+
+typedef struct {
+  uint32_t received;
+  uint32_t dispatched;
+  uint32_t shed_rate_limited;
+  uint32_t shed_queue_full;
+  uint32_t shed_stale;
+  uint32_t aborts_sent;
+  uint32_t queue_depth[INGRESS_PRIORITY_COUNT];
+  uint32_t queue_high_water[INGRESS_PRIORITY_COUNT];
+} ingress_stats_t;
+
+typedef struct {
+  BACNET_ADDRESS address;
+  uint32_t       packets;
+  uint32_t       bytes;
+  uint32_t       shed;
+} ingress_talker_t;
+
+void ingress_enqueue(BACNET_ADDRESS* src, uint8_t* pdu, uint16_t pdu_len);
+
+bool ingress_dequeue(
+  BACNET_ADDRESS* src,
+  uint8_t* pdu,
+  uint16_t pdu_size,
+  uint16_t* pdu_len);
+
+void ingress_send_aborts(void);
+bool ingress_is_empty(void);
+void ingress_get_stats(ingress_stats_t* stats);
+int ingress_top_talkers(ingress_talker_t* talkers, int max_talkers);
+
+#endif /* BACNET_SERVICE_INGRESS_H */
@@ -0,0 +1,185 @@
+#include <string.h>
+#include <bacnet/abort.h>
+#include <bacnet/bacenum.h>
+#include <bacnet/datalink/datalink.h>
+
+#include "log.h"
+#include "service/pdu.h"
+
+#define PDU_TYPE_MASK      0xF0
+#define PDU_SEGMENTED_FLAG 0x08
+
+/**
+ * @brief Decodes the network and application headers of an inbound PDU.
+ *
+ * Peeks at the NPDU without dispatching it so the event loop can classify
+ * traffic before handing it to the routing NPDU handler. The APDU pointer in
+ * `info` refers into `pdu`, which must outlive it.
+ *
+ * @param src     The datalink source address of the PDU.
+ * @param pdu     A pointer to the received NPDU.
+ * @param pdu_len The length of the received NPDU.
+ * @param info    A pointer to where the decoded headers will be stored.
+ *
+ * @return Returns 0 if an APDU was decoded, or -1 if the PDU is malformed or
+ *         carries a network layer message.
+ */
+int pdu_decode(
+  BACNET_ADDRESS* src,
+  uint8_t* pdu,
+  uint16_t pdu_len,
+  pdu_info_t* info
+) {
+  memset(info, 0, sizeof(*info));
+  memcpy(&info->src, src, sizeof(info->src));
+
+  int offset =
+    bacnet_npdu_decode(pdu, pdu_len, &info->dest, &info->src, &info->npdu_data);
+
+  bool is_invalid =
+       offset <= 0
+    || offset >= pdu_len
+    || info->npdu_data.network_layer_message;
+
+  if (is_invalid)
+    return -1;
+
+  uint8_t* apdu = &pdu[offset];
+
+  info->apdu      = apdu;
+  info->apdu_len  = pdu_len - offset;
+  info->pdu_type  = apdu[0] & PDU_TYPE_MASK;
+  info->segmented = (apdu[0] & PDU_SEGMENTED_FLAG) != 0;
+
+  switch (info->pdu_type) {
+    case PDU_TYPE_CONFIRMED_SERVICE_REQUEST:
+      if (info->apdu_len < (info->segmented ? 6 : 4))
+        return -1;
+
+      info->invoke_id      = apdu[2];
+      info->service_choice = info->segmented ? apdu[5] : apdu[3];
+      break;
+
+    case PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST:
+      if (info->apdu_len < 2)
+        return -1;
+
+      info->service_choice = apdu[1];
+      break;
+
+    case PDU_TYPE_COMPLEX_ACK:
+      if (info->apdu_len < (info->segmented ? 5 : 3))
+        return -1;
+
+      info->invoke_id      = apdu[1];
+      info->service_choice = info->segmented ? apdu[4] : apdu[2];
+      break;
+
+    case PDU_TYPE_SEGMENT_ACK:
+      if (info->apdu_len < 4)
+        return -1;
+
+      info->invoke_id = apdu[1];
+      break;
+
+    default:
+      if (info->apdu_len < 3)
+        return -1;
+
+      info->invoke_id      = apdu[1];
+      info->service_choice = apdu[2];
+      break;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Checks if a decoded PDU is addressed to a specific (routed) device.
+ *
+ * @param info           The decoded PDU headers.
+ * @param device_address The BACnet address of the device.
+ *
+ * @return Returns true if the PDU destination is the device.
+ */
+bool pdu_is_for_device(pdu_info_t* info, BACNET_ADDRESS* device_address)
+{
+  if (info->dest.net == 0)
+    return device_address->net == 0;
+
+  bool is_same_address =
+       info->dest.net == device_address->net
+    && info->dest.len == device_address->len
+    && memcmp(info->dest.adr, device_address->adr, info->dest.len) == 0;
+
+  return is_same_address;
+}
+
+/**
+ * @brief Encodes an APDU into an NPDU and sends it.
+ *
+ * @param dest            The destination address of the APDU.
+ * @param device_address  The BACnet address of the sending (routed) device.
+ * @param priority        The network priority of the message.
+ * @param expecting_reply Whether a reply is expected to this message.
+ * @param apdu            A pointer to the encoded APDU.
+ * @param apdu_len        The length of the encoded APDU.
+ *
+ * @return Returns 0 on success, or -1 if the PDU could not be sent.
+ */
+int pdu_send_apdu(
+  BACNET_ADDRESS* dest,
+  BACNET_ADDRESS* device_address,
+  uint8_t priority,
+  bool expecting_reply,
+  uint8_t* apdu,
+  size_t apdu_len
+) {
+  uint8_t          pdu[MAX_PDU] = { 0 };
+  BACNET_NPDU_DATA npdu_data    = { 0 };
+
+  npdu_encode_npdu_data(&npdu_data, expecting_reply, priority);
+  int pdu_len = npdu_encode_pdu(&pdu[0], dest, device_address, &npdu_data);
+
+  if (pdu_len + apdu_len > sizeof(pdu))
+    return -1;
+
+  memcpy(&pdu[pdu_len], apdu, apdu_len);
+  pdu_len += apdu_len;
+
+  if (datalink_send_pdu(dest, &npdu_data, &pdu[0], pdu_len) <= 0) {
+    LOG_WARNING("bacnetd: failed to send reply");
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Aborts a confirmed request without dispatching it.
+ *
+ * The Abort is sent on behalf of the device the request was addressed to.
+ *
+ * @param request The decoded headers of the confirmed request.
+ * @param reason  The BACnet abort reason.
+ *
+ * @return Returns 0 on success, or -1 if the Abort could not be sent.
+ */
+int pdu_send_abort(pdu_info_t* request, uint8_t reason)
+{
+  BACNET_ADDRESS device_address = { 0 };
+  if (request->dest.net > 0 && request->dest.net != BACNET_BROADCAST_NETWORK)
+    memcpy(&device_address, &request->dest, sizeof(device_address));
+
+  uint8_t apdu[MAX_APDU] = { 0 };
+  int apdu_len = abort_encode_apdu(&apdu[0], request->invoke_id, reason, true);
+
+  return pdu_send_apdu(
+    &request->src,
+    &device_address,
+    request->npdu_data.priority,
+    false,
+    apdu,
+    apdu_len
+  );
+}
@@ -0,0 +1,37 @@
+#ifndef BACNET_SERVICE_PDU_H
+#define BACNET_SERVICE_PDU_H
+
+#include <bacnet/bacdef.h>
+#include <bacnet/npdu.h>
+
+typedef struct {
+  BACNET_ADDRESS   src;
+  BACNET_ADDRESS   dest;
+  BACNET_NPDU_DATA npdu_data;
+  uint8_t*         apdu;
+  uint16_t         apdu_len;
+  uint8_t          pdu_type;
+  uint8_t          invoke_id;
+  uint8_t          service_choice;
+  bool             segmented;
+} pdu_info_t;
+
+int pdu_decode(
+  BACNET_ADDRESS* src,
+  uint8_t* pdu,
+  uint16_t pdu_len,
+  pdu_info_t* info);
+
+bool pdu_is_for_device(pdu_info_t* info, BACNET_ADDRESS* device_address);
+
+int pdu_send_apdu(
+  BACNET_ADDRESS* dest,
+  BACNET_ADDRESS* device_address,
+  uint8_t priority,
+  bool expecting_reply,
+  uint8_t* apdu,
+  size_t apdu_len);
+
+int pdu_send_abort(pdu_info_t* request, uint8_t reason);
+
+#endif /* BACNET_SERVICE_PDU_H */
@@ -0,0 +1,478 @@
+#include <bacnet/abort.h>
+#include <bacnet/bacdcode.h>
+#include <bacnet/bacerror.h>
+#include <bacnet/reject.h>
+#include <bacnet/rp.h>
+#include <bacnet/rpm.h>
+#include <bacnet/basic/object/device.h>
+
+#include "heat_map.h"
+#include "service/read_property.h"
+#include "service/segment.h"
+
+// object-id context tag plus the opening and closing list-of-results tags
+#define RPM_OBJECT_OVERHEAD   8
+
+// property-id and array-index tags, value tags, or an encoded error
+#define RPM_PROPERTY_OVERHEAD 24
+
+static uint8_t reply_buffer[SEGMENT_MAX_APDU] = { 0 };
+
+static int encode_failure(
+  uint8_t* apdu,
+  uint8_t invoke_id,
+  BACNET_CONFIRMED_SERVICE service,
+  int status,
+  BACNET_ERROR_CLASS error_class,
+  BACNET_ERROR_CODE error_code);
+
+static int encode_properties(uint8_t* apdu, int capacity, BACNET_RPM_DATA* data);
+static int encode_property(uint8_t* apdu, int capacity, BACNET_RPM_DATA* data);
+
+/**
+ * @brief BACnet ReadProperty handler with segmented response support.
+ *
+ * Encodes the property value into a buffer large enough for a segmented
+ * response, so large arrays such as a routed device's Object_List can be
+ * returned in a single transaction.
+ *
+ * @param service_request A pointer to the encoded service request.
+ * @param service_len     The length of the encoded service request.
+ * @param src             The address of the requesting client.
+ * @param service_data    The confirmed service data of the request.
+ */
+void read_property_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data
+) {
+  BACNET_READ_PROPERTY_DATA data = { 0 };
+
+  uint8_t* apdu      = &reply_buffer[0];
+  int      apdu_len  = 0;
+  uint8_t  invoke_id = service_data->invoke_id;
+
+  if (service_data->segmented_message) {
+    apdu_len =
+      abort_encode_apdu(
+        apdu,
+        invoke_id,
+        ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
+        true
+      );
+
+    goto reply;
+  }
+
+  int len = rp_decode_service_request(service_request, service_len, &data);
+  if (len <= 0) {
+    apdu_len =
+      encode_failure(
+        apdu,
+        invoke_id,
+        SERVICE_CONFIRMED_READ_PROPERTY,
+        len == 0 ? BACNET_STATUS_REJECT : len,
+        data.error_class,
+        data.error_code
+      );
+
+    goto reply;
+  }
+
+  bool is_wildcard_device =
+       data.object_type == OBJECT_DEVICE
+    && data.object_instance == BACNET_MAX_INSTANCE;
+
+  if (is_wildcard_device)
+    data.object_instance = Device_Object_Instance_Number();
+
+  heat_map_record(
+    HEAT_MAP_READ,
+    Device_Object_Instance_Number(),
+    data.object_type,
+    data.object_instance,
+    data.object_property
+  );
+
+  apdu_len = rp_ack_encode_apdu_init(apdu, invoke_id, &data);
+
+  // reserve a byte for the closing tag
+  data.application_data     = &apdu[apdu_len];
+  data.application_data_len = sizeof(reply_buffer) - apdu_len - 1;
+
+  len = Device_Read_Property(&data);
+  if (len < 0) {
+    apdu_len =
+      encode_failure(
+        apdu,
+        invoke_id,
+        SERVICE_CONFIRMED_READ_PROPERTY,
+        len,
+        data.error_class,
+        data.error_code
+      );
+
+    goto reply;
+  }
+
+  apdu_len += len;
+  apdu_len += rp_ack_encode_apdu_object_property_end(&apdu[apdu_len]);
+
+reply:
+  segment_send_reply(src, service_data, apdu, apdu_len);
+}
+
+/**
+ * @brief BACnet ReadPropertyMultiple handler with segmented response support.
+ *
+ * Property values are read directly into the reply, which may grow up to
+ * SEGMENT_MAX_APDU bytes before it is handed off for segmentation.
+ *
+ * @param service_request A pointer to the encoded service request.
+ * @param service_len     The length of the encoded service request.
+ * @param src             The address of the requesting client.
+ * @param service_data    The confirmed service data of the request.
+ */
+void read_property_multiple_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data
+) {
+  BACNET_RPM_DATA data = { 0 };
+
+  uint8_t* apdu       = &reply_buffer[0];
+  int      apdu_len   = 0;
+  int      decode_len = 0;
+  int      len        = 0;
+  uint8_t  invoke_id  = service_data->invoke_id;
+
+  if (service_data->segmented_message) {
+    apdu_len =
+      abort_encode_apdu(
+        apdu,
+        invoke_id,
+        ABORT_REASON_SEGMENTATION_NOT_SUPPORTED,
+        true
+      );
+
+    goto reply;
+  }
+
+  apdu_len = rpm_ack_encode_apdu_init(apdu, invoke_id);
+
+  while (decode_len < service_len) {
+    len =
+      rpm_decode_object_id(
+        &service_request[decode_len],
+        service_len - decode_len,
+        &data
+      );
+
+    if (len <= 0)
+      goto decode_failure;
+
+    decode_len += len;
+
+    bool is_wildcard_device =
+         data.object_type == OBJECT_DEVICE
+      && data.object_instance == BACNET_MAX_INSTANCE;
+
+    if (is_wildcard_device)
+      data.object_instance = Device_Object_Instance_Number();
+
+    if (apdu_len + RPM_OBJECT_OVERHEAD > sizeof(reply_buffer))
+      goto overflow;
+
+    apdu_len += rpm_ack_encode_apdu_object_begin(&apdu[apdu_len], &data);
+
+    while (decode_len < service_len) {
+      len =
+        rpm_decode_object_property(
+          &service_request[decode_len],
+          service_len - decode_len,
+          &data
+        );
+
+      if (len <= 0)
+        goto decode_failure;
+
+      decode_len += len;
+
+      // ALL, REQUIRED and OPTIONAL are counted as requested
+      heat_map_record(
+        HEAT_MAP_READ,
+        Device_Object_Instance_Number(),
+        data.object_type,
+        data.object_instance,
+        data.object_property
+      );
+
+      len =
+        encode_properties(
+          &apdu[apdu_len],
+          sizeof(reply_buffer) - apdu_len - RPM_OBJECT_OVERHEAD,
+          &data
+        );
+
+      if (len < 0)
+        goto abort;
+
+      apdu_len += len;
+
+      bool is_end_of_list =
+           decode_len < service_len
+        && decode_is_closing_tag_number(&service_request[decode_len], 1);
+
+      if (is_end_of_list) {
+        decode_len++;
+        break;
+      }
+    }
+
+    apdu_len += rpm_ack_encode_apdu_object_end(&apdu[apdu_len]);
+  }
+
+  goto reply;
+
+decode_failure:
+  apdu_len =
+    encode_failure(
+      apdu,
+      invoke_id,
+      SERVICE_CONFIRMED_READ_PROP_MULTIPLE,
+      len == 0 ? BACNET_STATUS_REJECT : len,
+      data.error_class,
+      data.error_code
+    );
+
+  goto reply;
+
+abort:
+  apdu_len =
+    abort_encode_apdu(
+      apdu,
+      invoke_id,
+      abort_convert_error_code(data.error_code),
+      true
+    );
+
+  goto reply;
+
+overflow:
+  apdu_len =
+    abort_encode_apdu(apdu, invoke_id, ABORT_REASON_BUFFER_OVERFLOW, true);
+
+reply:
+  segment_send_reply(src, service_data, apdu, apdu_len);
+}
+
+static int encode_failure(
+  uint8_t* apdu,
+  uint8_t invoke_id,
+  BACNET_CONFIRMED_SERVICE service,
+  int status,
+  BACNET_ERROR_CLASS error_class,
+  BACNET_ERROR_CODE error_code
+) {
+  switch (status) {
+    case BACNET_STATUS_ABORT:
+      return abort_encode_apdu(
+        apdu,
+        invoke_id,
+        abort_convert_error_code(error_code),
+        true
+      );
+
+    case BACNET_STATUS_REJECT:
+      return reject_encode_apdu(
+        apdu,
+        invoke_id,
+        reject_convert_error_code(error_code)
+      );
+
+    default:
+      return bacerror_encode_apdu(
+        apdu,
+        invoke_id,
+        service,
+        error_class,
+        error_code
+      );
+  }
+}
+
+static unsigned special_property_count(
+  struct special_property_list_t* list,
+  BACNET_PROPERTY_ID special_property
+) {
+  switch (special_property) {
+    case PROP_ALL:
+      return list->Required.count
+        + list->Optional.count
+        + list->Proprietary.count;
+
+    case PROP_REQUIRED:
+      return list->Required.count;
+
+    case PROP_OPTIONAL:
+      return list->Optional.count;
+
+    default:
+      return 0;
+  }
+}
+
+static BACNET_PROPERTY_ID special_property_at(
+  struct special_property_list_t* list,
+  BACNET_PROPERTY_ID special_property,
+  unsigned index
+) {
+  unsigned required = list->Required.count;
+  unsigned optional = list->Optional.count;
+
+  switch (special_property) {
+    case PROP_ALL:
+      if (index < required)
+        return list->Required.pList[index];
+
+      if (index < required + optional)
+        return list->Optional.pList[index - required];
+
+      return list->Proprietary.pList[index - required - optional];
+
+    case PROP_REQUIRED:
+      return list->Required.pList[index];
+
+    default:
+      return list->Optional.pList[index];
+  }
+}
+
+static int encode_property_error(
+  uint8_t* apdu,
+  BACNET_RPM_DATA* data,
+  BACNET_ERROR_CLASS error_class,
+  BACNET_ERROR_CODE error_code
+) {
+  int len =
+    rpm_ack_encode_apdu_object_property(
+      &apdu[0],
+      data->object_property,
+      data->array_index
+    );
+
+  len +=
+    rpm_ack_encode_apdu_object_property_error(
+      &apdu[len],
+      error_class,
+      error_code
+    );
+
+  return len;
+}
+
+static int encode_properties(uint8_t* apdu, int capacity, BACNET_RPM_DATA* data)
+{
+  bool is_special_property =
+       data->object_property == PROP_ALL
+    || data->object_property == PROP_REQUIRED
+    || data->object_property == PROP_OPTIONAL;
+
+  if (!is_special_property)
+    return encode_property(apdu, capacity, data);
+
+  if (capacity < RPM_PROPERTY_OVERHEAD) {
+    data->error_code = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+    return BACNET_STATUS_ABORT;
+  }
+
+  if (data->array_index != BACNET_ARRAY_ALL) {
+    return encode_property_error(
+      apdu,
+      data,
+      ERROR_CLASS_PROPERTY,
+      ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY
+    );
+  }
+
+  if (!Device_Valid_Object_Id(data->object_type, data->object_instance)) {
+    return encode_property_error(
+      apdu,
+      data,
+      ERROR_CLASS_OBJECT,
+      ERROR_CODE_UNKNOWN_OBJECT
+    );
+  }
+
+  struct special_property_list_t list = { 0 };
+  Device_Objects_Property_List(data->object_type, data->object_instance, &list);
+
+  BACNET_PROPERTY_ID special_property = data->object_property;
+  unsigned           count = special_property_count(&list, special_property);
+
+  int apdu_len = 0;
+  for (unsigned i = 0; i < count; i++) {
+    data->object_property = special_property_at(&list, special_property, i);
+
+    int len = encode_property(&apdu[apdu_len], capacity - apdu_len, data);
+    if (len < 0)
+      return len;
+
+    apdu_len += len;
+  }
+
+  return apdu_len;
+}
+
+static int encode_property(uint8_t* apdu, int capacity, BACNET_RPM_DATA* data)
+{
+  if (capacity < RPM_PROPERTY_OVERHEAD) {
+    data->error_code = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+    return BACNET_STATUS_ABORT;
+  }
+
+  int len =
+    rpm_ack_encode_apdu_object_property(
+      &apdu[0],
+      data->object_property,
+      data->array_index
+    );
+
+  // the value is read in place, past the opening tag, to avoid a copy
+  BACNET_READ_PROPERTY_DATA read_data = {
+    .object_type          = data->object_type,
+    .object_instance      = data->object_instance,
+    .object_property      = data->object_property,
+    .array_index          = data->array_index,
+    .application_data     = &apdu[len + 1],
+    .application_data_len = capacity - len - 2,
+    .error_class          = ERROR_CLASS_OBJECT,
+    .error_code           = ERROR_CODE_UNKNOWN_OBJECT,
+  };
+
+  int value_len = Device_Read_Property(&read_data);
+
+  if (value_len == BACNET_STATUS_ABORT) {
+    data->error_code = read_data.error_code;
+    return BACNET_STATUS_ABORT;
+  }
+
+  if (value_len < 0) {
+    len +=
+      rpm_ack_encode_apdu_object_property_error(
+        &apdu[len],
+        read_data.error_class,
+        read_data.error_code
+      );
+
+    return len;
+  }
+
+  len += encode_opening_tag(&apdu[len], 4);
+  len += value_len;
+  len += encode_closing_tag(&apdu[len], 4);
+
+  return len;
+}
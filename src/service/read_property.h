@@ -0,0 +1,18 @@
+#ifndef BACNET_SERVICE_READ_PROPERTY_H
+#define BACNET_SERVICE_READ_PROPERTY_H
+
+#include <bacnet/apdu.h>
+
+void read_property_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data);
+
+void read_property_multiple_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data);
+
+#endif /* BACNET_SERVICE_READ_PROPERTY_H */
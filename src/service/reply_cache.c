@@ -0,0 +1,241 @@
+#include <string.h>
+#include <bacnet/bacaddr.h>
+#include <bacnet/basic/services.h>
+#include <bacnet/datalink/datalink.h>
+
+#include "service/reply_cache.h"
+#include "timer.h"
+
+#define APDU_SERVICE_OFFSET 3
+
+typedef struct {
+  bool             active;
+  uint64_t         expires_at;
+  BACNET_ADDRESS   src;
+  BACNET_ADDRESS   dest;
+  uint8_t          invoke_id;
+  uint8_t          service_choice;
+  uint32_t         request_hash;
+  BACNET_ADDRESS   reply_dest;
+  BACNET_NPDU_DATA reply_npdu_data;
+  uint8_t          reply[MAX_PDU];
+  uint16_t         reply_len;
+} reply_cache_entry_t;
+
+typedef struct {
+  bool       active;
+  pdu_info_t request;
+  uint32_t   request_hash;
+} reply_cache_context_t;
+
+static reply_cache_entry_t   entries[REPLY_CACHE_SIZE] = { 0 };
+static reply_cache_context_t context = { 0 };
+static reply_cache_stats_t   stats = { 0 };
+
+static uint32_t hash_request(pdu_info_t* request);
+static reply_cache_entry_t* find_entry(pdu_info_t* request);
+static reply_cache_entry_t* allocate_entry(uint64_t now);
+
+/**
+ * @brief Marks the start of processing for an inbound PDU.
+ *
+ * While a non-segmented confirmed request is being processed, the reply
+ * sent for it is captured into the cache.
+ *
+ * @param request The decoded headers of the inbound PDU, or NULL if the PDU
+ *                could not be decoded.
+ */
+void reply_cache_begin(pdu_info_t* request)
+{
+  bool is_cacheable =
+       request != NULL
+    && request->pdu_type == PDU_TYPE_CONFIRMED_SERVICE_REQUEST
+    && !request->segmented;
+
+  context.active = is_cacheable;
+  if (!is_cacheable)
+    return;
+
+  memcpy(&context.request, request, sizeof(context.request));
+  context.request_hash = hash_request(request);
+}
+
+/**
+ * @brief Marks the end of processing for an inbound PDU.
+ */
+void reply_cache_end(void)
+{
+  memset(&context, 0, sizeof(context));
+}
+
+/**
+ * @brief Answers a retransmitted confirmed request from the cache.
+ *
+ * A request matches when the source, destination, invoke ID, service and
+ * request payload are identical to one answered within the APDU timeout.
+ *
+ * @param request The decoded headers of the inbound PDU.
+ *
+ * @return Returns true if the cached reply was resent.
+ */
+bool reply_cache_replay(pdu_info_t* request)
+{
+  bool is_cacheable =
+       request->pdu_type == PDU_TYPE_CONFIRMED_SERVICE_REQUEST
+    && !request->segmented;
+
+  if (!is_cacheable)
+    return false;
+
+  reply_cache_entry_t* entry = find_entry(request);
+  if (entry == NULL) {
+    stats.misses++;
+    return false;
+  }
+
+  if (timer_now_ms() >= entry->expires_at) {
+    stats.expired++;
+    stats.misses++;
+    entry->active = false;
+    return false;
+  }
+
+  // the client reused the invoke ID for a different request
+  if (entry->request_hash != hash_request(request)) {
+    stats.mismatched++;
+    stats.misses++;
+    entry->active = false;
+    return false;
+  }
+
+  stats.hits++;
+  datalink_send_pdu(
+    &entry->reply_dest,
+    &entry->reply_npdu_data,
+    entry->reply,
+    entry->reply_len
+  );
+
+  return true;
+}
+
+/**
+ * @brief Captures an outbound PDU if it answers the request being processed.
+ *
+ * Aborts and segmented responses are not cached, so a retransmit of the
+ * request gets processed again.
+ *
+ * @param dest      The destination address of the PDU.
+ * @param npdu_data The network layer data of the PDU.
+ * @param pdu       A pointer to the encoded PDU.
+ * @param pdu_len   The length of the encoded PDU.
+ */
+void reply_cache_capture(
+  BACNET_ADDRESS* dest,
+  BACNET_NPDU_DATA* npdu_data,
+  uint8_t* pdu,
+  unsigned pdu_len
+) {
+  if (!context.active || pdu_len > MAX_PDU)
+    return;
+
+  pdu_info_t reply = { 0 };
+  if (pdu_decode(dest, pdu, (uint16_t)pdu_len, &reply))
+    return;
+
+  bool is_reply_type =
+       reply.pdu_type == PDU_TYPE_SIMPLE_ACK
+    || (reply.pdu_type == PDU_TYPE_COMPLEX_ACK && !reply.segmented)
+    || reply.pdu_type == PDU_TYPE_ERROR
+    || reply.pdu_type == PDU_TYPE_REJECT;
+
+  bool is_reply =
+       is_reply_type
+    && reply.invoke_id == context.request.invoke_id
+    && bacnet_address_same(dest, &context.request.src);
+
+  if (!is_reply)
+    return;
+
+  uint64_t now = timer_now_ms();
+
+  reply_cache_entry_t* entry = find_entry(&context.request);
+  if (entry == NULL)
+    entry = allocate_entry(now);
+
+  memcpy(&entry->src, &context.request.src, sizeof(entry->src));
+  memcpy(&entry->dest, &context.request.dest, sizeof(entry->dest));
+  memcpy(&entry->reply_dest, dest, sizeof(entry->reply_dest));
+  memcpy(&entry->reply_npdu_data, npdu_data, sizeof(entry->reply_npdu_data));
+  memcpy(&entry->reply[0], pdu, pdu_len);
+
+  entry->active         = true;
+  entry->expires_at     = now + apdu_timeout();
+  entry->invoke_id      = context.request.invoke_id;
+  entry->service_choice = context.request.service_choice;
+  entry->request_hash   = context.request_hash;
+  entry->reply_len      = (uint16_t)pdu_len;
+
+  stats.stored++;
+}
+
+/**
+ * @brief Copies the reply cache counters.
+ *
+ * @param out A pointer to where the counters will be stored.
+ */
+void reply_cache_get_stats(reply_cache_stats_t* out)
+{
+  memcpy(out, &stats, sizeof(*out));
+}
+
+static uint32_t hash_request(pdu_info_t* request)
+{
+  // FNV-1a over the service choice and request parameters
+  uint32_t hash = 2166136261u;
+
+  for (uint16_t i = APDU_SERVICE_OFFSET; i < request->apdu_len; i++) {
+    hash ^= request->apdu[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static reply_cache_entry_t* find_entry(pdu_info_t* request)
+{
+  for (int i = 0; i < REPLY_CACHE_SIZE; i++) {
+    reply_cache_entry_t* entry = &entries[i];
+
+    bool is_match =
+         entry->active
+      && entry->invoke_id == request->invoke_id
+      && entry->service_choice == request->service_choice
+      && bacnet_address_same(&entry->src, &request->src)
+      && pdu_is_for_device(request, &entry->dest);
+
+    if (is_match)
+      return entry;
+  }
+
+  return NULL;
+}
+
+static reply_cache_entry_t* allocate_entry(uint64_t now)
+{
+  reply_cache_entry_t* oldest = &entries[0];
+
+  for (int i = 0; i < REPLY_CACHE_SIZE; i++) {
+    reply_cache_entry_t* entry = &entries[i];
+
+    if (!entry->active || entry->expires_at <= now)
+      return entry;
+
+    if (entry->expires_at < oldest->expires_at)
+      oldest = entry;
+  }
+
+  stats.evicted++;
+
+  return oldest;
+}
@@ -0,0 +1,34 @@
+#ifndef BACNET_SERVICE_REPLY_CACHE_H
+#define BACNET_SERVICE_REPLY_CACHE_H
+
+#include <bacnet/bacdef.h>
+#include <bacnet/npdu.h>
+
+#include "service/pdu.h"
+
+#ifndef REPLY_CACHE_SIZE
+#define REPLY_CACHE_SIZE 32
+#endif
+
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t stored;
+  uint32_t evicted;
+  uint32_t expired;
+  uint32_t mismatched;
+} reply_cache_stats_t;
+
+void reply_cache_begin(pdu_info_t* request);
+void reply_cache_end(void);
+bool reply_cache_replay(pdu_info_t* request);
+
+void reply_cache_capture(
+  BACNET_ADDRESS* dest,
+  BACNET_NPDU_DATA* npdu_data,
+  uint8_t* pdu,
+  unsigned pdu_len);
+
+void reply_cache_get_stats(reply_cache_stats_t* stats);
+
+#endif /* BACNET_SERVICE_REPLY_CACHE_H */
@@ -0,0 +1,401 @@
+#include <stdlib.h>
+#include <bacnet/abort.h>
+#include <bacnet/bacaddr.h>
+#include <bacnet/basic/object/device.h>
+#include <bacnet/basic/services.h>
+
+#include "log.h"
+#include "memory.h"
+#include "service/segment.h"
+#include "timer.h"
+
+#define APDU_HEADER_LEN         3
+#define SEGMENT_HEADER_LEN      5
+#define SEGMENT_FLAG_SEGMENTED  0x08
+#define SEGMENT_FLAG_MORE       0x04
+#define SEGMENT_ACK_FLAG_NAK    0x02
+#define MAX_PROPOSED_WINDOW     127
+
+typedef struct {
+  bool           active;
+  BACNET_ADDRESS dest;
+  BACNET_ADDRESS device_address;
+  uint8_t        invoke_id;
+  uint8_t        service_choice;
+  uint8_t        priority;
+  uint8_t*       payload;
+  size_t         payload_len;
+  uint16_t       segment_size;
+  uint16_t       segment_count;
+  uint16_t       window_start;
+  uint8_t        window_size;
+  uint8_t        retries;
+  int            timer_id;
+} segment_transaction_t;
+
+static segment_transaction_t transactions[SEGMENT_MAX_TRANSACTIONS] = { 0 };
+static segment_stats_t       stats = { 0 };
+
+static int send_abort(
+  BACNET_ADDRESS* dest,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data,
+  uint8_t reason);
+
+static segment_transaction_t* find_transaction(pdu_info_t* info);
+static void send_window(segment_transaction_t* transaction);
+static void release_transaction(segment_transaction_t* transaction);
+static void abort_transaction(segment_transaction_t* transaction);
+static void handle_segment_timeout(void* arg);
+
+/**
+ * @brief Sends the reply to a confirmed request, segmenting it if needed.
+ *
+ * Replies that fit within the client's max APDU are sent immediately. A
+ * complex ACK that does not fit is copied into a per-transaction buffer and
+ * transmitted as a windowed segmented response, provided the client accepts
+ * segmented responses and the memory budget allows it. Otherwise the client
+ * is sent an Abort.
+ *
+ * @param dest         The address of the requesting client.
+ * @param service_data The confirmed service data of the request.
+ * @param apdu         A pointer to the fully encoded (unsegmented) reply.
+ * @param apdu_len     The length of the encoded reply.
+ *
+ * @return Returns 0 on success, or -1 if the reply could not be sent.
+ */
+int segment_send_reply(
+  BACNET_ADDRESS* dest,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data,
+  uint8_t* apdu,
+  int apdu_len
+) {
+  BACNET_ADDRESS device_address = { 0 };
+  routed_get_my_address(&device_address);
+
+  if (apdu_len <= 0)
+    return -1;
+
+  int max_apdu = service_data->max_resp;
+  if (max_apdu <= 0 || max_apdu > MAX_APDU)
+    max_apdu = MAX_APDU;
+
+  if (apdu_len <= max_apdu) {
+    return pdu_send_apdu(
+      dest,
+      &device_address,
+      service_data->priority,
+      false,
+      apdu,
+      apdu_len
+    );
+  }
+
+  if ((apdu[0] & 0xF0) != PDU_TYPE_COMPLEX_ACK)
+    return -1;
+
+  if (!service_data->segmented_response_accepted) {
+    stats.rejected++;
+    return send_abort(
+      dest,
+      service_data,
+      ABORT_REASON_SEGMENTATION_NOT_SUPPORTED
+    );
+  }
+
+  size_t payload_len   = apdu_len - APDU_HEADER_LEN;
+  size_t segment_size  = max_apdu - SEGMENT_HEADER_LEN;
+  size_t segment_count = (payload_len + segment_size - 1) / segment_size;
+
+  bool is_too_many_segments =
+       segment_count > SEGMENT_MAX_SEGMENTS
+    || (service_data->max_segs > 0 && segment_count > service_data->max_segs);
+
+  if (is_too_many_segments) {
+    stats.rejected++;
+    return send_abort(dest, service_data, ABORT_REASON_BUFFER_OVERFLOW);
+  }
+
+  segment_transaction_t* transaction = NULL;
+  for (int i = 0; i < SEGMENT_MAX_TRANSACTIONS; i++) {
+    if (!transactions[i].active) {
+      transaction = &transactions[i];
+      break;
+    }
+  }
+
+  bool is_over_budget =
+    stats.memory_in_use + payload_len > SEGMENT_MEMORY_BUDGET;
+
+  if (transaction == NULL || is_over_budget) {
+    LOG_WARNING("bacnetd: segmentation budget exhausted");
+    stats.rejected++;
+    return send_abort(dest, service_data, ABORT_REASON_OUT_OF_RESOURCES);
+  }
+
+  transaction->payload = memory_malloc(MEMORY_SEGMENTS, payload_len);
+  if (transaction->payload == NULL) {
+    stats.rejected++;
+    return send_abort(dest, service_data, ABORT_REASON_OUT_OF_RESOURCES);
+  }
+
+  memcpy(transaction->payload, &apdu[APDU_HEADER_LEN], payload_len);
+  bacnet_address_copy(&transaction->dest, dest);
+  bacnet_address_copy(&transaction->device_address, &device_address);
+
+  transaction->active         = true;
+  transaction->invoke_id      = service_data->invoke_id;
+  transaction->service_choice = apdu[2];
+  transaction->priority       = service_data->priority;
+  transaction->payload_len    = payload_len;
+  transaction->segment_size   = (uint16_t)segment_size;
+  transaction->segment_count  = (uint16_t)segment_count;
+  transaction->window_start   = 0;
+  transaction->window_size    = 1;
+  transaction->retries        = 0;
+  transaction->timer_id       = -1;
+
+  stats.started++;
+  stats.active++;
+  stats.memory_in_use += payload_len;
+  if (stats.memory_in_use > stats.memory_high_water)
+    stats.memory_high_water = stats.memory_in_use;
+
+  send_window(transaction);
+
+  return 0;
+}
+
+/**
+ * @brief Routes inbound PDUs that belong to a segmented transaction.
+ *
+ * Consumes Segment-ACKs and Aborts for active transactions, as well as
+ * retransmitted requests for a response that is still being segmented.
+ *
+ * @param info The decoded headers of an inbound PDU.
+ *
+ * @return Returns true if the PDU was consumed.
+ */
+bool segment_handle_pdu(pdu_info_t* info)
+{
+  segment_transaction_t* transaction = find_transaction(info);
+  if (transaction == NULL)
+    return false;
+
+  switch (info->pdu_type) {
+    case PDU_TYPE_CONFIRMED_SERVICE_REQUEST:
+      return true;
+
+    case PDU_TYPE_ABORT:
+      stats.aborted++;
+      release_transaction(transaction);
+      return true;
+
+    case PDU_TYPE_SEGMENT_ACK:
+      break;
+
+    default:
+      return false;
+  }
+
+  uint8_t sequence_number = info->apdu[2];
+  uint8_t window_size     = info->apdu[3];
+  bool    is_nak          = info->apdu[0] & SEGMENT_ACK_FLAG_NAK;
+
+  int      acked = -1;
+  uint16_t end   = transaction->window_start + transaction->window_size;
+  if (end > transaction->segment_count)
+    end = transaction->segment_count;
+
+  for (uint16_t i = transaction->window_start; i < end; i++) {
+    if ((i & 0xFF) == sequence_number) {
+      acked = i;
+      break;
+    }
+  }
+
+  // duplicate or stale acknowledgement
+  if (acked < 0)
+    return true;
+
+  if (!is_nak && acked == transaction->segment_count - 1) {
+    stats.completed++;
+    release_transaction(transaction);
+    return true;
+  }
+
+  if (window_size < 1) window_size = 1;
+  if (window_size > MAX_PROPOSED_WINDOW) window_size = MAX_PROPOSED_WINDOW;
+
+  transaction->window_start = acked + 1;
+  transaction->window_size  = window_size;
+  transaction->retries      = 0;
+
+  send_window(transaction);
+
+  return true;
+}
+
+/**
+ * @brief Copies the segmentation counters.
+ *
+ * @param out A pointer to where the counters will be stored.
+ */
+void segment_get_stats(segment_stats_t* out)
+{
+  memcpy(out, &stats, sizeof(*out));
+}
+
+static segment_transaction_t* find_transaction(pdu_info_t* info)
+{
+  for (int i = 0; i < SEGMENT_MAX_TRANSACTIONS; i++) {
+    segment_transaction_t* transaction = &transactions[i];
+
+    bool is_match =
+         transaction->active
+      && transaction->invoke_id == info->invoke_id
+      && bacnet_address_same(&transaction->dest, &info->src)
+      && pdu_is_for_device(info, &transaction->device_address);
+
+    if (is_match)
+      return transaction;
+  }
+
+  return NULL;
+}
+
+static void send_window(segment_transaction_t* transaction)
+{
+  uint8_t apdu[MAX_APDU] = { 0 };
+
+  // armed first, since a window sent without a timeout is never retried
+  timer_cancel(transaction->timer_id);
+  transaction->timer_id =
+    timer_schedule(apdu_timeout(), handle_segment_timeout, transaction);
+
+  if (transaction->timer_id < 0) {
+    LOG_WARNING(
+      "bacnetd: no timer for segmented response %u, aborting it",
+      transaction->invoke_id
+    );
+
+    abort_transaction(transaction);
+    return;
+  }
+
+  uint16_t end = transaction->window_start + transaction->window_size;
+  if (end > transaction->segment_count)
+    end = transaction->segment_count;
+
+  for (uint16_t i = transaction->window_start; i < end; i++) {
+    size_t offset = (size_t)i * transaction->segment_size;
+    size_t length = transaction->payload_len - offset;
+    if (length > transaction->segment_size)
+      length = transaction->segment_size;
+
+    bool more_follows = i < transaction->segment_count - 1;
+
+    apdu[0] = PDU_TYPE_COMPLEX_ACK | SEGMENT_FLAG_SEGMENTED;
+    if (more_follows)
+      apdu[0] |= SEGMENT_FLAG_MORE;
+
+    apdu[1] = transaction->invoke_id;
+    apdu[2] = (uint8_t)(i & 0xFF);
+    apdu[3] = SEGMENT_WINDOW_SIZE;
+    apdu[4] = transaction->service_choice;
+    memcpy(&apdu[SEGMENT_HEADER_LEN], &transaction->payload[offset], length);
+
+    pdu_send_apdu(
+      &transaction->dest,
+      &transaction->device_address,
+      transaction->priority,
+      true,
+      apdu,
+      SEGMENT_HEADER_LEN + length
+    );
+
+    stats.segments_sent++;
+  }
+}
+
+static void handle_segment_timeout(void* arg)
+{
+  segment_transaction_t* transaction = arg;
+
+  transaction->timer_id = -1;
+  if (!transaction->active)
+    return;
+
+  if (transaction->retries >= apdu_retries()) {
+    LOG_WARNING(
+      "bacnetd: segmented response %u timed out at segment %u/%u",
+      transaction->invoke_id,
+      transaction->window_start,
+      transaction->segment_count
+    );
+
+    stats.timed_out++;
+    release_transaction(transaction);
+    return;
+  }
+
+  transaction->retries++;
+  send_window(transaction);
+}
+
+static void release_transaction(segment_transaction_t* transaction)
+{
+  timer_cancel(transaction->timer_id);
+
+  stats.active--;
+  stats.memory_in_use -= transaction->payload_len;
+
+  memory_free(MEMORY_SEGMENTS, transaction->payload);
+  memset(transaction, 0, sizeof(*transaction));
+  transaction->timer_id = -1;
+}
+
+static void abort_transaction(segment_transaction_t* transaction)
+{
+  uint8_t apdu[MAX_APDU] = { 0 };
+  int apdu_len =
+    abort_encode_apdu(
+      &apdu[0],
+      transaction->invoke_id,
+      ABORT_REASON_OUT_OF_RESOURCES,
+      true
+    );
+
+  pdu_send_apdu(
+    &transaction->dest,
+    &transaction->device_address,
+    transaction->priority,
+    false,
+    apdu,
+    apdu_len
+  );
+
+  stats.aborted++;
+  release_transaction(transaction);
+}
+
+static int send_abort(
+  BACNET_ADDRESS* dest,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data,
+  uint8_t reason
+) {
+  BACNET_ADDRESS device_address = { 0 };
+  routed_get_my_address(&device_address);
+
+  uint8_t apdu[MAX_APDU] = { 0 };
+  int apdu_len =
+    abort_encode_apdu(&apdu[0], service_data->invoke_id, reason, true);
+
+  return pdu_send_apdu(
+    dest,
+    &device_address,
+    service_data->priority,
+    false,
+    apdu,
+    apdu_len
+  );
+}
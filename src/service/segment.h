@@ -0,0 +1,47 @@
+#ifndef BACNET_SERVICE_SEGMENT_H
+#define BACNET_SERVICE_SEGMENT_H
+
+#include <bacnet/apdu.h>
+
+#include "service/pdu.h"
+
+#ifndef SEGMENT_MAX_APDU
+#define SEGMENT_MAX_APDU (MAX_APDU * 64)
+#endif
+
+#ifndef SEGMENT_MAX_TRANSACTIONS
+#define SEGMENT_MAX_TRANSACTIONS 8
+#endif
+
+#ifndef SEGMENT_MEMORY_BUDGET
+#define SEGMENT_MEMORY_BUDGET (256 * 1024)
+#endif
+
+#ifndef SEGMENT_WINDOW_SIZE
+#define SEGMENT_WINDOW_SIZE 8
+#endif
+
+#define SEGMENT_MAX_SEGMENTS 255
+
+typedef struct {
+  uint32_t started;
+  uint32_t completed;
+  uint32_t timed_out;
+  uint32_t aborted;
+  uint32_t rejected;
+  uint32_t segments_sent;
+  uint32_t active;
+  size_t   memory_in_use;
+  size_t   memory_high_water;
+} segment_stats_t;
+
+int segment_send_reply(
+  BACNET_ADDRESS* dest,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data,
+  uint8_t* apdu,
+  int apdu_len);
+
+bool segment_handle_pdu(pdu_info_t* info);
+void segment_get_stats(segment_stats_t* stats);
+
+#endif /* BACNET_SERVICE_SEGMENT_H */
@@ -0,0 +1,389 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <bacnet/bacaddr.h>
+#include <bacnet/cov.h>
+#include <bacnet/basic/object/device.h>
+#include <bacnet/basic/services.h>
+
+#include "device_index.h"
+#include "heat_map.h"
+#include "log.h"
+#include "service/pdu.h"
+#include "service/subscribe_cov.h"
+#include "stats.h"
+#include "timer.h"
+
+/*
+ * The stack keeps its COV subscriptions private, so they are tracked here as
+ * well, keyed by the routed device they were made on. When an object is
+ * deleted, its subscriptions are cancelled by handing the stack the same
+ * SubscribeCOV cancellation a client would send, and its reply is dropped.
+ *
+ * The stack's COV task only checks the objects of the selected device, so
+ * notifications are sent from here as well, on behalf of the device each
+ * subscription was made on.
+ */
+
+// Present_Value and Status_Flags
+#define COV_VALUE_COUNT 2
+
+typedef struct {
+  bool             is_used;
+  uint32_t         device_instance;
+  BACNET_OBJECT_ID object;
+  BACNET_ADDRESS   subscriber;
+  uint32_t         process_id;
+  bool             is_confirmed;
+  bool             is_send_requested;
+
+  // 0 for a subscription without a lifetime
+  uint64_t expires_ms;
+} subscription_t;
+
+static subscription_t  subscriptions[SUBSCRIBE_COV_MAX_TRACKED] = { 0 };
+static pthread_mutex_t subscriptions_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool     is_cancelling = false;
+static uint8_t         next_invoke_id = 0;
+
+static void track(
+  uint32_t device_instance,
+  BACNET_ADDRESS* subscriber,
+  BACNET_SUBSCRIBE_COV_DATA* data);
+static void cancel(subscription_t* subscription);
+static bool is_active(subscription_t* subscription, uint64_t now);
+static bool select_device(subscription_t* subscription);
+static void notify(subscription_t* subscription, uint64_t now);
+
+/**
+ * @brief BACnet SubscribeCOV handler that counts subscribed points.
+ *
+ * Subscriptions, but not cancellations, are counted in the heat map against
+ * the monitored object's Present_Value. The request is then handled by the
+ * stack.
+ *
+ * @param service_request A pointer to the encoded service request.
+ * @param service_len     The length of the encoded service request.
+ * @param src             The address of the requesting client.
+ * @param service_data    The confirmed service header of the request.
+ */
+void subscribe_cov_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data
+) {
+  BACNET_SUBSCRIBE_COV_DATA data = { 0 };
+
+  int len =
+    cov_subscribe_decode_service_request(service_request, service_len, &data);
+
+  if (len > 0)
+    track(Device_Object_Instance_Number(), src, &data);
+
+  if (len > 0 && !data.cancellationRequest) {
+    heat_map_record(
+      HEAT_MAP_SUBSCRIBE,
+      Device_Object_Instance_Number(),
+      data.monitoredObjectIdentifier.type,
+      data.monitoredObjectIdentifier.instance,
+      PROP_PRESENT_VALUE
+    );
+  }
+
+  handler_cov_subscribe(service_request, service_len, src, service_data);
+}
+
+/**
+ * @brief Cancels every COV subscription to an object.
+ *
+ * Must be called while the object's device is selected and before the
+ * object is deleted, as the stack only accepts cancellations for objects
+ * that exist.
+ *
+ * @param device_instance The instance number of the object's device.
+ * @param type            The object's type.
+ * @param instance        The object's instance number.
+ *
+ * @return Returns the number of subscriptions cancelled.
+ */
+size_t subscribe_cov_cancel_object(
+  uint32_t device_instance,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance
+) {
+  size_t   cancelled = 0;
+  uint64_t now       = timer_now_ms();
+
+  pthread_mutex_lock(&subscriptions_lock);
+
+  for (size_t i = 0; i < SUBSCRIBE_COV_MAX_TRACKED; i++) {
+    subscription_t* subscription = &subscriptions[i];
+
+    bool is_match =
+         subscription->is_used
+      && subscription->device_instance == device_instance
+      && subscription->object.type == type
+      && subscription->object.instance == instance;
+
+    if (!is_match)
+      continue;
+
+    bool is_expired =
+         subscription->expires_ms != 0
+      && subscription->expires_ms <= now;
+
+    if (!is_expired) {
+      cancel(subscription);
+      cancelled++;
+    }
+
+    subscription->is_used = false;
+  }
+
+  pthread_mutex_unlock(&subscriptions_lock);
+
+  return cancelled;
+}
+
+/**
+ * @brief Forgets the COV subscriptions made on a device.
+ *
+ * Used once the device's objects, and with them the stack's subscriptions,
+ * have been deleted.
+ *
+ * @param device_instance The instance number of the device.
+ */
+void subscribe_cov_forget_device(uint32_t device_instance)
+{
+  pthread_mutex_lock(&subscriptions_lock);
+
+  for (size_t i = 0; i < SUBSCRIBE_COV_MAX_TRACKED; i++) {
+    if (subscriptions[i].device_instance == device_instance)
+      subscriptions[i].is_used = false;
+  }
+
+  pthread_mutex_unlock(&subscriptions_lock);
+}
+
+/**
+ * @brief Sends the COV notifications that are due.
+ *
+ * A subscription is notified once after it is made, and whenever the
+ * Changed flag of its object is set. The flags are cleared once every
+ * subscription has been checked, so that all subscribers of an object are
+ * notified. Must be called with the stack lock held. Confirmed
+ * notifications are sent once, and are not retried.
+ */
+void subscribe_cov_task(void)
+{
+  bool     is_changed[SUBSCRIBE_COV_MAX_TRACKED] = { 0 };
+  uint64_t now = timer_now_ms();
+
+  pthread_mutex_lock(&subscriptions_lock);
+
+  for (size_t i = 0; i < SUBSCRIBE_COV_MAX_TRACKED; i++) {
+    subscription_t* subscription = &subscriptions[i];
+
+    if (!is_active(subscription, now) || !select_device(subscription))
+      continue;
+
+    is_changed[i] =
+      Device_COV(subscription->object.type, subscription->object.instance);
+  }
+
+  for (size_t i = 0; i < SUBSCRIBE_COV_MAX_TRACKED; i++) {
+    subscription_t* subscription = &subscriptions[i];
+
+    bool is_due = is_changed[i] || subscription->is_send_requested;
+    if (!is_due || !is_active(subscription, now))
+      continue;
+
+    if (select_device(subscription))
+      notify(subscription, now);
+
+    subscription->is_send_requested = false;
+  }
+
+  for (size_t i = 0; i < SUBSCRIBE_COV_MAX_TRACKED; i++) {
+    BACNET_OBJECT_ID* object = &subscriptions[i].object;
+
+    if (is_changed[i] && select_device(&subscriptions[i]))
+      Device_COV_Clear(object->type, object->instance);
+  }
+
+  Get_Routed_Device_Object(0);
+
+  pthread_mutex_unlock(&subscriptions_lock);
+}
+
+/**
+ * @brief Whether a cancellation issued by bacnetd is being handled.
+ *
+ * The stack's reply to such a cancellation has no client to go to, and is
+ * not sent.
+ */
+bool subscribe_cov_is_cancelling(void)
+{
+  return atomic_load(&is_cancelling);
+}
+
+static bool is_same(
+  subscription_t* subscription,
+  uint32_t device_instance,
+  BACNET_ADDRESS* subscriber,
+  BACNET_SUBSCRIBE_COV_DATA* data
+) {
+  return
+       subscription->is_used
+    && subscription->device_instance == device_instance
+    && subscription->process_id == data->subscriberProcessIdentifier
+    && subscription->object.type == data->monitoredObjectIdentifier.type
+    && subscription->object.instance == data->monitoredObjectIdentifier.instance
+    && bacnet_address_same(&subscription->subscriber, subscriber);
+}
+
+static void track(
+  uint32_t device_instance,
+  BACNET_ADDRESS* subscriber,
+  BACNET_SUBSCRIBE_COV_DATA* data
+) {
+  uint64_t        now  = timer_now_ms();
+  subscription_t* slot = NULL;
+
+  pthread_mutex_lock(&subscriptions_lock);
+
+  for (size_t i = 0; i < SUBSCRIBE_COV_MAX_TRACKED; i++) {
+    subscription_t* subscription = &subscriptions[i];
+
+    if (is_same(subscription, device_instance, subscriber, data)) {
+      slot = subscription;
+      break;
+    }
+
+    bool is_free =
+         !subscription->is_used
+      || (subscription->expires_ms != 0 && subscription->expires_ms <= now);
+
+    if (is_free && !slot)
+      slot = subscription;
+  }
+
+  if (data->cancellationRequest) {
+    if (slot && is_same(slot, device_instance, subscriber, data))
+      slot->is_used = false;
+  } else if (!slot) {
+    LOG_WARNING("bacnetd: too many COV subscriptions to track");
+  } else {
+    slot->is_used           = true;
+    slot->device_instance   = device_instance;
+    slot->object            = data->monitoredObjectIdentifier;
+    slot->process_id        = data->subscriberProcessIdentifier;
+    slot->is_confirmed      = data->issueConfirmedNotifications;
+    slot->is_send_requested = true;
+    slot->expires_ms        =
+      data->lifetime ? now + (uint64_t)data->lifetime * 1000 : 0;
+
+    bacnet_address_copy(&slot->subscriber, subscriber);
+  }
+
+  pthread_mutex_unlock(&subscriptions_lock);
+}
+
+static void cancel(subscription_t* subscription)
+{
+  uint8_t apdu[MAX_APDU] = { 0 };
+
+  BACNET_SUBSCRIBE_COV_DATA     data         = { 0 };
+  BACNET_CONFIRMED_SERVICE_DATA service_data = { 0 };
+
+  data.subscriberProcessIdentifier = subscription->process_id;
+  data.monitoredObjectIdentifier   = subscription->object;
+  data.cancellationRequest         = true;
+
+  int len = cov_subscribe_encode_apdu(apdu, sizeof(apdu), 0, &data);
+
+  // the stack's handler takes the service request, after the 4 byte header
+  if (len <= 4)
+    return;
+
+  atomic_store(&is_cancelling, true);
+  handler_cov_subscribe(
+    &apdu[4],
+    (uint16_t)(len - 4),
+    &subscription->subscriber,
+    &service_data
+  );
+  atomic_store(&is_cancelling, false);
+}
+
+static bool is_active(subscription_t* subscription, uint64_t now)
+{
+  return
+       subscription->is_used
+    && (subscription->expires_ms == 0 || subscription->expires_ms > now);
+}
+
+static bool select_device(subscription_t* subscription)
+{
+  int index = device_index_lookup(subscription->device_instance);
+  if (index < 0)
+    return false;
+
+  Get_Routed_Device_Object(index);
+
+  return true;
+}
+
+static void notify(subscription_t* subscription, uint64_t now)
+{
+  BACNET_PROPERTY_VALUE values[COV_VALUE_COUNT] = { 0 };
+  BACNET_COV_DATA       data                    = { 0 };
+  BACNET_ADDRESS        device_address          = { 0 };
+  uint8_t               apdu[MAX_APDU]          = { 0 };
+  int                   apdu_len                = 0;
+
+  cov_data_value_list_link(&data, values, COV_VALUE_COUNT);
+
+  bool is_encoded =
+    Device_Encode_Value_List(
+      subscription->object.type,
+      subscription->object.instance,
+      values
+    );
+
+  // the object is gone, or doesn't report changes
+  if (!is_encoded)
+    return;
+
+  data.subscriberProcessIdentifier = subscription->process_id;
+  data.initiatingDeviceIdentifier  = subscription->device_instance;
+  data.monitoredObjectIdentifier   = subscription->object;
+  data.timeRemaining               =
+    subscription->expires_ms
+      ? (uint32_t)((subscription->expires_ms - now + 999) / 1000)
+      : 0;
+
+  if (subscription->is_confirmed)
+    apdu_len =
+      ccov_notify_encode_apdu(apdu, sizeof(apdu), next_invoke_id++, &data);
+  else
+    apdu_len = ucov_notify_encode_apdu(apdu, sizeof(apdu), &data);
+
+  if (apdu_len <= 0)
+    return;
+
+  routed_get_my_address(&device_address);
+
+  int sent_ret =
+    pdu_send_apdu(
+      &subscription->subscriber,
+      &device_address,
+      MESSAGE_PRIORITY_NORMAL,
+      subscription->is_confirmed,
+      apdu,
+      apdu_len
+    );
+
+  if (sent_ret == 0)
+    stats_record_cov_notification();
+}
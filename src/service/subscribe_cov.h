@@ -0,0 +1,29 @@
+#ifndef BACNET_SERVICE_SUBSCRIBE_COV_H
+#define BACNET_SERVICE_SUBSCRIBE_COV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <bacnet/apdu.h>
+#include <bacnet/bacenum.h>
+
+// the stack's default limit on COV subscriptions
+#ifndef SUBSCRIBE_COV_MAX_TRACKED
+#define SUBSCRIBE_COV_MAX_TRACKED 128
+#endif
+
+void subscribe_cov_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src,
+  BACNET_CONFIRMED_SERVICE_DATA* service_data);
+
+size_t subscribe_cov_cancel_object(
+  uint32_t device_instance,
+  BACNET_OBJECT_TYPE type,
+  uint32_t instance);
+
+void subscribe_cov_forget_device(uint32_t device_instance);
+void subscribe_cov_task(void);
+bool subscribe_cov_is_cancelling(void);
+
+#endif /* BACNET_SERVICE_SUBSCRIBE_COV_H */
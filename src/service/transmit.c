@@ -0,0 +1,33 @@
+#include "service/deferred_reply.h"
+#include "service/reply_cache.h"
+#include "service/subscribe_cov.h"
+#include "service/transmit.h"
+
+/**
+ * @brief Transmit hook for all outbound PDUs.
+ *
+ * Lets bacnetd observe replies sent by the stack's service handlers before
+ * they are handed to the BACnet/IP datalink. Replies to COV cancellations
+ * issued by bacnetd itself, and the stack's replies to requests whose
+ * reply was deferred, are dropped.
+ *
+ * @param dest      The destination address of the PDU.
+ * @param npdu_data The network layer data of the PDU.
+ * @param pdu       A pointer to the encoded PDU.
+ * @param pdu_len   The length of the encoded PDU.
+ *
+ * @return Returns the number of bytes sent, or a negative value on failure.
+ */
+int __wrap_bip_send_pdu(
+  BACNET_ADDRESS* dest,
+  BACNET_NPDU_DATA* npdu_data,
+  uint8_t* pdu,
+  unsigned pdu_len
+) {
+  if (subscribe_cov_is_cancelling() || deferred_reply_suppress(dest))
+    return (int)pdu_len;
+
+  reply_cache_capture(dest, npdu_data, pdu, pdu_len);
+
+  return __real_bip_send_pdu(dest, npdu_data, pdu, pdu_len);
+}
@@ -0,0 +1,25 @@
+#ifndef BACNET_SERVICE_TRANSMIT_H
+#define BACNET_SERVICE_TRANSMIT_H
+
+#include <bacnet/bacdef.h>
+#include <bacnet/npdu.h>
+
+/*
+ * Every PDU sent by bacnetd, including those sent from inside the stack, is
+ * routed through `__wrap_bip_send_pdu` by linking with
+ * `-Wl,--wrap=bip_send_pdu`.
+ */
+
+int __real_bip_send_pdu(
+  BACNET_ADDRESS* dest,
+  BACNET_NPDU_DATA* npdu_data,
+  uint8_t* pdu,
+  unsigned pdu_len);
+
+int __wrap_bip_send_pdu(
+  BACNET_ADDRESS* dest,
+  BACNET_NPDU_DATA* npdu_data,
+  uint8_t* pdu,
+  unsigned pdu_len);
+
+#endif /* BACNET_SERVICE_TRANSMIT_H */
@@ -0,0 +1,97 @@
+#include <bacnet/bacstr.h>
+#include <bacnet/whohas.h>
+#include <bacnet/basic/object/device.h>
+#include <bacnet/basic/services.h>
+
+#include "device_index.h"
+#include "object/name_index.h"
+#include "service/who_has.h"
+
+static void send_i_have_by_name(
+  device_index_entry_t* device,
+  BACNET_CHARACTER_STRING* name);
+
+static void send_i_have_by_id(
+  device_index_entry_t* device,
+  BACNET_OBJECT_ID* object_id);
+
+/**
+ * @brief BACnet Who-Has handler for the gateway and its routed devices.
+ *
+ * Object names are resolved through each device's name index rather than by
+ * comparing against the name of every object.
+ *
+ * @param service_request A pointer to the encoded service request.
+ * @param service_len     The length of the encoded service request.
+ * @param src             The address of the requesting client.
+ */
+void who_has_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src
+) {
+  BACNET_WHO_HAS_DATA data = { 0 };
+
+  int len = whohas_decode_service_request(service_request, service_len, &data);
+  if (len <= 0)
+    return;
+
+  uint32_t low_limit  = 0;
+  uint32_t high_limit = BACNET_MAX_INSTANCE - 1;
+
+  bool is_limited =
+       data.low_limit >= 0
+    && data.high_limit >= 0;
+
+  if (is_limited) {
+    low_limit  = data.low_limit;
+    high_limit = data.high_limit;
+  }
+
+  device_index_entry_t devices[MAX_NUM_DEVICES] = { 0 };
+  size_t count =
+    device_index_range(low_limit, high_limit, devices, MAX_NUM_DEVICES);
+
+  for (size_t i = 0; i < count; i++) {
+    if (data.is_object_name)
+      send_i_have_by_name(&devices[i], &data.object.name);
+    else
+      send_i_have_by_id(&devices[i], &data.object.identifier);
+  }
+
+  Get_Routed_Device_Object(0);
+}
+
+static void send_i_have_by_name(
+  device_index_entry_t* device,
+  BACNET_CHARACTER_STRING* name
+) {
+  char name_raw[MAX_CHARACTER_STRING_BYTES] = { 0 };
+
+  if (!characterstring_ansi_copy(name_raw, sizeof(name_raw), name))
+    return;
+
+  BACNET_OBJECT_TYPE type     = MAX_BACNET_OBJECT_TYPE;
+  uint32_t           instance = 0;
+
+  if (!name_index_lookup(device->instance, name_raw, &type, &instance))
+    return;
+
+  Get_Routed_Device_Object(device->index);
+  Send_I_Have(device->instance, type, instance, name);
+}
+
+static void send_i_have_by_id(
+  device_index_entry_t* device,
+  BACNET_OBJECT_ID* object_id
+) {
+  BACNET_CHARACTER_STRING name = { 0 };
+
+  Get_Routed_Device_Object(device->index);
+
+  bool is_found =
+    Device_Object_Name_Copy(object_id->type, object_id->instance, &name);
+
+  if (is_found)
+    Send_I_Have(device->instance, object_id->type, object_id->instance, &name);
+}
@@ -0,0 +1,11 @@
+#ifndef BACNET_SERVICE_WHO_HAS_H
+#define BACNET_SERVICE_WHO_HAS_H
+
+#include <bacnet/bacdef.h>
+
+void who_has_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src);
+
+#endif /* BACNET_SERVICE_WHO_HAS_H */
@@ -0,0 +1,212 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <bacnet/whois.h>
+#include <bacnet/basic/object/device.h>
+#include <bacnet/basic/services.h>
+
+#include "device_index.h"
+#include "service/who_is.h"
+#include "timer.h"
+
+#define RATE_PERIOD_MS 1000
+
+typedef struct {
+  uint32_t index;
+  uint32_t instance;
+} i_am_entry_t;
+
+static i_am_entry_t   queue[MAX_NUM_DEVICES] = { 0 };
+static bool           is_queued[MAX_NUM_DEVICES] = { 0 };
+static uint32_t       queue_head = 0;
+static uint32_t       queue_count = 0;
+static uint64_t       window_end = 0;
+static int            timer_id = -1;
+static uint32_t       window_ms = IAM_RESPONSE_WINDOW_MS;
+static uint32_t       burst_size = IAM_BURST_SIZE;
+static uint64_t       rate_period_start = 0;
+static uint32_t       rate_period_count = 0;
+static who_is_stats_t stats = { 0 };
+static uint8_t        transmit_buffer[MAX_PDU] = { 0 };
+
+static void enqueue(uint32_t index, uint32_t instance);
+static void schedule_burst(bool is_first);
+static void send_burst(void* arg);
+static void count_emission(uint64_t now);
+
+/**
+ * @brief Reads the I-Am pacing configuration from the environment.
+ *
+ * `BACNET_IAM_WINDOW_MS` sets the window over which responses are spread,
+ * and `BACNET_IAM_BURST` the number of responses sent back to back.
+ */
+void who_is_init(void)
+{
+  const char* window_raw = getenv("BACNET_IAM_WINDOW_MS");
+  if (window_raw)
+    window_ms = (uint32_t)strtoul(window_raw, NULL, 0);
+
+  const char* burst_raw = getenv("BACNET_IAM_BURST");
+  if (burst_raw)
+    burst_size = (uint32_t)strtoul(burst_raw, NULL, 0);
+
+  if (burst_size == 0)
+    burst_size = 1;
+
+  srand((unsigned)time(NULL));
+}
+
+/**
+ * @brief BACnet Who-Is handler for the gateway and its routed devices.
+ *
+ * Matching devices are found with a range query over the instance-sorted
+ * device index. Rather than answering with one I-Am per device back to back,
+ * they are queued and their I-Am responses are sent in small bursts
+ * spread over the response window, with jitter. A device already waiting
+ * for its I-Am is not queued twice.
+ *
+ * @param service_request A pointer to the encoded service request.
+ * @param service_len     The length of the encoded service request.
+ * @param src             The address of the requesting client.
+ */
+void who_is_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src
+) {
+  int32_t low_limit  = 0;
+  int32_t high_limit = 0;
+
+  int len =
+    whois_decode_service_request(
+      service_request,
+      service_len,
+      &low_limit,
+      &high_limit
+    );
+
+  if (len < 0)
+    return;
+
+  stats.who_is_received++;
+
+  uint64_t now = timer_now_ms();
+  if (queue_count == 0 || window_end < now + window_ms)
+    window_end = now + window_ms;
+
+  // the index holds provisioned devices only, so instance 0 is a real one
+  if (len == 0) {
+    low_limit  = 0;
+    high_limit = BACNET_MAX_INSTANCE - 1;
+  }
+
+  device_index_entry_t matches[MAX_NUM_DEVICES] = { 0 };
+  size_t count =
+    device_index_range(low_limit, high_limit, matches, MAX_NUM_DEVICES);
+
+  for (size_t i = 0; i < count; i++)
+    enqueue(matches[i].index, matches[i].instance);
+
+  schedule_burst(true);
+}
+
+/**
+ * @brief Copies the Who-Is counters.
+ *
+ * @param out A pointer to where the counters will be stored.
+ */
+void who_is_get_stats(who_is_stats_t* out)
+{
+  memcpy(out, &stats, sizeof(*out));
+  out->i_am_pending = queue_count;
+
+  // no emissions in the last full period
+  if (timer_now_ms() - rate_period_start >= 2 * RATE_PERIOD_MS)
+    out->i_am_rate = 0;
+}
+
+static void enqueue(uint32_t index, uint32_t instance)
+{
+  if (is_queued[index]) {
+    stats.i_am_coalesced++;
+    return;
+  }
+
+  uint32_t tail = (queue_head + queue_count) % MAX_NUM_DEVICES;
+
+  queue[tail].index    = index;
+  queue[tail].instance = instance;
+  is_queued[index]     = true;
+  queue_count++;
+}
+
+static void schedule_burst(bool is_first)
+{
+  if (timer_id >= 0 || queue_count == 0)
+    return;
+
+  uint64_t now    = timer_now_ms();
+  uint32_t bursts = (queue_count + burst_size - 1) / burst_size;
+
+  uint32_t remaining = window_end > now ? (uint32_t)(window_end - now) : 0;
+  uint32_t interval  = remaining / bursts;
+
+  // the first burst waits a random part of the interval, later bursts are
+  // jittered around it so that gateways on the same network do not align
+  uint32_t delay =
+    is_first
+      ? rand() % (interval + 1)
+      : interval / 2 + rand() % (interval + 1);
+
+  timer_id = timer_schedule(delay, send_burst, NULL);
+  if (timer_id < 0)
+    send_burst(NULL);
+}
+
+static void send_burst(void* arg)
+{
+  uint64_t now  = timer_now_ms();
+  uint32_t sent = 0;
+
+  timer_id = -1;
+
+  while (sent < burst_size && queue_count > 0) {
+    i_am_entry_t* entry = &queue[queue_head];
+
+    queue_head = (queue_head + 1) % MAX_NUM_DEVICES;
+    queue_count--;
+    is_queued[entry->index] = false;
+
+    // the device was replaced while waiting
+    if (Routed_Device_Index_To_Instance(entry->index) != entry->instance)
+      continue;
+
+    Get_Routed_Device_Object(entry->index);
+    Send_I_Am(&transmit_buffer[0]);
+
+    count_emission(now);
+    sent++;
+  }
+
+  Get_Routed_Device_Object(0);
+
+  schedule_burst(false);
+}
+
+static void count_emission(uint64_t now)
+{
+  stats.i_am_sent++;
+
+  uint64_t elapsed = now - rate_period_start;
+
+  if (elapsed >= RATE_PERIOD_MS) {
+    stats.i_am_rate = (uint32_t)(rate_period_count * 1000 / elapsed);
+    if (stats.i_am_rate > stats.i_am_peak_rate)
+      stats.i_am_peak_rate = stats.i_am_rate;
+
+    rate_period_start = now;
+    rate_period_count = 0;
+  }
+
+  rate_period_count++;
+}
@@ -0,0 +1,34 @@
+#ifndef BACNET_SERVICE_WHO_IS_H
+#define BACNET_SERVICE_WHO_IS_H
+
+#include <bacnet/bacdef.h>
+
+// window over which the I-Am responses to a Who-Is are spread
+#ifndef IAM_RESPONSE_WINDOW_MS
+#define IAM_RESPONSE_WINDOW_MS 500
+#endif
+
+// maximum number of I-Am responses sent back to back
+#ifndef IAM_BURST_SIZE
+#define IAM_BURST_SIZE 8
+#endif
+
+typedef struct {
+  uint32_t who_is_received;
+  uint32_t i_am_sent;
+  uint32_t i_am_coalesced;
+  uint32_t i_am_pending;
+  uint32_t i_am_rate;
+  uint32_t i_am_peak_rate;
+} who_is_stats_t;
+
+void who_is_init(void);
+
+void who_is_handler(
+  uint8_t* service_request,
+  uint16_t service_len,
+  BACNET_ADDRESS* src);
+
+void who_is_get_stats(who_is_stats_t* stats);
+
+#endif /* BACNET_SERVICE_WHO_IS_H */
@@ -0,0 +1,719 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "log.h"
+#include "memory.h"
+#include "snapshot.h"
+#include "stats.h"
+
+#define INITIAL_CAPACITY 256
+
+// records are written in this order, so each one finds what it depends on
+typedef enum {
+  KIND_GATEWAY,
+  KIND_DEVICE,
+  KIND_PROVISION,
+  KIND_DELETE,
+  KIND_OBJECT,
+  KIND_VALUE,
+  KIND_COUNT,
+} entry_kind_t;
+
+typedef struct {
+  entry_kind_t kind;
+  uint32_t     device;
+  uint32_t     object;
+} entry_key_t;
+
+typedef struct {
+  bool        is_used;
+  entry_key_t key;
+  uint32_t    length;
+  uint32_t    capacity;
+  char*       term;
+} snapshot_entry_t;
+
+static snapshot_entry_t* entries = NULL;
+static size_t            capacity = 0;
+static size_t            used = 0;
+static uint32_t          provision_count = 0;
+static uint64_t          generation = 0;
+static uint64_t          written_generation = 0;
+static pthread_mutex_t   table_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t   write_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char            path[PATH_MAX] = { 0 };
+static atomic_bool     is_enabled = false;
+static uint32_t        interval_ms = SNAPSHOT_INTERVAL_MS;
+static pthread_t       writer_thread_id;
+static bool            should_stop = false;
+static pthread_mutex_t stop_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  stop_signal = PTHREAD_COND_INITIALIZER;
+
+static void* writer_loop(void* arg);
+static bool store(entry_key_t* key, const char* term, uint32_t length);
+static void erase(entry_key_t* key);
+static void erase_device(uint32_t device);
+static bool is_provisioned(uint32_t device);
+
+/**
+ * @brief Starts recording the object database, if enabled.
+ *
+ * Snapshots are enabled by setting `BACNET_SNAPSHOT` to the path of the
+ * snapshot file. It is rewritten every `BACNET_SNAPSHOT_INTERVAL_MS` when
+ * anything has changed, and once more on shutdown.
+ *
+ * @return Returns 0 on success or when snapshots are disabled, or -1 if the
+ *         writer thread cannot be created.
+ */
+int snapshot_start(void)
+{
+  const char* path_raw = getenv("BACNET_SNAPSHOT");
+  if (path_raw == NULL || path_raw[0] == '\0')
+    return 0;
+
+  if (strlen(path_raw) + sizeof(".tmp") > sizeof(path))
+    return -1;
+
+  strcpy(path, path_raw);
+
+  const char* interval_raw = getenv("BACNET_SNAPSHOT_INTERVAL_MS");
+  if (interval_raw)
+    interval_ms = (uint32_t)strtoul(interval_raw, NULL, 0);
+
+  if (interval_ms == 0)
+    interval_ms = SNAPSHOT_INTERVAL_MS;
+
+  should_stop = false;
+
+  if (pthread_create(&writer_thread_id, NULL, &writer_loop, NULL) != 0)
+    return -1;
+
+  atomic_store(&is_enabled, true);
+
+  return 0;
+}
+
+/**
+ * @brief Writes a final snapshot and stops the writer thread.
+ */
+void snapshot_stop(void)
+{
+  if (!atomic_load(&is_enabled))
+    return;
+
+  pthread_mutex_lock(&stop_lock);
+  should_stop = true;
+  pthread_cond_signal(&stop_signal);
+  pthread_mutex_unlock(&stop_lock);
+
+  pthread_join(writer_thread_id, NULL);
+
+  if (snapshot_write())
+    LOG_WARNING("bacnetd: failed to write snapshot");
+
+  atomic_store(&is_enabled, false);
+}
+
+/**
+ * @brief Writes the snapshot file, if anything changed since the last one.
+ *
+ * The file is written beside the snapshot and renamed over it, so a crash
+ * mid-write leaves the previous snapshot in place.
+ *
+ * @return Returns 0 on success or when there is nothing to write, or -1 if
+ *         the file cannot be written.
+ */
+int snapshot_write(void)
+{
+  if (!atomic_load(&is_enabled))
+    return 0;
+
+  pthread_mutex_lock(&write_lock);
+  pthread_mutex_lock(&table_lock);
+
+  if (generation == written_generation) {
+    pthread_mutex_unlock(&table_lock);
+    pthread_mutex_unlock(&write_lock);
+    return 0;
+  }
+
+  snapshot_header_t header = { .version = SNAPSHOT_VERSION };
+  size_t            size   = sizeof(header);
+
+  memcpy(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN);
+
+  for (size_t i = 0; i < capacity; i++) {
+    if (entries[i].is_used && entries[i].length > 0) {
+      size += sizeof(snapshot_record_t) + entries[i].length;
+      header.record_count++;
+    }
+  }
+
+  char*    image            = memory_malloc(MEMORY_SNAPSHOT, size);
+  uint64_t image_generation = generation;
+  size_t   offset           = sizeof(header);
+
+  if (image) {
+    memcpy(image, &header, sizeof(header));
+
+    for (entry_kind_t kind = 0; kind < KIND_COUNT; kind++) {
+      for (size_t i = 0; i < capacity; i++) {
+        snapshot_entry_t* entry = &entries[i];
+
+        if (!entry->is_used || entry->length == 0 || entry->key.kind != kind)
+          continue;
+
+        snapshot_record_t record = { .length = entry->length };
+
+        memcpy(image + offset, &record, sizeof(record));
+        memcpy(image + offset + sizeof(record), entry->term, entry->length);
+        offset += sizeof(record) + entry->length;
+      }
+    }
+  }
+
+  pthread_mutex_unlock(&table_lock);
+
+  char temp_path[PATH_MAX] = { 0 };
+  snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+  FILE* file = image ? fopen(temp_path, "wb") : NULL;
+
+  bool is_written =
+       file != NULL
+    && fwrite(image, 1, size, file) == size
+    && fflush(file) == 0
+    && fsync(fileno(file)) == 0;
+
+  if (file)
+    is_written = fclose(file) == 0 && is_written;
+
+  is_written = is_written && rename(temp_path, path) == 0;
+
+  if (is_written)
+    written_generation = image_generation;
+
+  pthread_mutex_unlock(&write_lock);
+  memory_free(MEMORY_SNAPSHOT, image);
+
+  return is_written ? 0 : -1;
+}
+
+static bool is_ok_reply(ei_x_buff* reply)
+{
+  int  index            = 0;
+  int  type             = 0;
+  int  size             = 0;
+  char atom[MAXATOMLEN] = { 0 };
+
+  // either `ok` or `{ok, value}`
+  bool is_ok =
+       ei_get_type(reply->buff, &index, &type, &size) == 0
+    && (   type != ERL_SMALL_TUPLE_EXT
+        || ei_decode_tuple_header(reply->buff, &index, &size) == 0)
+    && ei_decode_atom(reply->buff, &index, atom) == 0
+    && strcmp(atom, "ok") == 0;
+
+  return is_ok;
+}
+
+/**
+ * @brief Restores the object database from the snapshot file.
+ *
+ * The file is mapped and each recorded call is handled in place, in the
+ * order it was written. Must be called before any other call is handled.
+ *
+ * @param handle_request The function that handles a port call.
+ * @param result         A pointer to where the number of calls handled and
+ *                       failed, and the time taken, will be stored.
+ *
+ * @return Returns 0 on success, when snapshots are disabled or when there is
+ *         no snapshot yet, or -1 if the file cannot be read or is not a
+ *         snapshot of this version.
+ */
+int snapshot_restore(
+  handle_request_t handle_request,
+  snapshot_restore_result_t* result
+) {
+  memset(result, 0, sizeof(*result));
+
+  if (!atomic_load(&is_enabled))
+    return 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return errno == ENOENT ? 0 : -1;
+
+  struct stat info = { 0 };
+  char*       image = MAP_FAILED;
+
+  bool is_mapped =
+       fstat(fd, &info) == 0
+    && info.st_size >= (off_t)sizeof(snapshot_header_t)
+    && (image = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0))
+         != MAP_FAILED;
+
+  close(fd);
+
+  if (!is_mapped)
+    return -1;
+
+  snapshot_header_t header = { 0 };
+  memcpy(&header, image, sizeof(header));
+
+  bool is_valid =
+       memcmp(header.magic, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LEN) == 0
+    && header.version == SNAPSHOT_VERSION;
+
+  if (!is_valid) {
+    munmap(image, info.st_size);
+    return -1;
+  }
+
+  uint64_t started_at = stats_now_us();
+  size_t   size       = (size_t)info.st_size;
+  size_t   offset     = sizeof(header);
+
+  for (uint32_t i = 0; i < header.record_count; i++) {
+    snapshot_record_t record = { 0 };
+
+    if (offset + sizeof(record) > size)
+      break;
+
+    memcpy(&record, image + offset, sizeof(record));
+    offset += sizeof(record);
+
+    if (record.length > size - offset)
+      break;
+
+    ei_x_buff reply;
+    ei_x_new(&reply);
+
+    int index = 0;
+    handle_request(image + offset, &index, &reply);
+
+    result->records++;
+    if (!is_ok_reply(&reply))
+      result->failed++;
+
+    ei_x_free(&reply);
+    offset += record.length;
+  }
+
+  result->elapsed_us = stats_now_us() - started_at;
+  munmap(image, info.st_size);
+
+  // the restored calls were recorded again, but match the file already
+  pthread_mutex_lock(&table_lock);
+  written_generation = generation;
+  pthread_mutex_unlock(&table_lock);
+
+  return 0;
+}
+
+static int object_key(
+  entry_key_t* key,
+  entry_kind_t kind,
+  uint32_t device,
+  uint32_t object
+) {
+  key->kind   = kind;
+  key->device = device;
+  key->object = object;
+
+  return 0;
+}
+
+static int call_key(bacnet_call_type_t type, void* call, entry_key_t* key)
+{
+  switch (type) {
+    case CALL_CREATE_GATEWAY: {
+      create_routed_device_t* params = call;
+      return object_key(key, KIND_GATEWAY, params->bacnet_id, 0);
+    }
+
+    case CALL_CREATE_ROUTED_DEVICE: {
+      create_routed_device_t* params = call;
+      return object_key(key, KIND_DEVICE, params->bacnet_id, 0);
+    }
+
+    case CALL_PROVISION_DEVICE: {
+      provision_device_t* params = call;
+      return object_key(key, KIND_PROVISION, params->device.bacnet_id, 0);
+    }
+
+    case CALL_CREATE_ROUTED_ANALOG_INPUT: {
+      create_routed_analog_input_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_OBJECT,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    case CALL_CREATE_ROUTED_MULTISTATE_INPUT: {
+      create_routed_multistate_input_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_OBJECT,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    case CALL_CREATE_ROUTED_COMMAND: {
+      create_routed_command_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_OBJECT,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    case CALL_CREATE_CHARACTERSTRING_VALUE: {
+      create_characterstring_value_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_OBJECT,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    case CALL_CREATE_BINARY_INPUT: {
+      create_binary_input_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_OBJECT,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    case CALL_SET_ROUTED_ANALOG_INPUT_VALUE: {
+      set_routed_analog_input_value_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_VALUE,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    case CALL_SET_ROUTED_MULTISTATE_INPUT_VALUE: {
+      set_routed_multistate_input_value_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_VALUE,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    case CALL_SET_BINARY_INPUT_VALUE: {
+      set_binary_input_value_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_VALUE,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    // a Command has no other present value to record
+    case CALL_SET_COMMAND_ACTIONS: {
+      set_command_actions_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_VALUE,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    case CALL_DELETE_OBJECT: {
+      delete_object_t* params = call;
+      return
+        object_key(
+          key,
+          KIND_DELETE,
+          params->device_bacnet_id,
+          params->object_bacnet_id
+        );
+    }
+
+    case CALL_DELETE_ROUTED_DEVICE: {
+      delete_routed_device_t* params = call;
+      return object_key(key, KIND_DEVICE, params->bacnet_id, 0);
+    }
+
+    default:
+      return -1;
+  }
+}
+
+/**
+ * @brief Records a call that succeeded, if it changes the object database.
+ *
+ * Only the latest call is kept for each device, object and present value,
+ * so the snapshot stays proportional to the database rather than to its
+ * history. Deleting something drops the calls that created it, and is only
+ * recorded itself when the object was possibly created by a provision.
+ *
+ * @param type   The call type.
+ * @param call   A pointer to the decoded call.
+ * @param buffer A pointer to the buffer holding the encoded call.
+ * @param start  The index of the call in the buffer.
+ */
+void snapshot_record(
+  bacnet_call_type_t type,
+  void* call,
+  char* buffer,
+  int start
+) {
+  if (!atomic_load_explicit(&is_enabled, memory_order_relaxed))
+    return;
+
+  entry_key_t key = { 0 };
+  if (call_key(type, call, &key))
+    return;
+
+  // decoders may leave trailing terms unread, so the call is measured
+  int end = start;
+  if (ei_skip_term(buffer, &end))
+    return;
+
+  pthread_mutex_lock(&table_lock);
+
+  if (type == CALL_DELETE_ROUTED_DEVICE) {
+    erase_device(key.device);
+    generation++;
+    goto unlock;
+  }
+
+  if (type == CALL_DELETE_OBJECT) {
+    entry_key_t object = { KIND_OBJECT, key.device, key.object };
+    entry_key_t value  = { KIND_VALUE, key.device, key.object };
+
+    erase(&object);
+    erase(&value);
+    generation++;
+
+    if (!is_provisioned(key.device))
+      goto unlock;
+  }
+
+  // every provision is kept, as each may add to the same device
+  if (key.kind == KIND_PROVISION) {
+    provision_device_t* params = call;
+    key.object = provision_count++;
+
+    // objects provisioned again are no longer deleted
+    for (size_t i = 0; i < params->object_count; i++) {
+      entry_key_t deleted = {
+        KIND_DELETE,
+        key.device,
+        params->objects[i].object_bacnet_id
+      };
+
+      erase(&deleted);
+    }
+  }
+
+  if (store(&key, buffer + start, (uint32_t)(end - start)))
+    generation++;
+  else
+    LOG_WARNING("bacnetd: snapshot is missing a call, out of memory");
+
+unlock:
+  pthread_mutex_unlock(&table_lock);
+}
+
+static uint32_t hash_key(entry_key_t* key)
+{
+  uint32_t hash = 2166136261u;
+  uint32_t words[3] = { key->kind, key->device, key->object };
+
+  for (int i = 0; i < 3; i++) {
+    hash ^= words[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static snapshot_entry_t* find_slot(entry_key_t* key)
+{
+  uint32_t hash = hash_key(key);
+
+  for (size_t i = 0; i < capacity; i++) {
+    snapshot_entry_t* entry = &entries[(hash + i) & (capacity - 1)];
+
+    bool is_match =
+         !entry->is_used
+      || (   entry->key.kind == key->kind
+          && entry->key.device == key->device
+          && entry->key.object == key->object);
+
+    if (is_match)
+      return entry;
+  }
+
+  return NULL;
+}
+
+static bool resize(size_t new_capacity)
+{
+  snapshot_entry_t* old_entries  = entries;
+  size_t            old_capacity = capacity;
+
+  snapshot_entry_t* new_entries =
+    memory_calloc(MEMORY_SNAPSHOT, new_capacity, sizeof(snapshot_entry_t));
+
+  if (!new_entries)
+    return false;
+
+  entries  = new_entries;
+  capacity = new_capacity;
+  used     = 0;
+
+  // erased entries are only kept until now, so that probing passes them
+  for (size_t i = 0; i < old_capacity; i++) {
+    snapshot_entry_t* entry = &old_entries[i];
+
+    if (!entry->is_used)
+      continue;
+
+    if (entry->length == 0) {
+      memory_free(MEMORY_SNAPSHOT, entry->term);
+      continue;
+    }
+
+    *find_slot(&entry->key) = *entry;
+    used++;
+  }
+
+  memory_free(MEMORY_SNAPSHOT, old_entries);
+
+  return true;
+}
+
+static bool store(entry_key_t* key, const char* term, uint32_t length)
+{
+  // keep the load factor under 3/4
+  if ((used + 1) * 4 > capacity * 3) {
+    size_t new_capacity = capacity ? capacity * 2 : INITIAL_CAPACITY;
+    if (!resize(new_capacity))
+      return false;
+  }
+
+  snapshot_entry_t* entry = find_slot(key);
+
+  if (!entry->is_used) {
+    entry->is_used = true;
+    entry->key     = *key;
+    used++;
+  }
+
+  if (entry->capacity < length) {
+    char* grown = memory_realloc(MEMORY_SNAPSHOT, entry->term, length);
+    if (grown == NULL)
+      return false;
+
+    entry->term     = grown;
+    entry->capacity = length;
+  }
+
+  memcpy(entry->term, term, length);
+  entry->length = length;
+
+  return true;
+}
+
+static void erase(entry_key_t* key)
+{
+  snapshot_entry_t* entry = capacity ? find_slot(key) : NULL;
+
+  if (entry && entry->is_used)
+    entry->length = 0;
+}
+
+static void erase_device(uint32_t device)
+{
+  for (size_t i = 0; i < capacity; i++) {
+    if (entries[i].is_used && entries[i].key.device == device)
+      entries[i].length = 0;
+  }
+}
+
+static bool is_provisioned(uint32_t device)
+{
+  for (size_t i = 0; i < capacity; i++) {
+    bool is_match =
+         entries[i].is_used
+      && entries[i].length > 0
+      && entries[i].key.kind == KIND_PROVISION
+      && entries[i].key.device == device;
+
+    if (is_match)
+      return true;
+  }
+
+  return false;
+}
+
+static void* writer_loop(void* arg)
+{
+  pthread_mutex_lock(&stop_lock);
+
+  while (!should_stop) {
+    struct timespec deadline = { 0 };
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    deadline.tv_sec  += interval_ms / 1000;
+    deadline.tv_nsec += (long)(interval_ms % 1000) * 1000000;
+
+    if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_cond_timedwait(&stop_signal, &stop_lock, &deadline);
+
+    if (should_stop)
+      break;
+
+    pthread_mutex_unlock(&stop_lock);
+
+    if (snapshot_write())
+      LOG_WARNING("bacnetd: failed to write snapshot");
+
+    pthread_mutex_lock(&stop_lock);
+  }
+
+  pthread_mutex_unlock(&stop_lock);
+  pthread_exit(NULL);
+}
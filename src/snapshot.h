@@ -0,0 +1,57 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+
+#include "port.h"
+#include "protocol/decode_call.h"
+
+#ifndef SNAPSHOT_INTERVAL_MS
+#define SNAPSHOT_INTERVAL_MS 30000
+#endif
+
+#define SNAPSHOT_MAGIC     "BNSNAP\r\n"
+#define SNAPSHOT_MAGIC_LEN 8
+#define SNAPSHOT_VERSION   1
+
+/*
+ * A snapshot file is a snapshot_header_t followed by `record_count`
+ * records, each a snapshot_record_t header and `length` bytes holding the
+ * port call that created or last updated something, in the external term
+ * format without a version byte. Records are ordered so that they can be
+ * handled front to back: the gateway, then devices and their provisions,
+ * then deletions of provisioned objects, then objects, then present values.
+ * Integers are in host byte order.
+ */
+
+typedef struct __attribute__((packed)) {
+  char     magic[SNAPSHOT_MAGIC_LEN];
+  uint32_t version;
+  uint32_t record_count;
+} snapshot_header_t;
+
+typedef struct __attribute__((packed)) {
+  uint32_t length;
+} snapshot_record_t;
+
+typedef struct {
+  uint32_t records;
+  uint32_t failed;
+  uint64_t elapsed_us;
+} snapshot_restore_result_t;
+
+int snapshot_start(void);
+void snapshot_stop(void);
+int snapshot_write(void);
+
+int snapshot_restore(
+  handle_request_t handle_request,
+  snapshot_restore_result_t* result);
+
+void snapshot_record(
+  bacnet_call_type_t type,
+  void* call,
+  char* buffer,
+  int start);
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,306 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <bacnet/bacenum.h>
+
+#include "stats.h"
+
+typedef atomic_uint_fast64_t counter_t;
+
+typedef struct {
+  counter_t count;
+  counter_t total_us;
+  counter_t max_us;
+  counter_t buckets[STATS_LATENCY_BUCKETS];
+} histogram_t;
+
+// written only by the thread that owns it, read by stats_collect
+typedef struct {
+  counter_t   services[STATS_SERVICE_COUNT];
+  counter_t   calls[STATS_CALL_TYPES];
+  counter_t   calls_failed[STATS_CALL_TYPES];
+  counter_t   devices[MAX_NUM_DEVICES];
+  counter_t   command_timeouts;
+  counter_t   cov_notifications;
+  histogram_t apdu_latency;
+  histogram_t call_latency;
+  histogram_t command_latency;
+} stats_block_t;
+
+static stats_block_t*        blocks[STATS_MAX_THREADS] = { 0 };
+static int                   block_count = 0;
+static stats_block_t         shared_block = { 0 };
+static pthread_mutex_t       blocks_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local stats_block_t* thread_block = NULL;
+
+static stats_block_t* get_block(void);
+static void add(counter_t* counter, uint64_t value);
+static uint64_t load(counter_t* counter);
+static void record_latency(histogram_t* histogram, uint64_t elapsed_us);
+static void merge_histogram(stats_histogram_t* out, histogram_t* histogram);
+
+/**
+ * @brief Returns a monotonic timestamp in microseconds.
+ */
+uint64_t stats_now_us(void)
+{
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Maps a request to the service it is counted under.
+ *
+ * @param pdu_type       The APDU type of the request.
+ * @param service_choice The service choice of the request.
+ *
+ * @return Returns the service counter for the request.
+ */
+stats_service_t stats_service_of(uint8_t pdu_type, uint8_t service_choice)
+{
+  if (pdu_type == PDU_TYPE_CONFIRMED_SERVICE_REQUEST) {
+    switch (service_choice) {
+      case SERVICE_CONFIRMED_READ_PROPERTY:
+        return STATS_SERVICE_READ_PROPERTY;
+
+      case SERVICE_CONFIRMED_READ_PROP_MULTIPLE:
+        return STATS_SERVICE_READ_PROPERTY_MULTIPLE;
+
+      case SERVICE_CONFIRMED_WRITE_PROPERTY:
+        return STATS_SERVICE_WRITE_PROPERTY;
+
+      case SERVICE_CONFIRMED_WRITE_PROP_MULTIPLE:
+        return STATS_SERVICE_WRITE_PROPERTY_MULTIPLE;
+
+      case SERVICE_CONFIRMED_SUBSCRIBE_COV:
+        return STATS_SERVICE_SUBSCRIBE_COV;
+    }
+  }
+
+  if (pdu_type == PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST) {
+    switch (service_choice) {
+      case SERVICE_UNCONFIRMED_WHO_IS:
+        return STATS_SERVICE_WHO_IS;
+
+      case SERVICE_UNCONFIRMED_WHO_HAS:
+        return STATS_SERVICE_WHO_HAS;
+    }
+  }
+
+  return STATS_SERVICE_OTHER;
+}
+
+/**
+ * @brief Records the handling of an inbound APDU.
+ *
+ * Counters are kept per thread, so recording never contends with other
+ * threads or with readers.
+ *
+ * @param service      The service the APDU is counted under.
+ * @param device_index The routed device table index the APDU was addressed
+ *                     to, or -1 if it was not addressed to a single device.
+ * @param elapsed_us   The time spent handling the APDU.
+ */
+void stats_record_apdu(
+  stats_service_t service,
+  int device_index,
+  uint64_t elapsed_us
+) {
+  stats_block_t* block = get_block();
+
+  add(&block->services[service], 1);
+
+  if (device_index >= 0 && device_index < MAX_NUM_DEVICES)
+    add(&block->devices[device_index], 1);
+
+  record_latency(&block->apdu_latency, elapsed_us);
+}
+
+/**
+ * @brief Records the handling of a port call.
+ *
+ * @param type       The call type.
+ * @param is_failed  Whether the call was answered with an error.
+ * @param elapsed_us The time spent handling the call.
+ */
+void stats_record_call(unsigned type, bool is_failed, uint64_t elapsed_us)
+{
+  stats_block_t* block = get_block();
+
+  if (type < STATS_CALL_TYPES) {
+    add(&block->calls[type], 1);
+
+    if (is_failed)
+      add(&block->calls_failed[type], 1);
+  }
+
+  record_latency(&block->call_latency, elapsed_us);
+}
+
+/**
+ * @brief Records a command sent to Elixir being completed.
+ *
+ * @param elapsed_us The time from the command being sent to its status
+ *                   being set.
+ */
+void stats_record_command(uint64_t elapsed_us)
+{
+  record_latency(&get_block()->command_latency, elapsed_us);
+}
+
+/**
+ * @brief Records a command sent to Elixir failing for want of a status.
+ */
+void stats_record_command_timeout(void)
+{
+  add(&get_block()->command_timeouts, 1);
+}
+
+/**
+ * @brief Records a COV notification sent to a subscriber.
+ */
+void stats_record_cov_notification(void)
+{
+  add(&get_block()->cov_notifications, 1);
+}
+
+/**
+ * @brief Merges the counters of every thread.
+ *
+ * @param snapshot A pointer to where the merged counters will be stored.
+ */
+void stats_collect(stats_snapshot_t* snapshot)
+{
+  memset(snapshot, 0, sizeof(*snapshot));
+
+  pthread_mutex_lock(&blocks_lock);
+
+  for (int i = 0; i <= block_count; i++) {
+    stats_block_t* block = i < block_count ? blocks[i] : &shared_block;
+
+    for (int s = 0; s < STATS_SERVICE_COUNT; s++)
+      snapshot->services[s] += load(&block->services[s]);
+
+    for (int c = 0; c < STATS_CALL_TYPES; c++) {
+      snapshot->calls[c] += load(&block->calls[c]);
+      snapshot->calls_failed[c] += load(&block->calls_failed[c]);
+    }
+
+    for (int d = 0; d < MAX_NUM_DEVICES; d++)
+      snapshot->devices[d] += load(&block->devices[d]);
+
+    snapshot->command_timeouts  += load(&block->command_timeouts);
+    snapshot->cov_notifications += load(&block->cov_notifications);
+
+    merge_histogram(&snapshot->apdu_latency, &block->apdu_latency);
+    merge_histogram(&snapshot->call_latency, &block->call_latency);
+    merge_histogram(&snapshot->command_latency, &block->command_latency);
+  }
+
+  pthread_mutex_unlock(&blocks_lock);
+}
+
+/**
+ * @brief Returns the exclusive upper limit of a latency bucket.
+ *
+ * Bucket 0 holds latencies under 1 us and bucket n those from 2^(n-1) us up
+ * to 2^n us. The last bucket has no upper limit, and 0 is returned for it.
+ *
+ * @param bucket The bucket number.
+ */
+uint64_t stats_bucket_limit_us(int bucket)
+{
+  if (bucket >= STATS_LATENCY_BUCKETS - 1)
+    return 0;
+
+  return (uint64_t)1 << bucket;
+}
+
+static stats_block_t* get_block(void)
+{
+  if (thread_block)
+    return thread_block;
+
+  stats_block_t* block = calloc(1, sizeof(*block));
+
+  pthread_mutex_lock(&blocks_lock);
+
+  // past the limit, or without memory, threads share a block with RMW adds
+  if (block && block_count < STATS_MAX_THREADS) {
+    blocks[block_count++] = block;
+  }
+  else {
+    free(block);
+    block = &shared_block;
+  }
+
+  pthread_mutex_unlock(&blocks_lock);
+
+  thread_block = block;
+
+  return block;
+}
+
+static void add(counter_t* counter, uint64_t value)
+{
+  if (thread_block == &shared_block) {
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+    return;
+  }
+
+  // a single writer needs no read-modify-write
+  uint64_t current = atomic_load_explicit(counter, memory_order_relaxed);
+  atomic_store_explicit(counter, current + value, memory_order_relaxed);
+}
+
+static uint64_t load(counter_t* counter)
+{
+  return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+static int bucket_of(uint64_t elapsed_us)
+{
+  int bucket = elapsed_us ? 64 - __builtin_clzll(elapsed_us) : 0;
+
+  return bucket < STATS_LATENCY_BUCKETS ? bucket : STATS_LATENCY_BUCKETS - 1;
+}
+
+static void record_latency(histogram_t* histogram, uint64_t elapsed_us)
+{
+  add(&histogram->count, 1);
+  add(&histogram->total_us, elapsed_us);
+  add(&histogram->buckets[bucket_of(elapsed_us)], 1);
+
+  uint64_t max = load(&histogram->max_us);
+
+  while (elapsed_us > max) {
+    bool is_stored =
+      atomic_compare_exchange_weak_explicit(
+        &histogram->max_us,
+        &max,
+        elapsed_us,
+        memory_order_relaxed,
+        memory_order_relaxed
+      );
+
+    if (is_stored)
+      break;
+  }
+}
+
+static void merge_histogram(stats_histogram_t* out, histogram_t* histogram)
+{
+  out->count    += load(&histogram->count);
+  out->total_us += load(&histogram->total_us);
+
+  uint64_t max = load(&histogram->max_us);
+  if (max > out->max_us)
+    out->max_us = max;
+
+  for (int b = 0; b < STATS_LATENCY_BUCKETS; b++)
+    out->buckets[b] += load(&histogram->buckets[b]);
+}
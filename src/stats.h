@@ -0,0 +1,67 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <bacnet/basic/object/device.h>
+
+// log2 latency buckets in microseconds, the last one is open ended
+#ifndef STATS_LATENCY_BUCKETS
+#define STATS_LATENCY_BUCKETS 24
+#endif
+
+#ifndef STATS_MAX_THREADS
+#define STATS_MAX_THREADS 8
+#endif
+
+#define STATS_CALL_TYPES 64
+
+typedef enum {
+  STATS_SERVICE_READ_PROPERTY,
+  STATS_SERVICE_READ_PROPERTY_MULTIPLE,
+  STATS_SERVICE_WRITE_PROPERTY,
+  STATS_SERVICE_WRITE_PROPERTY_MULTIPLE,
+  STATS_SERVICE_SUBSCRIBE_COV,
+  STATS_SERVICE_WHO_IS,
+  STATS_SERVICE_WHO_HAS,
+  STATS_SERVICE_OTHER,
+  STATS_SERVICE_COUNT,
+} stats_service_t;
+
+typedef struct {
+  uint64_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  uint64_t buckets[STATS_LATENCY_BUCKETS];
+} stats_histogram_t;
+
+typedef struct {
+  uint64_t services[STATS_SERVICE_COUNT];
+  uint64_t calls[STATS_CALL_TYPES];
+  uint64_t calls_failed[STATS_CALL_TYPES];
+  uint64_t devices[MAX_NUM_DEVICES];
+
+  uint64_t command_timeouts;
+  uint64_t cov_notifications;
+
+  stats_histogram_t apdu_latency;
+  stats_histogram_t call_latency;
+  stats_histogram_t command_latency;
+} stats_snapshot_t;
+
+uint64_t stats_now_us(void);
+stats_service_t stats_service_of(uint8_t pdu_type, uint8_t service_choice);
+
+void stats_record_apdu(
+  stats_service_t service,
+  int device_index,
+  uint64_t elapsed_us);
+
+void stats_record_call(unsigned type, bool is_failed, uint64_t elapsed_us);
+void stats_record_command(uint64_t elapsed_us);
+void stats_record_command_timeout(void);
+void stats_record_cov_notification(void);
+void stats_collect(stats_snapshot_t* snapshot);
+uint64_t stats_bucket_limit_us(int bucket);
+
+#endif /* STATS_H */
@@ -0,0 +1,216 @@
+#include <pthread.h>
+#include <time.h>
+
+#include "log.h"
+#include "timer.h"
+
+typedef struct {
+  bool             active;
+  uint32_t         generation;
+  uint64_t         deadline;
+  uint32_t         interval;
+  timer_callback_t callback;
+  void*            arg;
+} timer_entry_t;
+
+static timer_entry_t   timers[MAX_TIMERS] = { 0 };
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static timer_clock_t   clock_override = NULL;
+
+static int add_timer(
+  uint32_t delay_ms,
+  uint32_t interval_ms,
+  timer_callback_t callback,
+  void* arg);
+
+/**
+ * @brief Replaces the clock timers are measured against.
+ *
+ * Lets a replay drive timers from captured timestamps rather than the wall
+ * clock. Must be set before any timer is scheduled.
+ *
+ * @param clock A function returning milliseconds, or NULL to restore the
+ *              monotonic clock.
+ */
+void timer_set_clock(timer_clock_t clock)
+{
+  clock_override = clock;
+}
+
+/**
+ * @brief Returns a monotonic timestamp in milliseconds.
+ */
+uint64_t timer_now_ms(void)
+{
+  if (clock_override)
+    return clock_override();
+
+  struct timespec now = { 0 };
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Schedules a one-shot callback on the event loop.
+ *
+ * The callback is invoked from the BACnet event loop thread once the delay
+ * has elapsed.
+ *
+ * @param delay_ms Milliseconds to wait before invoking the callback.
+ * @param callback The function to invoke.
+ * @param arg      An opaque pointer handed to the callback.
+ *
+ * @return Returns a timer id on success, or -1 if no timer slot is free.
+ */
+int timer_schedule(uint32_t delay_ms, timer_callback_t callback, void* arg)
+{
+  return add_timer(delay_ms, 0, callback, arg);
+}
+
+/**
+ * @brief Schedules a repeating callback on the event loop.
+ *
+ * @param interval_ms Milliseconds between each invocation.
+ * @param callback    The function to invoke.
+ * @param arg         An opaque pointer handed to the callback.
+ *
+ * @return Returns a timer id on success, or -1 if no timer slot is free.
+ */
+int timer_schedule_interval(
+  uint32_t interval_ms,
+  timer_callback_t callback,
+  void* arg
+) {
+  if (interval_ms == 0)
+    return -1;
+
+  return add_timer(interval_ms, interval_ms, callback, arg);
+}
+
+/**
+ * @brief Cancels a pending timer.
+ *
+ * Cancelling a timer that already fired, or an id of -1, is a no-op.
+ *
+ * @param timer_id The id returned when the timer was scheduled.
+ */
+void timer_cancel(int timer_id)
+{
+  if (timer_id < 0)
+    return;
+
+  int      slot       = timer_id % MAX_TIMERS;
+  uint32_t generation = (uint32_t)(timer_id / MAX_TIMERS);
+
+  pthread_mutex_lock(&timer_lock);
+
+  timer_entry_t* timer = &timers[slot];
+  if (timer->active && timer->generation == generation)
+    timer->active = false;
+
+  pthread_mutex_unlock(&timer_lock);
+}
+
+/**
+ * @brief Computes how long the event loop may block waiting for traffic.
+ *
+ * @param max_ms The upper bound when no timer is due sooner.
+ *
+ * @return Milliseconds until the next timer expires, capped at max_ms.
+ */
+uint32_t timer_next_timeout_ms(uint32_t max_ms)
+{
+  uint64_t now     = timer_now_ms();
+  uint32_t timeout = max_ms;
+
+  pthread_mutex_lock(&timer_lock);
+
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    timer_entry_t* timer = &timers[i];
+    if (!timer->active)
+      continue;
+
+    if (timer->deadline <= now) {
+      timeout = 0;
+      break;
+    }
+
+    if (timer->deadline - now < timeout)
+      timeout = (uint32_t)(timer->deadline - now);
+  }
+
+  pthread_mutex_unlock(&timer_lock);
+
+  return timeout;
+}
+
+/**
+ * @brief Invokes every timer whose deadline has passed.
+ *
+ * Must be called from the event loop. Callbacks run without the timer lock
+ * held, so they are free to schedule or cancel timers.
+ */
+void timer_run_expired(void)
+{
+  uint64_t now = timer_now_ms();
+
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    pthread_mutex_lock(&timer_lock);
+
+    timer_entry_t* timer = &timers[i];
+    if (!timer->active || timer->deadline > now) {
+      pthread_mutex_unlock(&timer_lock);
+      continue;
+    }
+
+    timer_callback_t callback = timer->callback;
+    void*            arg      = timer->arg;
+
+    if (timer->interval > 0)
+      timer->deadline = now + timer->interval;
+    else
+      timer->active = false;
+
+    pthread_mutex_unlock(&timer_lock);
+
+    callback(arg);
+  }
+}
+
+static int add_timer(
+  uint32_t delay_ms,
+  uint32_t interval_ms,
+  timer_callback_t callback,
+  void* arg
+) {
+  if (callback == NULL)
+    return -1;
+
+  int timer_id = -1;
+
+  pthread_mutex_lock(&timer_lock);
+
+  for (int i = 0; i < MAX_TIMERS; i++) {
+    timer_entry_t* timer = &timers[i];
+    if (timer->active)
+      continue;
+
+    timer->active     = true;
+    timer->generation = (timer->generation + 1) % (INT32_MAX / MAX_TIMERS);
+    timer->deadline   = timer_now_ms() + delay_ms;
+    timer->interval   = interval_ms;
+    timer->callback   = callback;
+    timer->arg        = arg;
+
+    timer_id = (int)(timer->generation * MAX_TIMERS) + i;
+    break;
+  }
+
+  pthread_mutex_unlock(&timer_lock);
+
+  if (timer_id == -1)
+    LOG_WARNING("bacnetd: no free timer slots");
+
+  return timer_id;
+}
@@ -0,0 +1,25 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef MAX_TIMERS
+#define MAX_TIMERS 64
+#endif
+
+typedef void (*timer_callback_t)(void* arg);
+typedef uint64_t (*timer_clock_t)(void);
+
+void timer_set_clock(timer_clock_t clock);
+uint64_t timer_now_ms(void);
+int timer_schedule(uint32_t delay_ms, timer_callback_t callback, void* arg);
+int timer_schedule_interval(
+  uint32_t interval_ms,
+  timer_callback_t callback,
+  void* arg);
+void timer_cancel(int timer_id);
+uint32_t timer_next_timeout_ms(uint32_t max_ms);
+void timer_run_expired(void);
+
+#endif /* TIMER_H */
@@ -0,0 +1,274 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log.h"
+#include "protocol/event.h"
+#include "stats.h"
+#include "watchdog.h"
+
+// the stage is packed with its start time so both are read together
+#define STAGE_BITS 4
+#define STAGE_MASK ((1 << STAGE_BITS) - 1)
+
+static atomic_uint_fast64_t current_state = WATCHDOG_STAGE_IDLE;
+static atomic_uint          current_budget_ms = 0;
+static _Thread_local bool   is_watched = false;
+
+static flight_record_t annotation = { 0 };
+static flight_record_t ring[FLIGHT_RECORDER_SIZE] = { 0 };
+static size_t          record_count = 0;
+static size_t          record_next = 0;
+static pthread_mutex_t records_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t   watchdog_thread_id;
+static atomic_bool should_stop = false;
+static atomic_bool is_running = false;
+static uint32_t    stall_ms = WATCHDOG_STALL_MS;
+
+static void* watchdog_loop(void* arg);
+static void record(flight_record_t* entry);
+
+/**
+ * @brief Starts the thread that watches the event loop for stalls.
+ *
+ * The stall threshold may be set with `BACNET_STALL_MS`.
+ *
+ * @return Returns 0 on success, or -1 if the thread cannot be created.
+ */
+int watchdog_start(void)
+{
+  const char* stall_raw = getenv("BACNET_STALL_MS");
+  if (stall_raw)
+    stall_ms = (uint32_t)strtoul(stall_raw, NULL, 0);
+
+  if (stall_ms == 0)
+    stall_ms = WATCHDOG_STALL_MS;
+
+  atomic_store(&should_stop, false);
+
+  if (pthread_create(&watchdog_thread_id, NULL, &watchdog_loop, NULL) != 0)
+    return -1;
+
+  atomic_store(&is_running, true);
+
+  return 0;
+}
+
+/**
+ * @brief Stops the watchdog thread.
+ */
+void watchdog_stop(void)
+{
+  if (!atomic_load(&is_running))
+    return;
+
+  atomic_store(&should_stop, true);
+  pthread_join(watchdog_thread_id, NULL);
+
+  atomic_store(&is_running, false);
+}
+
+/**
+ * @brief Marks the calling thread as the one whose stages are watched.
+ *
+ * Stage changes made by any other thread are ignored, so shared code such as
+ * port_send can mark its stage unconditionally.
+ */
+void watchdog_watch_thread(void)
+{
+  is_watched = true;
+}
+
+/**
+ * @brief Marks the start of an event loop stage.
+ *
+ * @param stage     The stage being entered.
+ * @param budget_ms The time the stage is expected to take, such as the
+ *                  receive timeout. The stall threshold is added to it.
+ *
+ * @return Returns a mark to pass to watchdog_leave, which restores the stage
+ *         that was interrupted.
+ */
+watchdog_mark_t watchdog_enter(watchdog_stage_t stage, uint32_t budget_ms)
+{
+  watchdog_mark_t previous = { 0 };
+
+  if (!is_watched)
+    return previous;
+
+  previous.state     = atomic_load(&current_state);
+  previous.budget_ms = atomic_load(&current_budget_ms);
+
+  uint64_t state = (stats_now_us() << STAGE_BITS) | stage;
+
+  atomic_store(&current_budget_ms, budget_ms);
+  atomic_store(&current_state, state);
+
+  if (stage == WATCHDOG_STAGE_DISPATCH)
+    memset(&annotation, 0, sizeof(annotation));
+
+  return previous;
+}
+
+/**
+ * @brief Describes the packet being dispatched, for the flight recorder.
+ *
+ * @param pdu_type       The APDU type of the packet.
+ * @param service_choice The service choice of the packet.
+ * @param len            The length of the packet.
+ */
+void watchdog_annotate(uint8_t pdu_type, uint8_t service_choice, uint16_t len)
+{
+  if (!is_watched)
+    return;
+
+  annotation.pdu_type       = pdu_type;
+  annotation.service_choice = service_choice;
+  annotation.pdu_len        = len;
+}
+
+/**
+ * @brief Marks the end of the current stage.
+ *
+ * Dispatches and port sends are always kept in the flight recorder. The
+ * receive and timer stages are kept only when they overran.
+ *
+ * @param previous The mark returned when the stage was entered.
+ */
+void watchdog_leave(watchdog_mark_t previous)
+{
+  if (!is_watched)
+    return;
+
+  uint64_t now       = stats_now_us();
+  uint64_t state     = atomic_load(&current_state);
+  uint32_t budget_ms = atomic_load(&current_budget_ms);
+
+  watchdog_stage_t stage      = state & STAGE_MASK;
+  uint64_t         started_us = state >> STAGE_BITS;
+  uint64_t         elapsed_us = now - started_us;
+
+  bool is_overrun =
+    elapsed_us > ((uint64_t)budget_ms + stall_ms) * 1000;
+
+  bool is_recorded =
+       stage == WATCHDOG_STAGE_DISPATCH
+    || stage == WATCHDOG_STAGE_PORT_SEND
+    || is_overrun;
+
+  if (is_recorded) {
+    flight_record_t entry = { 0 };
+
+    if (stage == WATCHDOG_STAGE_DISPATCH)
+      memcpy(&entry, &annotation, sizeof(entry));
+
+    entry.started_us  = started_us;
+    entry.duration_us = elapsed_us > UINT32_MAX ? UINT32_MAX : elapsed_us;
+    entry.stage       = stage;
+
+    record(&entry);
+  }
+
+  atomic_store(&current_budget_ms, previous.budget_ms);
+  atomic_store(&current_state, previous.state);
+}
+
+/**
+ * @brief Returns the name of a stage, as reported in stall events.
+ */
+const char* watchdog_stage_name(watchdog_stage_t stage)
+{
+  switch (stage) {
+    case WATCHDOG_STAGE_IDLE:      return "idle";
+    case WATCHDOG_STAGE_RECEIVE:   return "receive";
+    case WATCHDOG_STAGE_TIMERS:    return "timers";
+    case WATCHDOG_STAGE_DISPATCH:  return "dispatch";
+    case WATCHDOG_STAGE_PORT_SEND: return "port_send";
+    default:                       return "unknown";
+  }
+}
+
+/**
+ * @brief Copies the flight recorder, oldest entry first.
+ *
+ * @param records     A pointer to where the entries will be stored.
+ * @param max_records The maximum number of entries to store.
+ *
+ * @return Returns the number of entries stored, the most recent ones if
+ *         there are more than `max_records`.
+ */
+size_t flight_recorder_copy(flight_record_t* records, size_t max_records)
+{
+  pthread_mutex_lock(&records_lock);
+
+  size_t count = record_count < max_records ? record_count : max_records;
+  size_t first = record_next + FLIGHT_RECORDER_SIZE - count;
+
+  for (size_t i = 0; i < count; i++)
+    records[i] = ring[(first + i) % FLIGHT_RECORDER_SIZE];
+
+  pthread_mutex_unlock(&records_lock);
+
+  return count;
+}
+
+static void record(flight_record_t* entry)
+{
+  pthread_mutex_lock(&records_lock);
+
+  ring[record_next] = *entry;
+  record_next = (record_next + 1) % FLIGHT_RECORDER_SIZE;
+
+  if (record_count < FLIGHT_RECORDER_SIZE)
+    record_count++;
+
+  pthread_mutex_unlock(&records_lock);
+}
+
+static void report_stall(watchdog_stage_t stage, uint64_t elapsed_us)
+{
+  uint32_t elapsed_ms = (uint32_t)(elapsed_us / 1000);
+  const char* name    = watchdog_stage_name(stage);
+
+  LOG_WARNING("bacnetd: event loop stalled in %s for %u ms", name, elapsed_ms);
+
+  // the event loop holds the port while stalled in port_send
+  if (stage != WATCHDOG_STAGE_PORT_SEND)
+    send_stall(name, elapsed_ms);
+}
+
+static void* watchdog_loop(void* arg)
+{
+  uint64_t reported_state = 0;
+
+  uint32_t period_ms = stall_ms / 4 ? stall_ms / 4 : 1;
+  struct timespec period = {
+    .tv_sec  = period_ms / 1000,
+    .tv_nsec = (long)(period_ms % 1000) * 1000000,
+  };
+
+  while (!atomic_load(&should_stop)) {
+    nanosleep(&period, NULL);
+
+    uint64_t state     = atomic_load(&current_state);
+    uint32_t budget_ms = atomic_load(&current_budget_ms);
+
+    watchdog_stage_t stage = state & STAGE_MASK;
+
+    // each stage entry is reported at most once
+    if (stage == WATCHDOG_STAGE_IDLE || state == reported_state)
+      continue;
+
+    uint64_t elapsed_us = stats_now_us() - (state >> STAGE_BITS);
+
+    if (elapsed_us > ((uint64_t)budget_ms + stall_ms) * 1000) {
+      reported_state = state;
+      report_stall(stage, elapsed_us);
+    }
+  }
+
+  pthread_exit(NULL);
+}
@@ -0,0 +1,51 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// time a stage may run past its budget before it is reported as a stall
+#ifndef WATCHDOG_STALL_MS
+#define WATCHDOG_STALL_MS 250
+#endif
+
+#ifndef FLIGHT_RECORDER_SIZE
+#define FLIGHT_RECORDER_SIZE 256
+#endif
+
+typedef enum {
+  WATCHDOG_STAGE_IDLE,
+  WATCHDOG_STAGE_RECEIVE,
+  WATCHDOG_STAGE_TIMERS,
+  WATCHDOG_STAGE_DISPATCH,
+  WATCHDOG_STAGE_PORT_SEND,
+  WATCHDOG_STAGE_COUNT,
+} watchdog_stage_t;
+
+typedef struct {
+  uint64_t state;
+  uint32_t budget_ms;
+} watchdog_mark_t;
+
+typedef struct {
+  uint64_t started_us;
+  uint32_t duration_us;
+  uint8_t  stage;
+  uint8_t  pdu_type;
+  uint8_t  service_choice;
+  uint16_t pdu_len;
+} flight_record_t;
+
+int watchdog_start(void);
+void watchdog_stop(void);
+void watchdog_watch_thread(void);
+
+watchdog_mark_t watchdog_enter(watchdog_stage_t stage, uint32_t budget_ms);
+void watchdog_annotate(uint8_t pdu_type, uint8_t service_choice, uint16_t len);
+void watchdog_leave(watchdog_mark_t previous);
+
+const char* watchdog_stage_name(watchdog_stage_t stage);
+size_t flight_recorder_copy(flight_record_t* records, size_t max_records);
+
+#endif /* WATCHDOG_H */